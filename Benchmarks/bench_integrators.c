@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "../DroneDynamics/DroneController.h"
+#include "../ObstaclesGenerator/ObstaclesGenerator.h"
+#include "../common.h"
+
+/* bench_integrators.c - Drone integrators: accuracy vs cost per step
+   Usage: ./bench_integrators [ms_per_case]
+
+   Three scenarios, each flown with every integrator at step sizes from 4*DT
+   down to DT/4 (one substep per step), and once with RK4 at REFERENCE_H as
+   the reference trajectory:
+     - thrust: constant thrust against drag, nothing else (open space in the
+               live game, where the force only changes between frames). The
+               exact-drag step has no error here beyond rounding.
+     - spring: a spring pulling the drone towards the map centre, with the
+               usual drag. Smooth and with a known energy (kinetic + spring),
+               so the energy error is reported as well.
+     - course: constant thrust through OBSTACLES obstacles and the borders, with
+               the real repulsion. The forces are capped and cut off at
+               INFLUENCE_RANGE, so no method reaches its nominal order here.
+   The error is the largest distance from the reference over samples taken every
+   SAMPLE_S. The cost is the time per step (force evaluations included) and the
+   CPU time per simulated second. The summary gives, for each integrator, the
+   largest step that stays within the tolerance and what it costs.
+*/
+
+#define REFERENCE_H 1e-4
+#define SAMPLE_S 0.2
+#define SPRING_K 4.0
+#define SPRING_SECONDS 20.0
+#define THRUST_SECONDS 10.0
+#define COURSE_SECONDS 10.0
+#define OBSTACLES 40
+#define THRUST_TOLERANCE 0.01 // Map units
+#define SPRING_TOLERANCE 0.01
+#define COURSE_TOLERANCE 0.1
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// SCENARIOS
+static void spring_field(const DroneState *s, void *ctx, double *fx, double *fy)
+{
+    (void)ctx;
+    *fx = -SPRING_K * (s->x - MAP_WIDTH / 2.0);
+    *fy = -SPRING_K * (s->y - MAP_HEIGHT / 2.0);
+}
+
+static double spring_energy(const DroneState *s)
+{
+    double dx = s->x - MAP_WIDTH / 2.0, dy = s->y - MAP_HEIGHT / 2.0;
+    return 0.5 * MASS * (s->vx * s->vx + s->vy * s->vy) + 0.5 * SPRING_K * (dx * dx + dy * dy);
+}
+
+typedef struct {
+    double thrust_x, thrust_y;
+    const WorldState *world; // NULL = open space
+} Course;
+
+static void thrust_field(const DroneState *s, void *ctx, double *fx, double *fy)
+{
+    (void)s;
+    const Course *course = ctx;
+    *fx = course->thrust_x;
+    *fy = course->thrust_y;
+}
+
+static void course_field(const DroneState *s, void *ctx, double *fx, double *fy)
+{
+    const Course *course = ctx;
+    DroneState probe = *s;
+    probe.force_x = course->thrust_x;
+    probe.force_y = course->thrust_y;
+    apply_repulsive_forces_grid(&probe, course->world->obstacles, course->world->n_obstacles,
+                                course->world->grid.head, course->world->grid.links);
+    apply_border_forces(&probe);
+    *fx = probe.force_x;
+    *fy = probe.force_y;
+}
+
+typedef struct {
+    const char *name;
+    ForceField field;
+    void *ctx;
+    DroneState start;
+    double seconds;
+    double tolerance;
+    int has_energy;
+} Scenario;
+
+// Flies the scenario with steps of 'h'; one state per SAMPLE_S goes to 'samples'
+static void fly(const Scenario *sc, const Integrator *integrator, double h, DroneState *samples)
+{
+    long per_sample = lround(SAMPLE_S / h);
+    long n_samples = lround(sc->seconds / SAMPLE_S);
+    DroneState d = sc->start;
+    samples[0] = d;
+    for (long k = 1; k <= n_samples; k++)
+    {
+        for (long i = 0; i < per_sample; i++) integrate(&d, h, integrator, sc->field, sc->ctx);
+        samples[k] = d;
+    }
+}
+
+typedef struct {
+    int kind;
+    double h;
+    double error;        // Largest distance from the reference
+    double energy_error; // Largest energy difference, relative to the start energy
+    double ns_per_step;
+} Result;
+
+int main(int argc, char *argv[])
+{
+    double case_ns = ((argc > 1) ? atoi(argv[1]) : 100) * 1e6;
+    static const double steps[] = { 4 * DT, 2 * DT, DT, DT / 2, DT / 4 };
+    int n_steps = sizeof(steps) / sizeof(steps[0]);
+
+    // The course: obstacles scattered by a fixed stream, none on the start
+    WorldState world;
+    if (world_alloc(&world, OBSTACLES, 0, 0) == -1) { perror("world_alloc"); return 1; }
+    Obstacle obstacles[OBSTACLES];
+    Rng rng;
+    rng_seed(&rng, 1, RNG_STREAM_OBSTACLES);
+    for (int i = 0; i < OBSTACLES; i++)
+    {
+        do
+        {
+            obstacles[i].x = BORDER_MARGIN_SPAWN + (int)rng_below(&rng, MAP_WIDTH - 2 * BORDER_MARGIN_SPAWN);
+            obstacles[i].y = BORDER_MARGIN_SPAWN + (int)rng_below(&rng, MAP_HEIGHT - 2 * BORDER_MARGIN_SPAWN);
+        } while (abs(obstacles[i].x - 10) + abs(obstacles[i].y - 10) < 4);
+        obstacles[i].active = 1;
+        obstacles[i].timer = OBSTACLE_LIFETIME;
+    }
+    world_set_obstacles(&world, obstacles, OBSTACLES);
+    Course course = { 0.6 * THRUST_MULTIPLIER, 0.25 * THRUST_MULTIPLIER, &world };
+    Course open = { 0.6 * THRUST_MULTIPLIER, 0.25 * THRUST_MULTIPLIER, NULL };
+
+    Scenario scenarios[] = {
+        { "thrust", thrust_field, &open, { 10.0, 10.0, 0.0, 0.0, 0, 0 },
+          THRUST_SECONDS, THRUST_TOLERANCE, 0 },
+        { "spring", spring_field, NULL, { MAP_WIDTH / 2.0 + 8.0, MAP_HEIGHT / 2.0, 0.0, 6.0, 0, 0 },
+          SPRING_SECONDS, SPRING_TOLERANCE, 1 },
+        { "course", course_field, &course, { 10.0, 10.0, 0.0, 0.0, 0, 0 },
+          COURSE_SECONDS, COURSE_TOLERANCE, 0 },
+    };
+
+    printf("Integrator benchmark: MASS %d, DRAG_COEF %.2f, live frame DT %.3f s, reference RK4 h=%g, %.0f ms per case\n",
+           MASS, DRAG_COEF, DT, REFERENCE_H, case_ns / 1e6);
+
+    for (int c = 0; c < (int)(sizeof(scenarios) / sizeof(scenarios[0])); c++)
+    {
+        const Scenario *sc = &scenarios[c];
+        long n_samples = lround(sc->seconds / SAMPLE_S);
+        DroneState *reference = calloc(n_samples + 1, sizeof(DroneState));
+        DroneState *samples = calloc(n_samples + 1, sizeof(DroneState));
+        if (reference == NULL || samples == NULL) { perror("calloc"); return 1; }
+        Integrator ref = { INTEGRATOR_RK4, 1, DRAG_COEF };
+        fly(sc, &ref, REFERENCE_H, reference);
+        double e0 = sc->has_energy ? spring_energy(&sc->start) : 0;
+
+        printf("\n%s (%.0f s simulated, tolerance %.2f units)\n", sc->name, sc->seconds, sc->tolerance);
+        printf("%-7s %7s %6s  %12s  %12s  %10s  %14s  %14s\n", "method", "h [s]", "evals",
+               "max |dx|", "max |dE|/E0", "ns/step", "us/sim second", "ns/live frame");
+
+        Result results[INTEGRATOR_COUNT][8];
+        for (int k = 0; k < INTEGRATOR_COUNT; k++)
+        {
+            Integrator integrator = { k, 1, DRAG_COEF };
+            for (int s = 0; s < n_steps; s++)
+            {
+                Result *r = &results[k][s];
+                r->kind = k;
+                r->h = steps[s];
+                fly(sc, &integrator, r->h, samples);
+                r->error = 0;
+                r->energy_error = 0;
+                for (long i = 0; i <= n_samples; i++)
+                {
+                    double d = hypot(samples[i].x - reference[i].x, samples[i].y - reference[i].y);
+                    if (d > r->error) r->error = d;
+                    if (sc->has_energy)
+                    {
+                        double de = fabs(spring_energy(&samples[i]) - spring_energy(&reference[i])) / e0;
+                        if (de > r->energy_error) r->energy_error = de;
+                    }
+                }
+
+                // Cost: the same flight again and again
+                long flights = 0;
+                double start = now_ns(), elapsed;
+                do
+                {
+                    fly(sc, &integrator, r->h, samples);
+                    flights++;
+                    elapsed = now_ns() - start;
+                } while (elapsed < case_ns);
+                r->ns_per_step = elapsed / (flights * n_samples * lround(SAMPLE_S / r->h));
+
+                char energy[16] = "-";
+                if (sc->has_energy) snprintf(energy, sizeof(energy), "%.2e", r->energy_error);
+                printf("%-7s %7.4f %6d  %12.2e  %12s  %10.1f  %14.1f  %14.1f\n", integrator_name(k), r->h,
+                       integrator_evaluations(k, 1), r->error, energy, r->ns_per_step,
+                       r->ns_per_step / r->h / 1e3, r->ns_per_step * DT / r->h);
+            }
+        }
+
+        // Largest step within the tolerance (errors shrink with the step, so the first one that passes)
+        printf("within %.2f units:", sc->tolerance);
+        for (int k = 0; k < INTEGRATOR_COUNT; k++)
+        {
+            int s = 0;
+            while (s < n_steps && results[k][s].error > sc->tolerance) s++;
+            if (s == n_steps) printf("  %s: none", integrator_name(k));
+            else printf("  %s: h=%.4f (%.1f us/sim s)", integrator_name(k), results[k][s].h,
+                        results[k][s].ns_per_step / results[k][s].h / 1e3);
+        }
+        printf("\n");
+        free(reference);
+        free(samples);
+    }
+    world_free(&world);
+    return 0;
+}
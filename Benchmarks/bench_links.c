@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include "../common.h"
+
+/* bench_links.c - Framed link cost: FIFO between processes vs in-process SPSC ring
+   Usage: ./bench_links [latency_frames]
+
+   For the frame sizes the simulator actually sends (an input, a drone state,
+   obstacle sets and an agent batch) a producer sends frames to a consumer that
+   waits in epoll and drains with frame_fill()/frame_next(), like the server.
+     - fifo: producer is a forked process writing a named pipe (multi-process mode)
+     - ring: producer is a thread writing a link_register() ring (threaded mode)
+   Latency: frames are paced (one every PACE_US) and the one-way delay is taken
+   from the header timestamp, p50 / p99. Throughput: the producer sends flat out.
+*/
+
+#define PACE_US 200
+#define THROUGHPUT_BYTES (256u << 20) // Payload bytes sent per throughput case
+#define MAX_THROUGHPUT_FRAMES 200000
+
+typedef struct {
+    const char *name;
+    size_t payload;
+} FrameCase;
+
+typedef struct {
+    const char *path;
+    size_t payload;
+    int frames;
+    int paced;
+} Producer;
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void produce(const Producer *p)
+{
+    int fd = link_open(p->path, O_WRONLY);
+    if (fd == -1) { perror("producer open"); return; }
+    FrameWriter writer;
+    frame_writer_init(&writer, fd);
+    unsigned char *payload = calloc(1, p->payload);
+    for (int i = 0; i < p->frames; i++)
+    {
+        if (frame_send(&writer, MSG_AGENTS, payload, (uint32_t)p->payload) == -1) break;
+        if (p->paced) usleep(PACE_US);
+    }
+    free(payload);
+    link_close(fd);
+}
+
+static void *producer_thread(void *arg)
+{
+    produce(arg);
+    return NULL;
+}
+
+// Receives 'frames' frames; fills 'latency_ns' (if given) and returns the elapsed seconds
+static double consume(int fd, size_t payload, int frames, uint64_t *latency_ns)
+{
+    FrameReader reader;
+    if (frame_reader_init(&reader, fd, frame_buffer_size(payload)) == -1) return -1.0;
+    int ep = epoll_create1(0);
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = fd };
+    epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+
+    int got = 0;
+    uint64_t start = 0;
+    while (got < frames)
+    {
+        struct epoll_event out;
+        if (epoll_wait(ep, &out, 1, 2000) <= 0) break; // Producer died
+        ssize_t n;
+        do
+        {
+            n = frame_fill(&reader);
+            FrameHeader hdr;
+            const void *data;
+            while (frame_next(&reader, &hdr, &data))
+            {
+                uint64_t now = monotonic_ns();
+                if (got == 0) start = hdr.timestamp_ns;
+                if (latency_ns) latency_ns[got] = now - hdr.timestamp_ns;
+                got++;
+            }
+        } while (n > 0);
+        if (n == 0) break; // EOF
+    }
+    double elapsed = (monotonic_ns() - start) / 1e9;
+    close(ep);
+    frame_reader_free(&reader);
+    return (got == frames) ? elapsed : -1.0;
+}
+
+// One run: returns the elapsed seconds, or -1 on failure
+static double run_link(int use_ring, const char *path, size_t payload, int frames, int paced, uint64_t *latency_ns)
+{
+    Producer p = { path, payload, frames, paced };
+    double elapsed;
+    if (use_ring)
+    {
+        int fd = link_open(path, O_RDONLY);
+        pthread_t thread;
+        pthread_create(&thread, NULL, producer_thread, &p);
+        elapsed = consume(fd, payload, frames, latency_ns);
+        link_close(fd);
+        pthread_join(thread, NULL);
+    }
+    else
+    {
+        unlink(path);
+        mkfifo(path, 0666);
+        int fd = open(path, O_RDONLY | O_NONBLOCK);
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            produce(&p);
+            _exit(0);
+        }
+        elapsed = consume(fd, payload, frames, latency_ns);
+        close(fd);
+        waitpid(pid, NULL, 0);
+        unlink(path);
+    }
+    return elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    int latency_frames = (argc > 1) ? atoi(argv[1]) : 2000;
+    if (latency_frames < 10) latency_frames = 10;
+    signal(SIGPIPE, SIG_IGN);
+
+    static const FrameCase cases[] = {
+        { "input", sizeof(InputMsg) },
+        { "drone", sizeof(DroneState) },
+        { "10 obst", 10 * sizeof(Obstacle) },
+        { "1k obst", 1000 * sizeof(Obstacle) },
+        { "10k agents", 10000 * sizeof(DroneState) },
+    };
+    int n_cases = sizeof(cases) / sizeof(cases[0]);
+    uint64_t *latency = calloc(latency_frames, sizeof(uint64_t));
+
+    printf("Link benchmark: %d paced frames (every %d us) for latency, up to %u MB flat out for throughput\n",
+           latency_frames, PACE_US, THROUGHPUT_BYTES >> 20);
+    printf("%-11s %8s  %5s  %9s  %9s  %12s  %10s\n", "frame", "bytes", "link", "p50 us", "p99 us", "frames/s", "MB/s");
+
+    for (int c = 0; c < n_cases; c++)
+    {
+        size_t payload = cases[c].payload;
+        int frames = (int)(THROUGHPUT_BYTES / (payload + sizeof(FrameHeader)));
+        if (frames > MAX_THROUGHPUT_FRAMES) frames = MAX_THROUGHPUT_FRAMES;
+
+        char ring_path[64];
+        snprintf(ring_path, sizeof(ring_path), "/tmp/bench_ring_%d", c);
+        if (link_register(ring_path, frame_buffer_size(payload)) == -1) { perror("link_register"); return 1; }
+
+        for (int use_ring = 0; use_ring <= 1; use_ring++)
+        {
+            const char *path = use_ring ? ring_path : "/tmp/bench_links_fifo";
+            double paced = run_link(use_ring, path, payload, latency_frames, 1, latency);
+            double flat = run_link(use_ring, path, payload, frames, 0, NULL);
+            if (paced < 0 || flat < 0) { printf("%-11s %8zu  %5s  failed\n", cases[c].name, payload, use_ring ? "ring" : "fifo"); continue; }
+
+            qsort(latency, latency_frames, sizeof(uint64_t), cmp_u64);
+            printf("%-11s %8zu  %5s  %9.1f  %9.1f  %12.0f  %10.1f\n", cases[c].name, payload, use_ring ? "ring" : "fifo",
+                   latency[latency_frames / 2] / 1e3, latency[latency_frames * 99 / 100] / 1e3,
+                   frames / flat, frames * (payload + sizeof(FrameHeader)) / flat / 1e6);
+            fflush(stdout);
+        }
+    }
+    free(latency);
+    return 0;
+}
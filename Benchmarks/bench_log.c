@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
+#include "../common.h"
+
+/* bench_log.c - Caller-side cost of log_msg()
+   Usage: ./bench_log [messages per thread]
+
+   'sync' is the previous logger (fopen + ctime + fprintf + fclose per message), kept
+   here as the reference. 'async' is log_msg(): the caller only formats into the
+   ring. Callers log in bursts of BURST messages followed by a BURST_GAP_US pause,
+   roughly what a busy tick looks like; every message is distinct so nothing is
+   coalesced. Per-call latency p50 / p99 / max and mean ns, and how many lines
+   reached the file. Runs in a scratch directory.
+*/
+
+#define BURST 64
+#define BURST_GAP_US 2000
+#define MAX_THREADS 4
+
+typedef struct {
+    int messages;
+    int sync;
+    int id;
+    uint64_t *lat;
+} Worker;
+
+// The logger this replaced
+static void log_msg_sync(const char *process_name, const char *format, ...)
+{
+    FILE *f = fopen("simulation.log", "a");
+    if (f == NULL) return;
+    time_t now = time(NULL);
+    char *date = ctime(&now);
+    date[strlen(date) - 1] = '\0';
+    fprintf(f, "[%s] [%s] ", date, process_name);
+    va_list args;
+    va_start(args, format);
+    vfprintf(f, format, args);
+    va_end(args);
+    fprintf(f, "\n");
+    fclose(f);
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void *worker(void *arg)
+{
+    Worker *w = arg;
+    for (int i = 0; i < w->messages; i++)
+    {
+        uint64_t t0 = monotonic_ns();
+        if (w->sync) log_msg_sync("BENCH", "Thread %d tick %d: pos=(%.2f, %.2f) score=%d", w->id, i, i * 0.5, i * 0.25, i);
+        else log_msg("BENCH", "Thread %d tick %d: pos=(%.2f, %.2f) score=%d", w->id, i, i * 0.5, i * 0.25, i);
+        w->lat[i] = monotonic_ns() - t0;
+        if (i % BURST == BURST - 1) usleep(BURST_GAP_US);
+    }
+    return NULL;
+}
+
+static long count_lines(void)
+{
+    FILE *f = fopen("simulation.log", "r");
+    if (f == NULL) return 0;
+    long lines = 0;
+    int ch;
+    while ((ch = getc(f)) != EOF) lines += (ch == '\n');
+    fclose(f);
+    return lines;
+}
+
+static void run(const char *name, int sync, int threads, int messages)
+{
+    unlink("simulation.log");
+    Worker workers[MAX_THREADS];
+    pthread_t tid[MAX_THREADS];
+    uint64_t *lat = malloc(sizeof(uint64_t) * messages * threads);
+    for (int t = 0; t < threads; t++)
+    {
+        workers[t] = (Worker){ messages, sync, t, lat + (size_t)t * messages };
+        pthread_create(&tid[t], NULL, worker, &workers[t]);
+    }
+    for (int t = 0; t < threads; t++) pthread_join(tid[t], NULL);
+    if (!sync) log_flush();
+
+    int n = messages * threads;
+    double mean = 0.0;
+    for (int i = 0; i < n; i++) mean += lat[i];
+    mean /= n;
+    qsort(lat, n, sizeof(uint64_t), cmp_u64);
+    printf("%-6s %7d %9llu  %9llu  %9llu  %9.0f  %7ld/%d\n", name, threads,
+           (unsigned long long)lat[n / 2], (unsigned long long)lat[(n * 99) / 100],
+           (unsigned long long)lat[n - 1], mean, count_lines(), n);
+    fflush(stdout);
+    free(lat);
+}
+
+int main(int argc, char *argv[])
+{
+    int messages = (argc > 1) ? atoi(argv[1]) : 20000;
+    if (messages < BURST) messages = BURST;
+
+    char repo[PATH_MAX];
+    if (getcwd(repo, sizeof(repo)) == NULL) { perror("getcwd"); return 1; }
+    char scratch[] = "/tmp/log_bench_XXXXXX";
+    if (mkdtemp(scratch) == NULL || chdir(scratch) == -1) { perror("scratch dir"); return 1; }
+
+    printf("Logger benchmark: %d messages per thread in bursts of %d every %d us\n", messages, BURST, BURST_GAP_US);
+    printf("%-6s %7s %9s  %9s  %9s  %9s  %s\n", "logger", "threads", "p50 ns", "p99 ns", "max ns", "mean ns", "lines");
+    run("sync", 1, 1, messages);
+    run("async", 0, 1, messages);
+    run("sync", 1, MAX_THREADS, messages);
+    run("async", 0, MAX_THREADS, messages);
+
+    unlink("simulation.log");
+    if (chdir(repo) == -1 || rmdir(scratch) == -1) fprintf(stderr, "Left %s behind\n", scratch);
+    return 0;
+}
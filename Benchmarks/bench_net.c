@@ -0,0 +1,322 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "../common.h"
+
+/* bench_net.c - Two Network Processes on loopback: updates/s, latency and CPU per update
+   Usage: ./bench_net [seconds] [rates_hz...]   (from the directory holding network_process)
+
+   For every protocol the Network Process speaks (text; binary and snapshot, each
+   over TCP and UDP) and every send rate, starts ./network_process in the server
+   role and in the client role on 127.0.0.1 and plays both Blackboards on the
+   _server and _client FIFOs: each side gets a drone state every 1/rate s, and
+   the obstacle frames each side sends back are drained. Every state puts the
+   drone on the next cell of the map, so the cell in the other side's obstacle
+   frame tells which state got there. For 'seconds' it records:
+     - delivered: states per second that reached the other Blackboard, per
+       direction. A newer state replaces one still in flight, so past what the
+       link carries this stays flat and the rest show up as skipped
+     - latency: Blackboard -> Blackboard delay of every delivered state, FIFOs
+       included, p50 / p99 / max over both directions
+     - CPU: run time of both Network Processes (every thread, from schedstat)
+       per delivered state
+   The text exchange (drone/dok/obst/pok) carries one state each way per round
+   and starts a round every SYNC_RATE_US, which caps it. The bench shares the
+   CPU with both processes. Do not run it next to a networked game: it uses the
+   same FIFO paths.
+*/
+
+#define BENCH_PORT 5760
+#define SETUP_TIMEOUT_MS 5000
+#define EXIT_TIMEOUT_MS 2000
+#define GRACE_MS 100 // After the last state: time for the ones in flight to land
+#define CELLS_X (MAP_WIDTH - 2)
+#define CELLS ((MAP_WIDTH - 2) * (MAP_HEIGHT - 2)) // Distinct states before the cells repeat
+
+typedef struct {
+    const char *protocol;
+    const char *transport;
+} NetMode;
+
+typedef struct {
+    const char *suffix;
+    const char *role;
+    pid_t pid;
+    int tx_fd, rx_fd;
+    FrameWriter writer;
+    FrameReader reader;
+    long sent;
+    uint64_t sent_ns[CELLS];  // By cell: when the newest state on it went out
+    int last_cell;            // Newest cell the other side's drone showed up on here
+    long delivered;           // ... states of the other side that did, while measuring
+} BenchSide;
+
+static uint64_t *latencies;
+static long n_latencies, cap_latencies;
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Time a process has run on a CPU, its log thread included, in seconds. Unlike
+// utime + stime this is not counted in clock ticks, so short runs read true
+static double process_cpu_s(pid_t pid)
+{
+    char path[300];
+    snprintf(path, sizeof(path), "/proc/%d/task", (int)pid);
+    DIR *dir = opendir(path);
+    if (dir == NULL) return 0;
+    unsigned long long total = 0, ns;
+    struct dirent *task;
+    while ((task = readdir(dir)) != NULL)
+    {
+        if (task->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "/proc/%d/task/%s/schedstat", (int)pid, task->d_name);
+        FILE *f = fopen(path, "r");
+        if (f == NULL) continue;
+        if (fscanf(f, "%llu", &ns) == 1) total += ns;
+        fclose(f);
+    }
+    closedir(dir);
+    return total / 1e9;
+}
+
+static void fifo_paths(const BenchSide *side, char tx[64], char rx[64])
+{
+    snprintf(tx, 64, "/tmp/fifoBBObs%s", side->suffix);
+    snprintf(rx, 64, "/tmp/fifoObsBB%s", side->suffix);
+}
+
+// The FIFOs, the process, then our write end (which waits for the process to open its own)
+static int start_side(BenchSide *side, const NetMode *mode, int port)
+{
+    char tx[64], rx[64], port_arg[16];
+    fifo_paths(side, tx, rx);
+    unlink(tx);
+    unlink(rx);
+    if (mkfifo(tx, 0666) == -1 || mkfifo(rx, 0666) == -1) { perror("bench_net: mkfifo"); return -1; }
+    side->rx_fd = open(rx, O_RDONLY | O_NONBLOCK);
+    snprintf(port_arg, sizeof(port_arg), "%d", port);
+
+    side->pid = fork();
+    if (side->pid == 0)
+    {
+        int null_fd = open("/dev/null", O_RDWR);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        execl("./network_process", "./network_process", side->role, port_arg, "127.0.0.1",
+              mode->protocol, mode->transport, (char *)NULL);
+        _exit(127);
+    }
+    side->tx_fd = open(tx, O_WRONLY);
+    if (side->pid == -1 || side->rx_fd == -1 || side->tx_fd == -1) { perror("bench_net: start"); return -1; }
+    frame_writer_init(&side->writer, side->tx_fd);
+    frame_reader_init(&side->reader, side->rx_fd, FRAME_BUFFER_CAP);
+    side->last_cell = -1;
+    return 0;
+}
+
+// Blackboard gone: the process says goodbye and exits, or is stopped
+static void stop_side(BenchSide *side)
+{
+    char tx[64], rx[64];
+    close(side->tx_fd);
+    uint64_t give_up = monotonic_ns() + EXIT_TIMEOUT_MS * 1000000ULL;
+    while (waitpid(side->pid, NULL, WNOHANG) == 0)
+    {
+        if (monotonic_ns() > give_up)
+        {
+            kill(side->pid, SIGKILL);
+            waitpid(side->pid, NULL, 0);
+            break;
+        }
+        usleep(10000);
+    }
+    frame_reader_free(&side->reader);
+    close(side->rx_fd);
+    fifo_paths(side, tx, rx);
+    unlink(tx);
+    unlink(rx);
+}
+
+// The next state, on the next cell
+static void send_state(BenchSide *side)
+{
+    int cell = (int)(side->sent % CELLS);
+    DroneState drone = {0};
+    drone.x = 1 + cell % CELLS_X;
+    drone.y = 1 + cell / CELLS_X;
+    side->sent_ns[cell] = monotonic_ns();
+    if (frame_send(&side->writer, MSG_DRONE_STATE, &drone, sizeof(drone)) == 0) side->sent++;
+}
+
+// Obstacle frames at 'side' show where 'from' put its drone. States sent
+// before 'since' (0 = not measuring yet) only move last_cell
+static void drain_side(BenchSide *side, const BenchSide *from, uint64_t since)
+{
+    FrameHeader hdr;
+    const void *payload;
+    while (frame_fill(&side->reader) > 0)
+    {
+        uint64_t now = monotonic_ns();
+        while (frame_next(&side->reader, &hdr, &payload))
+        {
+            if (hdr.type != MSG_OBSTACLES || hdr.length < sizeof(Obstacle)) continue;
+            const Obstacle *o = payload;
+            int cell = (o->y - 1) * CELLS_X + (o->x - 1);
+            if (!o->active || cell < 0 || cell >= CELLS || cell == side->last_cell) continue;
+            side->last_cell = cell;
+            if (since == 0 || from->sent_ns[cell] < since) continue;
+            side->delivered++;
+            if (n_latencies < cap_latencies) latencies[n_latencies++] = now - from->sent_ns[cell];
+        }
+    }
+}
+
+// Obstacle frames on both sides until 'until' (at most one wait)
+static void drain_until(BenchSide sides[2], uint64_t until, uint64_t since)
+{
+    uint64_t now = monotonic_ns();
+    uint64_t wait = (until > now) ? until - now : 0;
+    struct timespec timeout = { (time_t)(wait / 1000000000ULL), (long)(wait % 1000000000ULL) };
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(sides[0].rx_fd, &readable);
+    FD_SET(sides[1].rx_fd, &readable);
+    int top = (sides[0].rx_fd > sides[1].rx_fd) ? sides[0].rx_fd : sides[1].rx_fd;
+    if (pselect(top + 1, &readable, NULL, NULL, &timeout, NULL) <= 0) return;
+    drain_side(&sides[0], &sides[1], since);
+    drain_side(&sides[1], &sides[0], since);
+}
+
+// One pair of processes at 'rate' states/s per side for 'seconds'; prints one table row
+static int run_pair(const NetMode *mode, double rate, double seconds, int port)
+{
+    static BenchSide sides[2];
+    memset(sides, 0, sizeof(sides));
+    sides[0].suffix = "_server";
+    sides[0].role = "1";
+    sides[1].suffix = "_client";
+    sides[1].role = "2";
+    if (start_side(&sides[0], mode, port) == -1) return -1;
+    usleep(100000); // Listening before the client's first try, which would otherwise retry a second later
+    if (start_side(&sides[1], mode, port) == -1) return -1;
+
+    cap_latencies = (long)(2 * rate * seconds) + 16;
+    latencies = malloc(cap_latencies * sizeof(uint64_t));
+    n_latencies = 0;
+
+    uint64_t period = (uint64_t)(1e9 / rate);
+    uint64_t next_send = monotonic_ns(), setup_start = next_send, start = 0, stop = 0;
+    long sent_start[2] = {0};
+    double cpu_start = 0;
+    int measuring = 0;
+
+    while (stop == 0 || monotonic_ns() < stop)
+    {
+        uint64_t now = monotonic_ns();
+        if (now >= next_send)
+        {
+            next_send += period;
+            if (next_send < now) next_send = now + period; // We fell behind: no catching up in a burst
+            send_state(&sides[0]);
+            send_state(&sides[1]);
+
+            // Measure once both directions carry states (or the wait is over)
+            if (!measuring && ((sides[0].last_cell >= 0 && sides[1].last_cell >= 0) ||
+                               now - setup_start > SETUP_TIMEOUT_MS * 1000000ULL))
+            {
+                measuring = 1;
+                start = monotonic_ns();
+                stop = start + (uint64_t)(seconds * 1e9);
+                sent_start[0] = sides[0].sent;
+                sent_start[1] = sides[1].sent;
+                cpu_start = process_cpu_s(sides[0].pid) + process_cpu_s(sides[1].pid);
+            }
+            continue;
+        }
+
+        drain_until(sides, next_send, start);
+    }
+    double elapsed = (monotonic_ns() - start) / 1e9;
+    double cpu = process_cpu_s(sides[0].pid) + process_cpu_s(sides[1].pid) - cpu_start;
+    // States still on their way count if they land in time
+    uint64_t grace = monotonic_ns() + GRACE_MS * 1000000ULL;
+    while (monotonic_ns() < grace) drain_until(sides, grace, start);
+    long sent = sides[0].sent - sent_start[0] + sides[1].sent - sent_start[1];
+    long delivered = sides[0].delivered + sides[1].delivered;
+    stop_side(&sides[1]);
+    stop_side(&sides[0]);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%s/%s", mode->protocol, mode->transport);
+    if (n_latencies == 0)
+    {
+        printf("%-13s %7.0f  %9.1f  no states got through\n", name, rate, sent / 2.0 / elapsed);
+    }
+    else
+    {
+        qsort(latencies, n_latencies, sizeof(uint64_t), cmp_u64);
+        printf("%-13s %7.0f  %9.1f  %9.1f  %6.1f%%  %7.2f %7.2f %7.2f  %9.1f  %6.1f%%\n", name, rate,
+               sent / 2.0 / elapsed, delivered / 2.0 / elapsed, sent ? 100.0 * (sent - delivered) / sent : 0,
+               latencies[n_latencies / 2] / 1e6, latencies[(long)(0.99 * (n_latencies - 1))] / 1e6,
+               latencies[n_latencies - 1] / 1e6, cpu * 1e6 / delivered, 100.0 * cpu / elapsed);
+    }
+    fflush(stdout);
+    free(latencies);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    double seconds = (argc > 1) ? atof(argv[1]) : 2.0;
+    static const double default_rates[] = { 10, 33, 100, 333, 1000 };
+    static const NetMode modes[] = {
+        { "text", "tcp" }, { "binary", "tcp" }, { "binary", "udp" }, { "snapshot", "tcp" }, { "snapshot", "udp" }
+    };
+    int n_rates = (argc > 2) ? argc - 2 : (int)(sizeof(default_rates) / sizeof(default_rates[0]));
+    signal(SIGPIPE, SIG_IGN);
+    if (access("./network_process", X_OK) != 0)
+    {
+        fprintf(stderr, "bench_net: run it from the directory holding ./network_process\n");
+        return 1;
+    }
+    if (seconds <= 0)
+    {
+        fprintf(stderr, "Usage: %s [seconds] [rates_hz...]\n", argv[0]);
+        return 1;
+    }
+
+    printf("Server and client Network Process on 127.0.0.1, %.1f s per run, text rounds every %d us\n",
+           seconds, SYNC_RATE_US);
+    printf("%-13s %7s  %9s  %9s  %7s  %23s  %9s  %7s\n", "", "rate", "sent/s", "delivered", "", "latency [ms]",
+           "CPU [us]", "CPU");
+    printf("%-13s %7s  %9s  %9s  %7s  %7s %7s %7s  %9s  %7s\n", "protocol", "Hz", "per side", "/s per side",
+           "skipped", "p50", "p99", "max", "per state", "total");
+    int run = 0;
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+    {
+        for (int r = 0; r < n_rates; r++)
+        {
+            double rate = (argc > 2) ? atof(argv[r + 2]) : default_rates[r];
+            if (rate <= 0)
+            {
+                fprintf(stderr, "bench_net: rates must be above 0 Hz\n");
+                return 1;
+            }
+            if (run_pair(&modes[m], rate, seconds, BENCH_PORT + run++) == -1) return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pty.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <ncurses.h>
+#include "../BlackBoardServer/Blackboard.h"
+#include "../common.h"
+
+/* bench_render.c - Cost of one map frame, rendered into a pseudo-terminal
+   Usage: ./bench_render [frames]
+
+   For each entity count the same scene is rendered twice:
+     - full:        erase() + render_invalidate() every frame (old repaint-everything behaviour)
+     - incremental: only the dirty cells (what draw_map() does now)
+   and for two kinds of frames:
+     - moving: the drone moves every frame and ~2% of obstacles respawn
+     - idle:   nothing changes (incremental skips refresh() entirely)
+   Reports time per frame, cells handed to ncurses and bytes that reached the terminal.
+*/
+
+#define BENCH_ROWS 48
+#define BENCH_COLS 160
+
+int operation_mode = 0; // draw_map() reads it from the server
+
+static int pty_master = -1;
+static _Atomic long pty_bytes = 0; // Everything the terminal received so far
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Plays the terminal: keeps the pty drained so ncurses never blocks on a full
+// buffer, and counts the bytes it would have had to transfer (the SSH bandwidth)
+static void *pty_reader(void *arg)
+{
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(pty_master, buf, sizeof(buf))) > 0) atomic_fetch_add(&pty_bytes, n);
+    return NULL;
+}
+
+// Wait until the reader has caught up with everything written so far
+static long settle_pty(void)
+{
+    long last = -1;
+    long now = atomic_load(&pty_bytes);
+    while (now != last)
+    {
+        last = now;
+        usleep(20000);
+        now = atomic_load(&pty_bytes);
+    }
+    return now;
+}
+
+static void random_scene(Obstacle *obs, int n_obs, Target *tar, int n_tar)
+{
+    for (int i = 0; i < n_obs; i++)
+    {
+        obs[i].x = rand() % MAP_WIDTH;
+        obs[i].y = rand() % MAP_HEIGHT;
+        obs[i].active = 1;
+    }
+    for (int i = 0; i < n_tar; i++)
+    {
+        tar[i].x = rand() % MAP_WIDTH;
+        tar[i].y = rand() % MAP_HEIGHT;
+        tar[i].active = 1;
+    }
+}
+
+static void run_case(int entities, int frames, int incremental, int moving)
+{
+    int n_obs = entities / 2;
+    int n_tar = entities - n_obs;
+    Obstacle *obs = calloc(n_obs + 1, sizeof(Obstacle));
+    Target *tar = calloc(n_tar + 1, sizeof(Target));
+    DroneState drone = { .x = 10.0, .y = 10.0 };
+
+    srand(42);
+    random_scene(obs, n_obs, tar, n_tar);
+
+    // Settle the screen so both variants start from the same state
+    render_invalidate();
+    render_frame(&drone, NULL, 0, obs, n_obs, tar, n_tar, 0);
+    long bytes_before = settle_pty();
+
+    long cells = 0;
+    double start = now_us();
+    for (int f = 0; f < frames; f++)
+    {
+        if (moving)
+        {
+            drone.x = 5.0 + (f % 70);
+            drone.y = 5.0 + (f / 70) % 14;
+            for (int i = 0; i < n_obs; i++)
+            {
+                if (rand() % 100 < 2)
+                {
+                    obs[i].x = rand() % MAP_WIDTH;
+                    obs[i].y = rand() % MAP_HEIGHT;
+                }
+            }
+        }
+        if (!incremental)
+        {
+            erase();
+            render_invalidate();
+        }
+        cells += render_frame(&drone, NULL, 0, obs, n_obs, tar, n_tar, f / 100);
+    }
+    double elapsed = now_us() - start;
+    long bytes = settle_pty() - bytes_before;
+
+    printf("%9d  %-11s  %-6s  %10.1f  %10.1f  %10.1f\n", entities,
+           incremental ? "incremental" : "full", moving ? "moving" : "idle",
+           elapsed / frames, (double)cells / frames, (double)bytes / frames);
+
+    free(obs);
+    free(tar);
+}
+
+int main(int argc, char *argv[])
+{
+    int frames = (argc > 1) ? atoi(argv[1]) : 500;
+    if (frames < 1) frames = 500;
+
+    struct winsize ws = { .ws_row = BENCH_ROWS, .ws_col = BENCH_COLS };
+    int pty_slave = -1;
+    if (openpty(&pty_master, &pty_slave, NULL, NULL, &ws) == -1) { perror("openpty"); return 1; }
+    pthread_t reader;
+    pthread_create(&reader, NULL, pty_reader, NULL);
+
+    FILE *term_out = fdopen(pty_slave, "w");
+    FILE *term_in = fdopen(dup(pty_slave), "r");
+    const char *term = getenv("TERM");
+    SCREEN *screen = newterm((term && *term) ? (char *)term : "xterm", term_out, term_in);
+    if (screen == NULL) { fprintf(stderr, "newterm failed\n"); return 1; }
+    set_term(screen);
+    cbreak();
+    noecho();
+    curs_set(0);
+    start_color();
+    init_pair(COLOR_DRONE, COLOR_BLUE, COLOR_BLACK);
+    init_pair(COLOR_OBSTACLE, COLOR_YELLOW, COLOR_BLACK);
+    init_pair(COLOR_TARGET, COLOR_GREEN, COLOR_BLACK);
+
+    static const int counts[] = { 0, 10, 100, 1000, 4000 };
+    // ncurses draws into the pty, so stdout is free for the report
+    printf("Render benchmark: %dx%d pty, %d frames per case\n", BENCH_COLS, BENCH_ROWS, frames);
+    printf("%9s  %-11s  %-6s  %10s  %10s  %10s\n", "entities", "renderer", "frame", "us/frame", "cells/frm", "bytes/frm");
+    fflush(stdout);
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        for (int moving = 1; moving >= 0; moving--)
+        {
+            run_case(counts[c], frames, 0, moving);
+            run_case(counts[c], frames, 1, moving);
+        }
+    }
+
+    endwin();
+    delscreen(screen);
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "../ObstaclesGenerator/ObstaclesGenerator.h"
+#include "../common.h"
+
+/* bench_repulsion.c - Obstacle repulsion: linear scan vs spatial grid vs vector kernels
+   Usage: ./bench_repulsion [max_queries]
+
+   For each obstacle count the obstacles are spread uniformly over the map and
+   the same drone positions are evaluated (fewer queries for the big counts, so
+   every case scans roughly the same number of slots) with:
+     - scan:   apply_repulsive_forces() (every slot, one sqrt each)
+     - grid:   apply_repulsive_forces_grid() (only the 3x3 cells around the drone)
+     - scalar/sse/avx2: apply_repulsive_forces_columns() on the SoA columns,
+               every kernel variant this CPU supports
+   Also reports the cost of keeping the grid and columns current when ~2% of the
+   obstacles respawn per tick (world_set_obstacles), the largest force difference
+   between grid and scan (summation order only) and, for the kernels, the largest
+   difference per contributing obstacle relative to MAX_FORCE, which must stay
+   under REPULSION_TOLERANCE.
+*/
+
+#define POSITIONS 1024
+#define SLOT_BUDGET 50000000 // Slots the scan may visit per case
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void random_obstacle(Obstacle *o)
+{
+    o->x = rand() % MAP_WIDTH;
+    o->y = rand() % MAP_HEIGHT;
+    o->active = 1;
+    o->timer = OBSTACLE_LIFETIME;
+}
+
+enum { QUERY_SCAN, QUERY_GRID, QUERY_COLUMNS };
+
+// Returns ns per query; the summed forces go to 'fx'/'fy' for the cross-check
+static double time_queries(const WorldState *world, const DroneState *positions, int queries,
+                           int mode, double *fx, double *fy)
+{
+    double start = now_ns();
+    for (int q = 0; q < queries; q++)
+    {
+        DroneState d = positions[q % POSITIONS];
+        if (mode == QUERY_GRID) apply_repulsive_forces_grid(&d, world->obstacles, world->n_obstacles,
+                                                            world->grid.head, world->grid.links);
+        else if (mode == QUERY_COLUMNS) apply_repulsive_forces_columns(&d, &world->cols, world->n_obstacles);
+        else apply_repulsive_forces(&d, world->obstacles, world->n_obstacles);
+        fx[q % POSITIONS] = d.force_x;
+        fy[q % POSITIONS] = d.force_y;
+    }
+    return (now_ns() - start) / queries;
+}
+
+// Obstacles pushing a drone at 'pos' (for the per-obstacle tolerance)
+static int contributors(const WorldState *world, const DroneState *pos)
+{
+    int n = 0;
+    for (int i = 0; i < world->n_obstacles; i++)
+    {
+        double dx = pos->x - world->obstacles[i].x;
+        double dy = pos->y - world->obstacles[i].y;
+        double d = sqrt(dx * dx + dy * dy);
+        if (world->obstacles[i].active && d < INFLUENCE_RANGE && d > 0.1) n++;
+    }
+    return n;
+}
+
+int main(int argc, char *argv[])
+{
+    int max_queries = (argc > 1) ? atoi(argv[1]) : 200000;
+    if (max_queries < POSITIONS) max_queries = POSITIONS;
+
+    static const int counts[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 50000 };
+    int n_counts = sizeof(counts) / sizeof(counts[0]);
+
+    DroneState positions[POSITIONS] = {0};
+    static double fx_scan[POSITIONS], fy_scan[POSITIONS], fx_grid[POSITIONS], fy_grid[POSITIONS];
+    static double fx_vec[POSITIONS], fy_vec[POSITIONS];
+    int best_kernel = repulsion_kernel_select(KERNEL_AUTO);
+    srand(7);
+    for (int i = 0; i < POSITIONS; i++)
+    {
+        positions[i].x = (double)rand() / RAND_MAX * MAP_WIDTH;
+        positions[i].y = (double)rand() / RAND_MAX * MAP_HEIGHT;
+    }
+
+    printf("Repulsion benchmark: %dx%d map, %dx%d grid cells of %d, up to %d queries per case, best kernel %s\n",
+           MAP_WIDTH, MAP_HEIGHT, GRID_COLS, GRID_ROWS, GRID_CELL_SIZE, max_queries, repulsion_kernel_name(best_kernel));
+    printf("%9s  %10s  %10s", "obstacles", "scan ns/q", "grid ns/q");
+    for (int k = KERNEL_SCALAR; k <= best_kernel; k++) printf("  %8s ns/q", repulsion_kernel_name(k));
+    printf("  %14s  %10s  %10s\n", "update us/tick", "grid |dF|", "kernel err");
+    int violations = 0;
+
+    int crossover = -1;
+    for (int c = 0; c < n_counts; c++)
+    {
+        int n = counts[c];
+        int queries = SLOT_BUDGET / n;
+        if (queries > max_queries) queries = max_queries;
+        if (queries < POSITIONS) queries = POSITIONS;
+        WorldState world;
+        if (world_alloc(&world, n, 0, 0) == -1) { perror("world_alloc"); return 1; }
+
+        Obstacle *incoming = calloc(n, sizeof(Obstacle));
+        for (int i = 0; i < n; i++) random_obstacle(&incoming[i]);
+        world_set_obstacles(&world, incoming, n);
+
+        // Incremental maintenance: ~2% of the slots respawn somewhere else every tick
+        // (queried afterwards, so the cross-check also covers the incremental updates)
+        int ticks = 200;
+        double start = now_ns();
+        for (int t = 0; t < ticks; t++)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                if (rand() % 100 < 2) random_obstacle(&incoming[i]);
+            }
+            world_set_obstacles(&world, incoming, n);
+        }
+        double update_us = (now_ns() - start) / ticks / 1e3;
+
+        double scan = time_queries(&world, positions, queries, QUERY_SCAN, fx_scan, fy_scan);
+        double grid = time_queries(&world, positions, queries, QUERY_GRID, fx_grid, fy_grid);
+        double kernel_ns[KERNEL_AVX2 + 1] = {0};
+        double kernel_err = 0.0; // Worst |dF| / (contributors * MAX_FORCE) over every variant
+        for (int k = KERNEL_SCALAR; k <= best_kernel; k++)
+        {
+            repulsion_kernel_select(k);
+            kernel_ns[k] = time_queries(&world, positions, queries, QUERY_COLUMNS, fx_vec, fy_vec);
+            for (int i = 0; i < POSITIONS; i++)
+            {
+                int pushing = contributors(&world, &positions[i]);
+                double err = (fabs(fx_vec[i] - fx_scan[i]) + fabs(fy_vec[i] - fy_scan[i]))
+                             / ((pushing > 0 ? pushing : 1) * (double)MAX_FORCE);
+                if (err > kernel_err) kernel_err = err;
+                if (err > REPULSION_TOLERANCE) violations++;
+            }
+        }
+
+        double max_diff = 0.0;
+        for (int i = 0; i < POSITIONS; i++)
+        {
+            double d = fabs(fx_scan[i] - fx_grid[i]) + fabs(fy_scan[i] - fy_grid[i]);
+            if (d > max_diff) max_diff = d;
+        }
+
+        printf("%9d  %10.1f  %10.1f", n, scan, grid);
+        for (int k = KERNEL_SCALAR; k <= best_kernel; k++) printf("  %13.1f", kernel_ns[k]);
+        printf("  %14.2f  %10.2e  %10.2e\n", update_us, max_diff, kernel_err);
+        fflush(stdout);
+        if (crossover < 0 && grid < scan) crossover = n;
+
+        free(incoming);
+        world_free(&world);
+    }
+
+    if (crossover > 0) printf("Grid query is faster than the scan from %d obstacles on\n", crossover);
+    else printf("Grid query never beat the scan in this range\n");
+    printf("Kernel results over REPULSION_TOLERANCE (%.0e): %d (cut-off boundary cases)\n", REPULSION_TOLERANCE, violations);
+    return 0;
+}
@@ -0,0 +1,360 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "../common.h"
+
+/* bench_session.c - Session host under load: many binary peers on loopback
+   Usage: ./bench_session [seconds] [peers...]   (from the directory holding network_process)
+
+   Starts ./network_process in the server role and plays its Blackboard on the
+   _server FIFOs: a drone state every tick at TICK_HZ, while draining the obstacle
+   frames it sends back. Then connects the given number of simulated peers to
+   127.0.0.1. Each one does the text handshake, offers bin1, and then sends its
+   own drone every tick. For 'seconds' it records:
+     - fan-out: host -> peer delay of the host's drone (id 0). sent_ns is stamped
+       when the host read the tick from its pipe. p50 / p99 / max over every
+       update, and the p99 of the median and of the worst peer.
+     - relay: peer -> host -> peer delay of the other peers' drones, from the
+       sender's own stamp.
+     - updates/s that reached each peer (TICK_HZ if none was skipped), relayed
+       drones/s per peer, the host's CPU per tick, and how many drones the last
+       obstacle frame to the Blackboard held.
+   Every peer runs in this process on one epoll loop, so on a small machine its
+   own work shows up in the numbers. Do not run it next to a networked game:
+   it uses the same _server FIFO paths.
+*/
+
+#define TICK_HZ 33
+#define BENCH_PORT 5750
+#define CONNECT_TIMEOUT_MS 3000
+#define HIST_BUCKET_US 10
+#define HIST_BUCKETS 100000 // Up to 1 s
+#define RX_CAP (NET_FRAME_BYTES * 512)
+
+typedef struct {
+    int fd;
+    int streaming;           // Handshake done
+    uint8_t rx[RX_CAP];
+    int rx_len;
+    uint32_t seq;
+    uint64_t *fan_ns;        // Host -> peer delays while measuring
+    int n_fan, cap_fan;
+    long relayed;
+} BenchPeer;
+
+static uint32_t relay_hist[HIST_BUCKETS + 1];
+static long relay_count;
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double hist_percentile(double p)
+{
+    long want = (long)(p * relay_count);
+    long seen = 0;
+    for (int b = 0; b <= HIST_BUCKETS; b++)
+    {
+        seen += relay_hist[b];
+        if (seen > want) return b * HIST_BUCKET_US / 1000.0;
+    }
+    return HIST_BUCKETS * HIST_BUCKET_US / 1000.0;
+}
+
+// utime + stime of a process, in seconds
+static double process_cpu_s(pid_t pid)
+{
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE *f = fopen(path, "r");
+    if (f == NULL) return 0;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+    char *p = strrchr(buf, ')');
+    unsigned long utime = 0, stime = 0;
+    if (p == NULL || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2) return 0;
+    return (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+static int connect_peer(int port)
+{
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    uint64_t give_up = monotonic_ns() + CONNECT_TIMEOUT_MS * 1000000ULL;
+    while (monotonic_ns() < give_up)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+        {
+            int opt = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+            fcntl(fd, F_SETFL, O_NONBLOCK);
+            return fd;
+        }
+        close(fd);
+        usleep(10000); // The host is still starting
+    }
+    return -1;
+}
+
+static void send_text(int fd, const char *line)
+{
+    if (write(fd, line, strlen(line)) < 0) { /* The read side notices */ }
+}
+
+// Lines until the handshake is done, then frames; returns -1 when the host is gone
+static int peer_read(BenchPeer *peer, int measuring)
+{
+    while (1)
+    {
+        ssize_t n = read(peer->fd, peer->rx + peer->rx_len, RX_CAP - peer->rx_len);
+        if (n == 0) return -1;
+        if (n < 0) return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+        peer->rx_len += (int)n;
+        uint64_t now = monotonic_ns();
+
+        int at = 0;
+        while (!peer->streaming)
+        {
+            uint8_t *nl = memchr(peer->rx + at, '\n', peer->rx_len - at);
+            if (nl == NULL) break;
+            if (strncmp((char *)peer->rx + at, "ok", 2) == 0) send_text(peer->fd, "ook " NET_PROTO_BINARY "\n");
+            else if (strncmp((char *)peer->rx + at, "size", 4) == 0)
+            {
+                send_text(peer->fd, "sok 80 24\n");
+                peer->streaming = 1;
+            }
+            at = (int)(nl - peer->rx) + 1;
+        }
+        while (peer->streaming && peer->rx_len - at >= NET_FRAME_BYTES)
+        {
+            NetStateFrame frame;
+            if (net_frame_decode(peer->rx + at, &frame) == -1) return -1;
+            at += NET_FRAME_BYTES;
+            if (!measuring || frame.type != NET_STATE) continue;
+            uint64_t delay = now - frame.sent_ns;
+            if (frame.drone == 0)
+            {
+                if (peer->n_fan < peer->cap_fan) peer->fan_ns[peer->n_fan++] = delay;
+            }
+            else
+            {
+                uint64_t b = delay / 1000 / HIST_BUCKET_US;
+                relay_hist[b < HIST_BUCKETS ? b : HIST_BUCKETS]++;
+                relay_count++;
+                peer->relayed++;
+            }
+        }
+        memmove(peer->rx, peer->rx + at, peer->rx_len - at);
+        peer->rx_len -= at;
+    }
+}
+
+static void drain_obstacles(FrameReader *reader, int *last_n)
+{
+    FrameHeader hdr;
+    const void *payload;
+    while (frame_fill(reader) > 0)
+    {
+        while (frame_next(reader, &hdr, &payload))
+        {
+            if (hdr.type == MSG_OBSTACLES) *last_n = hdr.length / sizeof(Obstacle);
+        }
+    }
+}
+
+// One host with 'n_peers' peers for 'seconds'; prints one table row
+static int run_session(int n_peers, double seconds, int port)
+{
+    const char *fifo_tx = "/tmp/fifoBBObs_server", *fifo_rx = "/tmp/fifoObsBB_server";
+    unlink(fifo_tx);
+    unlink(fifo_rx);
+    if (mkfifo(fifo_tx, 0666) == -1 || mkfifo(fifo_rx, 0666) == -1) { perror("mkfifo"); return -1; }
+    int rx_fd = open(fifo_rx, O_RDONLY | O_NONBLOCK);
+
+    char port_arg[16];
+    snprintf(port_arg, sizeof(port_arg), "%d", port);
+    pid_t host = fork();
+    if (host == 0)
+    {
+        int null_fd = open("/dev/null", O_RDWR);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        execl("./network_process", "./network_process", "1", port_arg, "127.0.0.1", "binary", (char *)NULL);
+        _exit(127);
+    }
+    int tx_fd = open(fifo_tx, O_WRONLY); // Waits for the host to open its end
+    FrameWriter bb;
+    frame_writer_init(&bb, tx_fd);
+    FrameReader bb_rx;
+    frame_reader_init(&bb_rx, rx_fd, FRAME_BUFFER_CAP);
+
+    int ep = epoll_create1(0);
+    BenchPeer *peers = calloc(n_peers, sizeof(BenchPeer));
+    int cap = (int)(seconds * TICK_HZ * 2) + 16;
+    for (int i = 0; i < n_peers; i++)
+    {
+        peers[i].fd = connect_peer(port);
+        if (peers[i].fd == -1) { fprintf(stderr, "bench_session: cannot connect peer %d\n", i); return -1; }
+        peers[i].fan_ns = malloc(cap * sizeof(uint64_t));
+        peers[i].cap_fan = cap;
+        struct epoll_event ev = { .events = EPOLLIN, .data.u32 = (uint32_t)i };
+        epoll_ctl(ep, EPOLL_CTL_ADD, peers[i].fd, &ev);
+    }
+
+    memset(relay_hist, 0, sizeof(relay_hist));
+    relay_count = 0;
+    int measuring = 0, last_n = 0, ticks = 0, connected = 0;
+    uint64_t tick_ns = 1000000000ULL / TICK_HZ;
+    uint64_t next_tick = monotonic_ns(), start = 0, stop = 0;
+    double cpu_start = 0;
+    uint64_t setup_start = monotonic_ns();
+    DroneState drone = { MAP_WIDTH / 2.0, MAP_HEIGHT / 2.0, 0, 0, 0, 0 };
+
+    while (stop == 0 || monotonic_ns() < stop)
+    {
+        uint64_t now = monotonic_ns();
+        if (now >= next_tick)
+        {
+            next_tick += tick_ns;
+            drone.x = MAP_WIDTH / 2.0 + (ticks % 20);
+            frame_send(&bb, MSG_DRONE_STATE, &drone, sizeof(drone));
+            for (int i = 0; i < n_peers; i++)
+            {
+                if (!peers[i].streaming) continue;
+                NetStateFrame frame = { NET_STATE, 0, ++peers[i].seq, monotonic_ns(), 10.0f + i % 50, 5.0f, 0, 0 };
+                uint8_t bytes[NET_FRAME_BYTES];
+                net_frame_encode(&frame, bytes);
+                if (send(peers[i].fd, bytes, sizeof(bytes), MSG_NOSIGNAL) < 0) { /* Backed up: skip the tick */ }
+            }
+            if (measuring) ticks++;
+            drain_obstacles(&bb_rx, &last_n);
+
+            // Measure once everyone is streaming (or the wait is over)
+            if (!measuring)
+            {
+                connected = 0;
+                for (int i = 0; i < n_peers; i++) connected += peers[i].streaming;
+                if (connected == n_peers || now - setup_start > CONNECT_TIMEOUT_MS * 1000000ULL)
+                {
+                    measuring = 1;
+                    start = monotonic_ns();
+                    stop = start + (uint64_t)(seconds * 1e9);
+                    cpu_start = process_cpu_s(host);
+                }
+            }
+            continue;
+        }
+
+        struct epoll_event events[64];
+        int timeout_ms = (int)((next_tick - now) / 1000000);
+        int n = epoll_wait(ep, events, 64, timeout_ms);
+        for (int e = 0; e < n; e++)
+        {
+            BenchPeer *peer = &peers[events[e].data.u32];
+            if (peer_read(peer, measuring) == -1)
+            {
+                epoll_ctl(ep, EPOLL_CTL_DEL, peer->fd, NULL);
+                peer->streaming = 0;
+            }
+        }
+    }
+    double elapsed = (monotonic_ns() - start) / 1e9;
+    double host_cpu = process_cpu_s(host) - cpu_start;
+
+    // Blackboard goes away: the host says goodbye and exits
+    close(tx_fd);
+    waitpid(host, NULL, 0);
+    for (int i = 0; i < n_peers; i++) close(peers[i].fd);
+    frame_reader_free(&bb_rx);
+    close(rx_fd);
+    close(ep);
+    unlink(fifo_tx);
+    unlink(fifo_rx);
+
+    // FAN-OUT: every update, then each peer's p99
+    long total = 0, relayed = 0;
+    for (int i = 0; i < n_peers; i++) { total += peers[i].n_fan; relayed += peers[i].relayed; }
+    uint64_t *all = malloc((total + 1) * sizeof(uint64_t));
+    uint64_t *peer_p99 = malloc(n_peers * sizeof(uint64_t));
+    long k = 0;
+    int with_updates = 0;
+    for (int i = 0; i < n_peers; i++)
+    {
+        BenchPeer *peer = &peers[i];
+        if (peer->n_fan == 0) continue;
+        memcpy(all + k, peer->fan_ns, peer->n_fan * sizeof(uint64_t));
+        k += peer->n_fan;
+        qsort(peer->fan_ns, peer->n_fan, sizeof(uint64_t), cmp_u64);
+        peer_p99[with_updates++] = peer->fan_ns[(int)(0.99 * (peer->n_fan - 1))];
+    }
+    qsort(all, total, sizeof(uint64_t), cmp_u64);
+    qsort(peer_p99, with_updates, sizeof(uint64_t), cmp_u64);
+
+    if (total == 0)
+    {
+        printf("%5d  %9d  no updates reached the peers\n", n_peers, connected);
+    }
+    else
+    {
+        printf("%5d  %9d  %9.1f  %7.2f %7.2f %7.2f  %9.2f %9.2f  %7.2f %7.2f  %10.0f  %9.1f  %5d\n",
+               n_peers, connected, total / (double)n_peers / elapsed,
+               all[(long)(0.50 * (total - 1))] / 1e6, all[(long)(0.99 * (total - 1))] / 1e6, all[total - 1] / 1e6,
+               peer_p99[with_updates / 2] / 1e6, peer_p99[with_updates - 1] / 1e6,
+               relay_count ? hist_percentile(0.50) : 0, relay_count ? hist_percentile(0.99) : 0,
+               relayed / (double)n_peers / elapsed, ticks ? host_cpu * 1e6 / ticks : 0, last_n);
+    }
+    fflush(stdout);
+
+    for (int i = 0; i < n_peers; i++) free(peers[i].fan_ns);
+    free(peers);
+    free(all);
+    free(peer_p99);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    double seconds = (argc > 1) ? atof(argv[1]) : 3.0;
+    static const int default_peers[] = { 8, 32, 128, NET_MAX_PEERS };
+    int n_runs = (argc > 2) ? argc - 2 : (int)(sizeof(default_peers) / sizeof(default_peers[0]));
+    signal(SIGPIPE, SIG_IGN);
+    if (access("./network_process", X_OK) != 0)
+    {
+        fprintf(stderr, "bench_session: run it from the directory holding ./network_process\n");
+        return 1;
+    }
+
+    printf("Session host on 127.0.0.1, binary peers, %d Hz ticks, %.1f s per run\n", TICK_HZ, seconds);
+    printf("%5s  %9s  %9s  %23s  %19s  %15s  %10s  %9s  %5s\n", "", "", "updates/s", "fan-out [ms]",
+           "per-peer p99 [ms]", "relay [ms]", "relayed/s", "host CPU", "BB");
+    printf("%5s  %9s  %9s  %7s %7s %7s  %9s %9s  %7s %7s  %10s  %9s  %5s\n", "peers", "streaming", "per peer",
+           "p50", "p99", "max", "median", "worst", "p50", "p99", "per peer", "us/tick", "drones");
+    for (int r = 0; r < n_runs; r++)
+    {
+        int n = (argc > 2) ? atoi(argv[r + 2]) : default_peers[r];
+        if (n < 1 || n > NET_MAX_PEERS)
+        {
+            fprintf(stderr, "bench_session: peers must be 1..%d\n", NET_MAX_PEERS);
+            return 1;
+        }
+        if (run_session(n, seconds, BENCH_PORT + r) == -1) return 1;
+    }
+    return 0;
+}
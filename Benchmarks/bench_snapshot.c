@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../DroneDynamics/DroneController.h"
+#include "../common.h"
+
+/* bench_snapshot.c - Bytes on the wire per tick: text, bin1 frames, snap1 snapshots
+   Usage: ./bench_snapshot [ticks]
+
+   A world of N drones flies for 'ticks' drone frames (DT apart), and every tick
+   the host's view of it is encoded the ways the Network Process can send it to
+   one peer:
+     - text:  the drone/obst/pok lines of the lock-step exchange, once per drone
+     - bin1:  one 32-byte frame per drone (every peer streams every tick, so the
+              host relays them all)
+     - full:  a snap1 snapshot without a baseline (a new peer, or lost acks)
+     - delta: a snap1 snapshot against the one LAG ticks back, i.e. the peer's
+              acks arrive LAG ticks after the snapshot left. A world that has
+              not changed since then sends nothing, as in the Network Process
+   Moving drones steer at a random thrust that changes every second or so and
+   bounce off the borders; the rest hover in place. Every snapshot is decoded
+   again and compared with what was encoded, and the largest position error
+   against the float state shows the quantization.
+*/
+
+#define DEFAULT_TICKS 2000
+#define MAX_THRUST 5.0   // Terminal speed MAX_THRUST / DRAG_COEF
+#define STEER_TICKS 20   // Mean ticks between thrust changes
+#define SHORT_LAG 1
+#define LONG_LAG 4
+
+typedef struct {
+    double x, y, vx, vy, fx, fy;
+    int moving;
+} SimDrone;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void steer(SimDrone *d, Rng *rng)
+{
+    double angle = rng_next(rng) / 4294967296.0 * 2 * M_PI;
+    double thrust = MAX_THRUST * rng_next(rng) / 4294967296.0;
+    d->fx = thrust * cos(angle);
+    d->fy = thrust * sin(angle);
+}
+
+static void fly(SimDrone *d, Rng *rng)
+{
+    if (!d->moving) return;
+    if (rng_below(rng, STEER_TICKS) == 0) steer(d, rng);
+    d->vx += (d->fx - DRAG_COEF * d->vx) / MASS * DT;
+    d->vy += (d->fy - DRAG_COEF * d->vy) / MASS * DT;
+    d->x += d->vx * DT;
+    d->y += d->vy * DT;
+    if (d->x < 1 || d->x > MAP_WIDTH - 2) { d->vx = -d->vx; d->fx = -d->fx; d->x = (d->x < 1) ? 1 : MAP_WIDTH - 2; }
+    if (d->y < 1 || d->y > MAP_HEIGHT - 2) { d->vy = -d->vy; d->fy = -d->fy; d->y = (d->y < 1) ? 1 : MAP_HEIGHT - 2; }
+}
+
+static int same_snapshot(const NetSnapshot *a, const NetSnapshot *b)
+{
+    for (int id = 0; id < NET_SNAP_ENTITIES; id++)
+    {
+        float ax, ay, avx, avy, bx, by, bvx, bvy;
+        int in_a = net_snap_get(a, id, &ax, &ay, &avx, &avy), in_b = net_snap_get(b, id, &bx, &by, &bvx, &bvy);
+        if (in_a != in_b) return 0;
+        if (in_a && (ax != bx || ay != by || avx != bvx || avy != bvy)) return 0;
+    }
+    return 1;
+}
+
+typedef struct {
+    double text, bin1, full, delta_short, delta_long; // Bytes per tick
+    double encode_us, decode_us;
+    double max_error;
+    long mismatches;
+} CaseResult;
+
+static void run_case(int n_drones, double moving, int ticks, CaseResult *res)
+{
+    static NetSnapshot worlds[LONG_LAG + 1], decoded;
+    static uint8_t buf[NET_SNAP_MAX_BYTES];
+    SimDrone *drones = calloc(n_drones, sizeof(SimDrone));
+    Rng rng;
+    rng_seed(&rng, 42, (uint64_t)n_drones);
+    for (int i = 0; i < n_drones; i++)
+    {
+        drones[i].x = 1 + rng_below(&rng, MAP_WIDTH - 3) + rng_next(&rng) / 4294967296.0;
+        drones[i].y = 1 + rng_below(&rng, MAP_HEIGHT - 3) + rng_next(&rng) / 4294967296.0;
+        drones[i].moving = rng_next(&rng) / 4294967296.0 < moving;
+        steer(&drones[i], &rng);
+    }
+
+    memset(res, 0, sizeof(*res));
+    double text = 0, bin1 = 0, full = 0, delta_short = 0, delta_long = 0, encode_ns = 0, decode_ns = 0;
+    int measured = 0;
+    for (int t = 1; t <= ticks; t++)
+    {
+        NetSnapshot *world = &worlds[t % (LONG_LAG + 1)];
+        net_snap_clear(world, (uint32_t)t);
+        for (int i = 0; i < n_drones; i++)
+        {
+            fly(&drones[i], &rng);
+            net_snap_set(world, i, (float)drones[i].x, (float)drones[i].y, (float)drones[i].vx, (float)drones[i].vy);
+
+            float qx, qy, qvx, qvy;
+            net_snap_get(world, i, &qx, &qy, &qvx, &qvy);
+            double err = fmax(fabs(qx - drones[i].x), fabs(qy - drones[i].y));
+            if (err > res->max_error) res->max_error = err;
+
+            char line[64];
+            text += strlen("drone\n") + snprintf(line, sizeof(line), "%.2f %.2f\n", drones[i].x, drones[i].y) +
+                    strlen("obst\n") + strlen("pok\n");
+        }
+        bin1 += (double)n_drones * NET_FRAME_BYTES;
+
+        int entries;
+        full += net_snap_encode(world, NULL, -1, buf, &entries);
+        if (t <= LONG_LAG) continue; // Until there is a baseline LONG_LAG back
+        measured++;
+
+        const NetSnapshot *base_short = &worlds[(t - SHORT_LAG) % (LONG_LAG + 1)];
+        const NetSnapshot *base_long = &worlds[(t - LONG_LAG) % (LONG_LAG + 1)];
+        int len_long = net_snap_encode(world, base_long, -1, buf, &entries);
+        if (entries > 0) delta_long += len_long;
+
+        double t0 = now_ns();
+        int len = net_snap_encode(world, base_short, -1, buf, &entries);
+        double t1 = now_ns();
+        int bad = net_snap_decode(buf, len, base_short, &decoded) == -1;
+        double t2 = now_ns();
+        if (entries > 0) delta_short += len;
+        encode_ns += t1 - t0;
+        decode_ns += t2 - t1;
+        if (bad || !same_snapshot(&decoded, world)) res->mismatches++;
+    }
+
+    res->text = text / ticks;
+    res->bin1 = bin1 / ticks;
+    res->full = full / ticks;
+    res->delta_short = delta_short / measured;
+    res->delta_long = delta_long / measured;
+    res->encode_us = encode_ns / measured / 1e3;
+    res->decode_us = decode_ns / measured / 1e3;
+    free(drones);
+}
+
+int main(int argc, char *argv[])
+{
+    int ticks = (argc > 1) ? atoi(argv[1]) : DEFAULT_TICKS;
+    if (ticks <= LONG_LAG)
+    {
+        fprintf(stderr, "Usage: %s [ticks > %d]\n", argv[0], LONG_LAG);
+        return 1;
+    }
+    static const int sizes[] = { 1, 8, 32, 128, NET_SNAP_ENTITIES };
+    static const double moving[] = { 1.0, 0.25, 0.0 };
+
+    printf("Snapshot benchmark: %d ticks of %.0f ms, positions in 1/%d cell, velocities in 1/%d cell/s\n",
+           ticks, DT * 1e3, NET_SNAP_POS_SCALE, NET_SNAP_VEL_SCALE);
+    printf("                 ------------------ bytes per tick -----------------\n");
+    printf("drones moving      text      bin1      full  delta(%d)  delta(%d)   encode us  decode us\n", SHORT_LAG, LONG_LAG);
+    double max_error = 0;
+    long mismatches = 0;
+    for (size_t m = 0; m < sizeof(moving) / sizeof(moving[0]); m++)
+    {
+        for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++)
+        {
+            CaseResult r;
+            run_case(sizes[k], moving[m], ticks, &r);
+            printf("%6d %5.0f%% %9.1f %9.1f %9.1f %9.1f %9.1f %11.2f %10.2f\n", sizes[k], moving[m] * 100,
+                   r.text, r.bin1, r.full, r.delta_short, r.delta_long, r.encode_us, r.decode_us);
+            if (r.max_error > max_error) max_error = r.max_error;
+            mismatches += r.mismatches;
+        }
+    }
+    printf("largest position error %.4f cells, %ld snapshots decoded differently\n", max_error, mismatches);
+    return mismatches != 0;
+}
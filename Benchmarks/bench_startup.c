@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/wait.h>
+#include "../common.h"
+
+/* bench_startup.c - Bring-up time of a headless instance
+   Usage: ./bench_startup [runs]   (from the directory holding the built binaries)
+
+   Every run launches a standalone headless instance in a scratch directory with its
+   own param.conf, input script, log and stats file. The script starts the game and
+   quits shortly after; the server writes how long it took for every child to report
+   ready (startup_ready_ms) and for the first frame to go out (first_frame_ms).
+   'cycle' is launch -> exit of the whole instance, i.e. what one restart costs
+   including the script's QUIT_MS of play and the teardown.
+   Runs for the multi-process server and for the threaded build; p50 / p99 / max.
+*/
+
+#define QUIT_MS 50
+#define MAX_RUNS 1000
+
+static const char *binaries[] = {
+    "server", "server_threaded", "drone", "keyboard", "obstacle_process", "target_process", "watchdog"
+};
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double read_stat(const char *path, const char *key)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) return -1.0;
+    char line[128];
+    double value = -1.0;
+    size_t len = strlen(key);
+    while (fgets(line, sizeof(line), f))
+    {
+        if (strncmp(line, key, len) == 0 && line[len] == '=') value = atof(line + len + 1);
+    }
+    fclose(f);
+    return value;
+}
+
+static int write_file(const char *path, const char *text)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL) return -1;
+    fputs(text, f);
+    return fclose(f);
+}
+
+// One instance, launch to exit; returns 0 and the three times in ms, or -1
+static int run_instance(const char *binary, double *ready_ms, double *first_ms, double *cycle_ms)
+{
+    unlink("stats.txt");
+    uint64_t start = monotonic_ns();
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        int null_fd = open("/dev/null", O_RDWR);
+        dup2(null_fd, STDIN_FILENO);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        char path[64];
+        snprintf(path, sizeof(path), "./%s", binary);
+        execl(path, path, (char *)NULL);
+        _exit(127);
+    }
+    if (pid < 0) return -1;
+    int status;
+    waitpid(pid, &status, 0);
+    *cycle_ms = (monotonic_ns() - start) / 1e6;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return -1;
+
+    *ready_ms = read_stat("stats.txt", "startup_ready_ms");
+    *first_ms = read_stat("stats.txt", "first_frame_ms");
+    return (*ready_ms > 0 && *first_ms > 0) ? 0 : -1;
+}
+
+static void print_row(const char *binary, const char *what, double *v, int n)
+{
+    qsort(v, n, sizeof(double), cmp_double);
+    printf("%-16s %-12s %9.2f  %9.2f  %9.2f\n", binary, what, v[n / 2], v[(n * 99) / 100], v[n - 1]);
+}
+
+int main(int argc, char *argv[])
+{
+    int runs = (argc > 1) ? atoi(argv[1]) : 20;
+    if (runs < 1) runs = 1;
+    if (runs > MAX_RUNS) runs = MAX_RUNS;
+
+    char repo[PATH_MAX];
+    if (getcwd(repo, sizeof(repo)) == NULL) { perror("getcwd"); return 1; }
+
+    // Scratch directory with links to the binaries, so the runs never touch the
+    // checkout's param.conf, log or stats
+    char scratch[] = "/tmp/startup_bench_XXXXXX";
+    if (mkdtemp(scratch) == NULL) { perror("mkdtemp"); return 1; }
+    int n_binaries = sizeof(binaries) / sizeof(binaries[0]);
+    for (int b = 0; b < n_binaries; b++)
+    {
+        char target[PATH_MAX + 64], link_path[128];
+        snprintf(target, sizeof(target), "%s/%s", repo, binaries[b]);
+        snprintf(link_path, sizeof(link_path), "%s/%s", scratch, binaries[b]);
+        if (access(target, X_OK) == -1) { fprintf(stderr, "Missing %s: run 'make' first\n", target); return 1; }
+        if (symlink(target, link_path) == -1) { perror("symlink"); return 1; }
+    }
+    if (chdir(scratch) == -1) { perror("chdir"); return 1; }
+
+    char script[64];
+    snprintf(script, sizeof(script), "0 start\n%d quit\n", QUIT_MS);
+    if (write_file("script.txt", script) == -1 ||
+        write_file("param.conf", "MODE=standalone\nHEADLESS=1\nINPUT_SCRIPT=script.txt\n"
+                                 "STATS_FILE=stats.txt\nMETRICS_FILE=metrics\n") == -1)
+    {
+        perror("scratch files"); return 1;
+    }
+
+    double *ready = calloc(runs, sizeof(double));
+    double *first = calloc(runs, sizeof(double));
+    double *cycle = calloc(runs, sizeof(double));
+
+    printf("Startup benchmark: %d headless standalone instance(s) per build, script quits after %d ms\n", runs, QUIT_MS);
+    printf("%-16s %-12s %9s  %9s  %9s\n", "build", "ms", "p50", "p99", "max");
+    for (int b = 0; b < 2; b++)
+    {
+        int ok = 0;
+        for (int r = 0; r < runs; r++)
+        {
+            if (run_instance(binaries[b], &ready[ok], &first[ok], &cycle[ok]) == 0) ok++;
+        }
+        if (ok == 0) { printf("%-16s failed\n", binaries[b]); continue; }
+        if (ok < runs) printf("%-16s %d of %d runs failed\n", binaries[b], runs - ok, runs);
+        print_row(binaries[b], "ready", ready, ok);
+        print_row(binaries[b], "first frame", first, ok);
+        print_row(binaries[b], "cycle", cycle, ok);
+        fflush(stdout);
+    }
+
+    // Leave nothing behind
+    for (int b = 0; b < n_binaries; b++) unlink(binaries[b]);
+    const char *files[] = { "script.txt", "param.conf", "stats.txt", "metrics.prom", "simulation.log" };
+    for (int i = 0; i < (int)(sizeof(files) / sizeof(files[0])); i++) unlink(files[i]);
+    if (chdir(repo) == -1 || rmdir(scratch) == -1) fprintf(stderr, "Left %s behind\n", scratch);
+    free(ready);
+    free(first);
+    free(cycle);
+    return 0;
+}
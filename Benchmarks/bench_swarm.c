@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "../DroneDynamics/DroneController.h"
+#include "../ObstaclesGenerator/ObstaclesGenerator.h"
+#include "../common.h"
+
+/* bench_swarm.c - Multi-drone batch physics: ticks/sec vs drone count and threads
+   Usage: ./bench_swarm [max_threads] [obstacles] [ms_per_case]
+
+   For each drone count the drones are spawned like the drone process does and
+   stepped with swarm_step() (thrust, brake, repulsion, borders, integration)
+   on a pool of 1, 2, 4, ... max_threads threads (default: online CPUs).
+   Reports batch ticks/sec, drone steps/sec and the speedup over one thread.
+   The steps of different drones are independent, so every thread count must
+   end in the same state as one thread; the last column checks it bit for bit.
+*/
+
+#define MIN_TICKS 20
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Runs 'ticks' batches from the spawn positions; the final state is left in 'drones'
+static double run_case(SwarmPool *pool, SwarmBatch *batch, int ticks)
+{
+    for (int i = 0; i < batch->n; i++) drone_spawn(&batch->drones[i], i, batch->n);
+    double start = now_ns();
+    for (int t = 0; t < ticks; t++) swarm_step(pool, batch);
+    return (now_ns() - start) / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    int max_threads = (argc > 1) ? atoi(argv[1]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int n_obstacles = (argc > 2) ? atoi(argv[2]) : 200;
+    double case_s = ((argc > 3) ? atoi(argv[3]) : 300) / 1000.0;
+    if (max_threads < 1) max_threads = 1;
+    if (max_threads > MAX_DRONE_THREADS) max_threads = MAX_DRONE_THREADS;
+    if (n_obstacles < 1) n_obstacles = 1;
+
+    static const int counts[] = { 1, 10, 100, 1000, 10000, 100000 };
+    int n_counts = sizeof(counts) / sizeof(counts[0]);
+    int max_drones = counts[n_counts - 1];
+
+    // 1, 2, 4, ... and max_threads itself
+    int thread_counts[16];
+    int n_thread_counts = 0;
+    for (int t = 1; t < max_threads; t *= 2) thread_counts[n_thread_counts++] = t;
+    thread_counts[n_thread_counts++] = max_threads;
+
+    int kernel = repulsion_kernel_select(KERNEL_AUTO);
+    srand(11);
+
+    WorldState world;
+    if (world_alloc(&world, n_obstacles, 0, 0) == -1) { perror("world_alloc"); return 1; }
+    Obstacle *incoming = calloc(n_obstacles, sizeof(Obstacle));
+    for (int i = 0; i < n_obstacles; i++)
+    {
+        incoming[i].x = rand() % MAP_WIDTH;
+        incoming[i].y = rand() % MAP_HEIGHT;
+        incoming[i].active = 1;
+        incoming[i].timer = OBSTACLE_LIFETIME;
+    }
+    world_set_obstacles(&world, incoming, n_obstacles);
+
+    // Every drone holds its own thrust; one in eight is braking
+    DroneState *drones = calloc(max_drones, sizeof(DroneState));
+    DroneState *reference = calloc(max_drones, sizeof(DroneState));
+    InputMsg *inputs = calloc(max_drones, sizeof(InputMsg));
+    if (drones == NULL || reference == NULL || inputs == NULL) { perror("alloc"); return 1; }
+    for (int i = 0; i < max_drones; i++)
+    {
+        inputs[i].force_x = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+        inputs[i].force_y = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+        inputs[i].command = (i % 8 == 7) ? ' ' : 0;
+        inputs[i].drone = (uint32_t)i;
+    }
+
+    printf("Swarm benchmark: %d obstacles, kernel %s, up to %d threads (%ld CPUs online), %.0f ms per case\n",
+           n_obstacles, repulsion_kernel_name(kernel), max_threads, sysconf(_SC_NPROCESSORS_ONLN), case_s * 1e3);
+    printf("%7s  %7s  %12s  %14s  %8s  %9s\n", "drones", "threads", "ticks/s", "Msteps/s", "speedup", "identical");
+
+    for (int c = 0; c < n_counts; c++)
+    {
+        int n = counts[c];
+        SwarmBatch batch = { drones, inputs, n, NULL, &world, kernel != KERNEL_SCALAR };
+        double single_rate = 0.0;
+        int ticks = 0;
+
+        for (int k = 0; k < n_thread_counts; k++)
+        {
+            int threads = thread_counts[k];
+            SwarmPool *pool = swarm_pool_create(threads);
+            if (pool == NULL) { perror("swarm_pool_create"); return 1; }
+
+            // The one-thread run sizes the case; the others repeat the same ticks
+            if (threads == 1)
+            {
+                double probe = run_case(pool, &batch, MIN_TICKS);
+                ticks = (int)(MIN_TICKS * case_s / (probe > 1e-9 ? probe : 1e-9));
+                if (ticks < MIN_TICKS) ticks = MIN_TICKS;
+            }
+            double elapsed = run_case(pool, &batch, ticks);
+            double rate = ticks / elapsed;
+            int identical = 1;
+            if (threads == 1)
+            {
+                single_rate = rate;
+                memcpy(reference, drones, (size_t)n * sizeof(DroneState));
+            }
+            else identical = (memcmp(reference, drones, (size_t)n * sizeof(DroneState)) == 0);
+
+            printf("%7d  %7d  %12.0f  %14.2f  %7.2fx  %9s\n", n, pool->threads, rate,
+                   rate * n / 1e6, rate / single_rate, identical ? "yes" : "NO");
+            fflush(stdout);
+            swarm_pool_destroy(pool);
+        }
+    }
+
+    free(inputs);
+    free(reference);
+    free(drones);
+    free(incoming);
+    world_free(&world);
+    return 0;
+}
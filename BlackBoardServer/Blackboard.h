@@ -2,6 +2,7 @@
 #define BLACKBOARD_H
 
 #include <sys/types.h>
+#include <stdint.h>
 #include "../common.h"
 
 // Ncurses Colors
@@ -9,17 +10,195 @@
 #define COLOR_OBSTACLE  2
 #define COLOR_TARGET    3
 
+// Tick loop default (overridden by TICK_HZ in param.conf)
+#define DEFAULT_TICK_HZ 33
+
+// Headless runs write their summary here (overridden by STATS_FILE)
+#define DEFAULT_STATS_FILE "headless_stats.txt"
+
+// Tick metrics export (overridden by METRICS_FILE; the mode suffix is appended)
+#define DEFAULT_METRICS_FILE "/tmp/drone_metrics"
+
+// drain_obstacle_pipe() result bits
+#define DRAIN_GOT_OBSTACLES 1
+#define DRAIN_GOT_RESIZE    2
+
+// TICK METRICS
+// Each stage of the tick loop is timed with CLOCK_MONOTONIC into a fixed-bucket
+// histogram; bucket bounds are in microseconds, the last bucket is +Inf.
+#define METRIC_BUCKETS 18
+
+typedef enum {
+    STAGE_DRONE_RX,   // Draining fifoDBB
+    STAGE_NET_RX,     // Obstacles / remote drone from fifoObsBB
+    STAGE_NET_TX,     // Local drone to the network process
+    STAGE_TARGETS,    // Draining target packets (fifoTarBB)
+    STAGE_RENDER,     // draw_map
+    STAGE_PUBLISH,    // Shared board publish (the broadcast)
+    STAGE_RECORD,     // Flight recorder append (after the tick)
+    STAGE_TICK,       // Whole tick, timer expiry handled -> publish done
+    STAGE_COUNT
+} TickStage;
+
+typedef struct {
+    uint64_t buckets[METRIC_BUCKETS];
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+} StageHistogram;
+
+typedef struct {
+    StageHistogram stages[STAGE_COUNT];
+    uint64_t ticks;
+    uint64_t ticks_over_deadline; // Tick body took longer than one period
+    uint64_t ticks_missed;        // Timer expirations dropped after an overrun
+    uint64_t deadline_ns;
+    uint64_t startup_ready_ns;       // Launch -> every child reported ready (or gave up waiting)
+    uint64_t startup_first_frame_ns; // Launch -> first frame rendered / published
+    uint64_t tick_stage_ns[STAGE_COUNT]; // Time per stage since the last tick was recorded
+} TickMetrics;
+
+// FLIGHT RECORDER
+// Every tick the world, the player inputs the server received and the stage times
+// are appended to a fixed-size file mapped with MAP_SHARED, so the last stretch of
+// the run outlives a crash or a kill of the server. The file is a ring of blocks;
+// each block opens with a keyframe and the following ticks are stored as the XOR
+// against the previous world image, run-length encoded. A full block is left as it
+// is and the oldest block is reused, so any surviving block decodes on its own.
+#define DEFAULT_RECORDER_FILE "/tmp/drone_flight" // The mode suffix and ".rec" are appended
+#define DEFAULT_RECORDER_MB 16                    // RECORDER_MB=0 turns the recorder off
+#define RECORDER_MAGIC 0x43455244                 // "DREC"
+#define RECORDER_VERSION 1
+#define RECORDER_HEADER_BYTES 4096
+#define RECORDER_BLOCK_MIN (64 * 1024)
+#define RECORDER_INPUTS_MAX 4                     // Player inputs kept per tick
+#define RECORDER_ZERO_RUN 4                       // Unchanged bytes that end a literal run
+#define RECORD_KEYFRAME 1
+
+// Inputs and control events the server received between two ticks
+#define TICK_EVENT_RESET 1
+#define TICK_EVENT_QUIT  2
+
+typedef struct {
+    InputMsg inputs[RECORDER_INPUTS_MAX];
+    uint32_t n_inputs;
+    uint32_t events; // TICK_EVENT_*
+} TickInputs;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t block_size;
+    uint32_t n_blocks;
+    uint32_t stage_count;
+    uint32_t max_obstacles, max_targets, max_agents;
+    uint64_t tick_ns;
+    uint64_t mono_base_ns;     // Pairs the records' monotonic stamps...
+    uint64_t real_base_ns;     // ...with wall-clock time
+    _Atomic uint64_t next_seq; // Sequence number the next block gets
+} RecorderHeader;
+
+// At the start of every block; 'seq' 0 means the block was never written
+typedef struct {
+    _Atomic uint64_t seq;
+    _Atomic uint32_t used;     // Bytes of complete records after this header
+    uint32_t records;
+} RecorderBlock;
+
+// One tick. Followed by n_inputs InputMsg, stage_count varint stage times (ns) and the
+// delta: varint pairs (unchanged bytes, changed bytes) each followed by the changed
+// bytes XORed with the previous image. Bytes past the last pair are unchanged.
+typedef struct {
+    uint32_t len;        // Whole record, padded to 8 bytes
+    uint32_t tick;
+    uint64_t t_ns;       // monotonic_ns() after the publish
+    uint32_t image_len;  // Bytes of the world image after this tick
+    uint16_t flags;      // RECORD_KEYFRAME: the delta is against an all-zero image
+    uint16_t n_inputs;
+    uint32_t events;
+    uint32_t reserved;
+} FlightRecord;
+
+// The world image: this head, then n_obstacles Obstacle, n_targets Target, n_agents DroneState
+typedef struct {
+    DroneState drone;
+    int32_t score;
+    int32_t game_active;
+    int32_t n_obstacles;
+    int32_t n_targets;
+    int32_t n_agents;
+    int32_t reserved;
+} WorldImageHead;
+
+typedef struct {
+    int fd;
+    uint8_t *map;
+    size_t size;
+    RecorderHeader *header;
+    uint32_t block;       // Block being filled
+    uint8_t *image;       // This tick's world image
+    uint8_t *prev;        // The previous one
+    uint8_t *diff;
+    uint8_t *record;      // Encoding buffer
+    size_t image_cap;
+    size_t prev_len;
+} FlightRecorder;
+
 // FUNCTIONS
 
 // Handles the startup menu
 void prompt_for_mode();
 
-// Function to spawn a child process
+// Function to spawn a child process (a thread for subsystems registered below)
 pid_t spawn_process(const char *program, char *arg_list[]);
 
+// THREADED BUILD (ThreadedServer.c)
+// Entry point of a subsystem that can run as a thread of the server
+typedef int (*SubsystemMain)(int argc, char *argv[]);
+void register_thread_subsystem(const char *program, SubsystemMain entry);
+int subsystem_runs_in_thread(const char *program);
+// Waits for the subsystem threads; they stop once the board is closed
+void join_subsystem_threads(void);
+
+// TICK LOOP (epoll reactor)
+int create_tick_timer(int period_us);
+int reactor_watch(int epoll_fd, int fd);
+int drain_drone_pipe(FrameReader *reader, WorldState *world, TickInputs *inputs);
+int drain_obstacle_pipe(FrameReader *reader, WorldState *world, ResizeMsg *resize);
+int drain_target_pipe(FrameReader *reader, WorldState *world, uint32_t first_valid_tick);
+
 // Initialize NCURSES
 void init_console();
 
+// Draws the map, touching only the cells that changed since the last frame
 void draw_map(WorldState *world);
 
+// Renderer behind draw_map(); returns the number of cells that changed (0 = no refresh)
+int render_frame(const DroneState *drone, const DroneState agents[], int n_agents,
+                 const Obstacle obstacles[], int n_obstacles,
+                 const Target targets[], int n_targets, int score);
+void render_invalidate(void);
+
+// Headless end-of-run summary (ticks/sec, score, startup times, CPU time of server and children)
+void write_run_stats(const char *path, const TickMetrics *metrics, double wall_s, int score);
+
+// TICK METRICS (Metrics_functions.c)
+void metrics_record(TickMetrics *metrics, TickStage stage, uint64_t elapsed_ns);
+uint64_t metrics_quantile_ns(const StageHistogram *hist, double q);
+const char *metrics_stage_name(TickStage stage);
+// Prometheus text exposition, written to a temp file and renamed into place.
+// With a board, the watchdog's per-process heartbeat counters are exported too.
+int metrics_write(const TickMetrics *metrics, SharedBoard *board, const char *path);
+
+// FLIGHT RECORDER (Recorder_functions.c)
+// Maps a fresh recording of 'megabytes' at 'path'; the previous one is kept as <path>.prev
+int recorder_open(FlightRecorder *rec, const char *path, size_t megabytes, const WorldState *world, uint64_t tick_ns);
+void recorder_append(FlightRecorder *rec, const WorldState *world, const TickInputs *inputs,
+                     const uint64_t stage_ns[STAGE_COUNT], uint64_t t_ns);
+void recorder_close(FlightRecorder *rec);
+size_t recorder_image_size(int max_obstacles, int max_targets, int max_agents);
+// Rebuilds the world image of a record in place; returns -1 if the record is damaged
+int recorder_decode(const FlightRecord *record, const uint8_t *end, uint8_t *image, size_t image_cap,
+                    size_t *image_len, uint64_t stage_ns[], uint32_t stage_count);
+
 #endif 
@@ -10,6 +10,8 @@
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
+#include <stdint.h>
+#include <sys/epoll.h>
 #include "Blackboard.h"
 #include "../common.h"
 
@@ -21,25 +23,28 @@
 */
 
 // GLOBAL FLAG FOR CLEANUP
-volatile sig_atomic_t keep_running = 1;
+static volatile sig_atomic_t keep_running = 1;
 
 // Operation Mode
 int operation_mode = 0; // 0=Standalone, 1=Server, 2=Client
 
 // Global PIDs to track children
-pid_t pid_drone = 0;
-pid_t pid_keyboard = 0;
-pid_t pid_obst = 0;
-pid_t pid_targ = 0;
-pid_t pid_wd = 0;
+static pid_t pid_drone = 0;
+static pid_t pid_keyboard = 0;
+static pid_t pid_obst = 0;
+static pid_t pid_targ = 0;
+static pid_t pid_wd = 0;
 
-void handle_signal(int sig) 
+static void handle_signal(int sig) 
 {
     keep_running = 0;
 }
 
 int main() 
 {
+    // Bring-up is measured from here to the first frame
+    uint64_t t_launch = monotonic_ns();
+
     //Next 3 lines are from Assignment1 fixes
     // REGISTER SIGNALS
     signal(SIGINT, handle_signal);  // Ctrl+C
@@ -57,6 +62,22 @@ int main()
     FILE *f = fopen("param.conf", "r");
     char server_ip[32] = "127.0.0.1";
     int port = 5555; 
+    int tick_hz = DEFAULT_TICK_HZ;
+    int headless = 0;
+    char input_script[256] = "";
+    char stats_file[256] = DEFAULT_STATS_FILE;
+    char metrics_file[256] = DEFAULT_METRICS_FILE;
+    char recorder_file[256] = DEFAULT_RECORDER_FILE;
+    int recorder_mb = DEFAULT_RECORDER_MB;
+    int max_obstacles = DEFAULT_MAX_OBSTACLES;
+    int max_targets = DEFAULT_MAX_TARGETS;
+    int n_drones = DEFAULT_DRONES;
+    int drone_threads = 0; // 0 = one per CPU
+    unsigned long long seed = 0; // 0 = a different world every run
+    char integrator[16] = "semi"; // Drone physics, see DroneController.h
+    int substeps = 1;
+    char net_protocol[16] = "snapshot"; // Offered to the peer: "snapshot", "binary", or "text" for the old exchange
+    char net_transport[16] = "tcp"; // "udp" offers the binary stream over datagrams
 
     if (f) 
     {
@@ -67,58 +88,164 @@ int main()
             if (strstr(line, "MODE=client")) operation_mode = 2;
             if (strstr(line, "SERVER_IP=")) sscanf(line, "SERVER_IP=%s", server_ip);
             if (strstr(line, "PORT=")) sscanf(line, "PORT=%d", &port);
+            if (strstr(line, "TICK_HZ=")) sscanf(line, "TICK_HZ=%d", &tick_hz);
+            if (strstr(line, "HEADLESS=")) sscanf(line, "HEADLESS=%d", &headless);
+            if (strstr(line, "INPUT_SCRIPT=")) sscanf(line, "INPUT_SCRIPT=%255s", input_script);
+            if (strstr(line, "STATS_FILE=")) sscanf(line, "STATS_FILE=%255s", stats_file);
+            if (strstr(line, "METRICS_FILE=")) sscanf(line, "METRICS_FILE=%255s", metrics_file);
+            if (strstr(line, "RECORDER_FILE=")) sscanf(line, "RECORDER_FILE=%255s", recorder_file);
+            if (strstr(line, "RECORDER_MB=")) sscanf(line, "RECORDER_MB=%d", &recorder_mb);
+            if (strstr(line, "MAX_OBSTACLES=")) sscanf(line, "MAX_OBSTACLES=%d", &max_obstacles);
+            if (strstr(line, "MAX_TARGETS=")) sscanf(line, "MAX_TARGETS=%d", &max_targets);
+            if (strstr(line, "DRONES=")) sscanf(line, "DRONES=%d", &n_drones);
+            if (strstr(line, "DRONE_THREADS=")) sscanf(line, "DRONE_THREADS=%d", &drone_threads);
+            if (strstr(line, "SEED=")) sscanf(line, "SEED=%llu", &seed);
+            if (strstr(line, "INTEGRATOR=")) sscanf(line, "INTEGRATOR=%15s", integrator);
+            if (strstr(line, "SUBSTEPS=")) sscanf(line, "SUBSTEPS=%d", &substeps);
+            if (strstr(line, "NET_PROTOCOL=")) sscanf(line, "NET_PROTOCOL=%15s", net_protocol);
+            if (strstr(line, "NET_TRANSPORT=")) sscanf(line, "NET_TRANSPORT=%15s", net_transport);
         }
         fclose(f);
     }
+    if (headless && input_script[0] == '\0') 
+    {
+        fprintf(stderr, "Server: HEADLESS=1 needs INPUT_SCRIPT=<file> in param.conf\n");
+        exit(EXIT_FAILURE);
+    }
+    if (tick_hz < 1 || tick_hz > 1000) 
+    {
+        log_msg("MAIN", "Invalid TICK_HZ=%d, using %d", tick_hz, DEFAULT_TICK_HZ);
+        tick_hz = DEFAULT_TICK_HZ;
+    }
+    if (max_obstacles < 1 || max_obstacles > ENTITY_CAPACITY_LIMIT) 
+    {
+        log_msg("MAIN", "Invalid MAX_OBSTACLES=%d, using %d", max_obstacles, DEFAULT_MAX_OBSTACLES);
+        max_obstacles = DEFAULT_MAX_OBSTACLES;
+    }
+    if (max_targets < 1 || max_targets > ENTITY_CAPACITY_LIMIT) 
+    {
+        log_msg("MAIN", "Invalid MAX_TARGETS=%d, using %d", max_targets, DEFAULT_MAX_TARGETS);
+        max_targets = DEFAULT_MAX_TARGETS;
+    }
+    if (n_drones < 1 || n_drones > ENTITY_CAPACITY_LIMIT) 
+    {
+        log_msg("MAIN", "Invalid DRONES=%d, using %d", n_drones, DEFAULT_DRONES);
+        n_drones = DEFAULT_DRONES;
+    }
+    int max_agents = n_drones - 1;
 
     // PIPES + check for their errors
     // PIPES + check for their errors
     char fifoDBB[100];   
-    char fifoBBD[100];   
-    char fifoBBDIS[100]; 
-    char fifoBBTar[100]; 
     char fifoTarBB[100];
     char fifoNetRX[100];
     char fifoNetTX[100];
+    char fifoKD[100];
 
     char suffix[50] = "";
     if (operation_mode == 1) strcpy(suffix, "_server");
     else if (operation_mode == 2) strcpy(suffix, "_client");
 
     snprintf(fifoDBB, sizeof(fifoDBB), "/tmp/fifoDBB%s", suffix);
-    snprintf(fifoBBD, sizeof(fifoBBD), "/tmp/fifoBBD%s", suffix);
-    snprintf(fifoBBDIS, sizeof(fifoBBDIS), "/tmp/fifoBBDIS%s", suffix);
-    snprintf(fifoBBTar, sizeof(fifoBBTar), "/tmp/fifoBBTar%s", suffix);
     snprintf(fifoTarBB, sizeof(fifoTarBB), "/tmp/fifoTarBB%s", suffix);
     // NETWORK PIPES: 
     // RX = Network->Board
     // TX = Board->Network
     snprintf(fifoNetRX, sizeof(fifoNetRX), "/tmp/fifoObsBB%s", suffix);
     snprintf(fifoNetTX, sizeof(fifoNetTX), "/tmp/fifoBBObs%s", suffix);
+    snprintf(fifoKD, sizeof(fifoKD), "/tmp/fifoKD%s", suffix);
+
+    // Metrics file is per instance too, so server and client on one box don't clash
+    char metrics_path[320];
+    snprintf(metrics_path, sizeof(metrics_path), "%s%s.prom", metrics_file, suffix);
+    char recorder_path[320];
+    snprintf(recorder_path, sizeof(recorder_path), "%s%s.rec", recorder_file, suffix);
 
     if (mkfifo(fifoDBB, 0666) == -1 && errno != EEXIST) { perror("Server: Failed to create fifoDBB"); exit(EXIT_FAILURE); }
-    if (mkfifo(fifoBBD, 0666) == -1 && errno != EEXIST) { perror("Server: Failed to create fifoBBD"); exit(EXIT_FAILURE); }
-    if (mkfifo(fifoBBDIS, 0666) == -1 && errno != EEXIST) { perror("Server: Failed to create fifoBBDIS"); exit(EXIT_FAILURE); }
     if (mkfifo(fifoNetRX, 0666) == -1 && errno != EEXIST) { perror("Server: Failed to create fifoNetRX"); exit(EXIT_FAILURE); }
     if (mkfifo(fifoNetTX, 0666) == -1 && errno != EEXIST) { perror("Server: Failed to create fifoNetTX"); exit(EXIT_FAILURE); }
+    if (mkfifo(fifoKD, 0666) == -1 && errno != EEXIST) { perror("Server: Failed to create fifoKD"); exit(EXIT_FAILURE); }
     if(operation_mode == 0) // Only create target pipes in standalone mode
     {
-        if (mkfifo(fifoBBTar, 0666) == -1 && errno != EEXIST) { perror("Server: Failed to create fifoBBTar"); exit(EXIT_FAILURE); }
         if (mkfifo(fifoTarBB, 0666) == -1 && errno != EEXIST) { perror("Server: Failed to create fifoTarBB"); exit(EXIT_FAILURE); }
     }
-    
+
+    // SHARED MEMORY BLACKBOARD
+    // Created before the children so they can attach as soon as they start.
+    // Replaces the per-tick copies that went down fifoBBD, fifoBBDIS and fifoBBTar.
+    // It is sized for the configured capacities, which the children read from it.
+    SharedBoard *board = board_create(suffix, max_obstacles, max_targets, max_agents);
+    if (board == NULL) { perror("Server: Failed to create shared board"); exit(EXIT_FAILURE); }
+    board->tick_ns = 1000000000ULL / tick_hz;
+    board->seed = seed;
+
+    // Largest frame on each inbound link
+    size_t obstacles_frame = (size_t)max_obstacles * sizeof(Obstacle);
+    size_t targets_frame = sizeof(TargetPacket) + (size_t)max_targets * sizeof(Target);
+    size_t agents_frame = (size_t)max_agents * sizeof(DroneState);
+
+    // THREADED BUILD
+    // Children that run as threads of this process talk to it over in-process rings
+    // registered under the FIFO paths; everything else keeps its FIFO.
+    int ring_failed = 0;
+    if (subsystem_runs_in_thread("./drone")) 
+    {
+        ring_failed |= link_register(fifoDBB, frame_buffer_size(agents_frame));
+    }
+    if (operation_mode == 0 && subsystem_runs_in_thread("./obstacle_process")) 
+    {
+        ring_failed |= link_register(fifoNetRX, frame_buffer_size(obstacles_frame));
+    }
+    if (operation_mode == 0 && subsystem_runs_in_thread("./target_process")) 
+    {
+        ring_failed |= link_register(fifoTarBB, frame_buffer_size(targets_frame));
+    }
+    if (ring_failed) { perror("Server: Failed to create in-process links"); exit(EXIT_FAILURE); }
+
+    // OPEN OUR ENDS FIRST
+    // Every read end is opened non-blocking before any child exists, so the children's
+    // write-side open() returns at once instead of waiting on the server, and the
+    // children come up in parallel. fifoKD gets a placeholder reader for the same
+    // reason (the keyboard never waits for the drone); it is dropped after the handshake.
+    // O_CLOEXEC keeps the children from inheriting our ends.
+    int fd_DBB = link_open(fifoDBB, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd_DBB == -1) { perror("open read"); exit(1); }
+    int fd_NetRX = link_open(fifoNetRX, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd_NetRX == -1) { perror("open read NetRX"); exit(1); }
+    int fd_TarBB = -1;
+    if (operation_mode == 0)
+    {
+        // Packets are consumed when they arrive, a slow target process never stalls the tick
+        fd_TarBB = link_open(fifoTarBB, O_RDONLY | O_NONBLOCK | O_CLOEXEC); 
+        if (fd_TarBB == -1) { perror("open read TarBB"); exit(1); }
+    }
+    int fd_KD_hold = open(fifoKD, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd_KD_hold == -1) { perror("open read KD"); exit(1); }
+
     // The next code block is from the assigment1 fixes
     // LAUNCH CHILDREN 
     // ALWAYS launch Drone and Keyboard
     // Launch Drone
     // Run children with suffix
-    char *arg_list_drone[] = { "./drone", suffix, NULL };
+    char threads_arg[16], substeps_arg[16];
+    snprintf(threads_arg, sizeof(threads_arg), "%d", drone_threads);
+    snprintf(substeps_arg, sizeof(substeps_arg), "%d", substeps);
+    char *arg_list_drone[] = { "./drone", suffix, threads_arg, integrator, substeps_arg, NULL };
     pid_drone = spawn_process("./drone", arg_list_drone);
-    log_msg("MAIN", "Launched Drone with PID: %d", pid_drone);
+    if (pid_drone > 0) log_msg("MAIN", "Launched Drone with PID: %d", pid_drone);
 
     // Launch Keyboard
-    char *arg_list_kb[] = { "konsole", "-e", "./keyboard", suffix, NULL };
-    pid_keyboard = spawn_process("konsole", arg_list_kb);
+    // Headless: no terminal, the keyboard replays the input script instead
+    if (headless) 
+    {
+        char *arg_list_kb[] = { "./keyboard", suffix, input_script, NULL };
+        pid_keyboard = spawn_process("./keyboard", arg_list_kb);
+    }
+    else 
+    {
+        char *arg_list_kb[] = { "konsole", "-e", "./keyboard", suffix, NULL };
+        pid_keyboard = spawn_process("konsole", arg_list_kb);
+    }
     log_msg("MAIN", "Launched Keyboard Manager with PID: %d", pid_keyboard);
 
     // CONDITIONALLY launch Generators and Watchdog
@@ -128,12 +255,12 @@ int main()
         // Launch Obstacle Process 
         char *arg_list_obs[] = { "./obstacle_process", NULL };
         pid_obst = spawn_process("./obstacle_process", arg_list_obs);
-        log_msg("MAIN", "Launched Obstacle Process with PID: %d", pid_obst);
+        if (pid_obst > 0) log_msg("MAIN", "Launched Obstacle Process with PID: %d", pid_obst);
 
         // Launch Target Process 
         char *arg_list_tar[] = { "./target_process", NULL };
         pid_targ = spawn_process("./target_process", arg_list_tar);
-        log_msg("MAIN", "Launched Target Process with PID: %d", pid_targ);
+        if (pid_targ > 0) log_msg("MAIN", "Launched Target Process with PID: %d", pid_targ);
 
         char *arg_list_wd[] = { "./watchdog", NULL };
         pid_wd = spawn_process("./watchdog", arg_list_wd);
@@ -145,232 +272,332 @@ int main()
         char m[5], p[10];
         sprintf(m, "%d", operation_mode);
         sprintf(p, "%d", port);
-        char *args_n[] = {"./network_process", m, p, server_ip, NULL};
+        char *args_n[] = {"./network_process", m, p, server_ip, net_protocol, net_transport, NULL};
         pid_obst = spawn_process("./network_process", args_n); // Reuse pid_obs
         log_msg("MAIN", "Launched Network Process with PID: %d (IP: %s)", pid_obst, server_ip);
     }
 
-    // Non-blocking open for pipes 
-    int fd_DBB = open(fifoDBB, O_RDWR | O_NONBLOCK);
-    if (fd_DBB == -1) { endwin(); perror("open read"); exit(1); }
-  
-    int fd_BBD = open(fifoBBD, O_WRONLY); 
-    if (fd_BBD == -1) { endwin(); perror("open write BBDIS"); exit(1); }
-
-    int fd_BBDIS = open(fifoBBDIS, O_WRONLY);
-    if (fd_BBDIS == -1) { endwin(); perror("open write BBDIS"); exit(1); }
-
-    // Network Shared Pipes
-    int fd_NetTX = open(fifoNetTX, O_WRONLY);
-    if (fd_NetTX == -1) { endwin(); perror("open write NetTX"); exit(1); }
-    int fd_NetRX = open(fifoNetRX, O_RDONLY | O_NONBLOCK);
-    if (fd_NetRX == -1) { endwin(); perror("open read NetRX"); exit(1); }
-
-    int fd_BBTar = -1;
-    int fd_TarBB = -1;
-
+    // READINESS HANDSHAKE
+    // Every child sets its bit on the board once it is up; a child that never does
+    // costs at most STARTUP_TIMEOUT_MS and is logged, it no longer hangs the bring-up
+    uint32_t expected = 0;
+    if (pid_drone >= 0) expected |= COMPONENT_BIT(COMPONENT_DRONE);
+    if (pid_keyboard >= 0) expected |= COMPONENT_BIT(COMPONENT_KEYBOARD);
     if (operation_mode == 0)
     {
-        fd_BBTar = open(fifoBBTar, O_WRONLY );
-        if (fd_BBTar == -1) { endwin(); perror("open write BBTar"); exit(1); }
-      
-        fd_TarBB = open(fifoTarBB, O_RDONLY); 
-        if (fd_TarBB == -1) { endwin(); perror("open read TarBB"); exit(1); }
+        if (pid_obst >= 0) expected |= COMPONENT_BIT(COMPONENT_OBSTACLES);
+        if (pid_targ >= 0) expected |= COMPONENT_BIT(COMPONENT_TARGETS);
+        if (pid_wd >= 0) expected |= COMPONENT_BIT(COMPONENT_WATCHDOG);
     }
-    
-    // NCURSES INIT
-    init_console();
+    else if (pid_obst >= 0) expected |= COMPONENT_BIT(COMPONENT_NETWORK);
 
-    // CLIENT MODE WINDOW RESIZING
-    if (operation_mode == 2) 
+    int all_ready = board_wait_ready(board, expected, STARTUP_TIMEOUT_MS);
+    uint64_t t_ready = monotonic_ns();
+    for (int c = 0; c < COMPONENT_COUNT; c++)
     {
-        log_msg("MAIN", "Waiting for Server Handshake...");
-        Obstacle pkt[MAX_OBSTACLES];
-        // Blocking read until network finishes handshake
-        ssize_t r = read(fd_NetRX, pkt, sizeof(pkt));
-        if(r > 0 && pkt[0].active == RESIZE_FLAG) 
+        if (!(expected & COMPONENT_BIT(c))) continue;
+        if (board_is_ready(board, c)) 
         {
-            resizeterm(pkt[0].y, pkt[0].x);
-            wresize(stdscr, pkt[0].y, pkt[0].x);
-            erase(); refresh();
-            log_msg("MAIN", "Resized window to %dx%d", pkt[0].x, pkt[0].y);
+            log_msg("MAIN", "Startup: %s ready after %.1f ms", component_name(c), (board->ready_ns[c] - t_launch) / 1e6);
         }
         else 
         {
-            log_msg("MAIN", "Warning: Did not receive valid resize packet from NetworkProcess.");
+            log_msg("MAIN", "Startup: %s not ready after %d ms, carrying on without it", component_name(c), STARTUP_TIMEOUT_MS);
         }
     }
+    if (all_ready) log_msg("MAIN", "Startup: all children ready after %.1f ms", (t_ready - t_launch) / 1e6);
+    close(fd_KD_hold); // The drone holds the read end now
+
+    // Network Shared Pipes
+    // In standalone mode the obstacle process reads the drone from the board,
+    // so only the network process still needs the TX pipe. Its read end is
+    // open once it reported ready; if it did not, fail instead of blocking here.
+    int fd_NetTX = -1;
+    if (operation_mode != 0)
+    {
+        fd_NetTX = link_open(fifoNetTX, O_WRONLY | O_NONBLOCK);
+        if (fd_NetTX == -1) { perror("open write NetTX"); exit(1); }
+        fcntl(fd_NetTX, F_SETFL, fcntl(fd_NetTX, F_GETFL, 0) & ~O_NONBLOCK);
+    }
+    
+    // Every pipe carries framed messages (see FrameHeader in common.h)
+    FrameReader rx_drone, rx_net, rx_targets;
+    if (frame_reader_init(&rx_drone, fd_DBB, frame_buffer_size(agents_frame)) == -1 ||
+        frame_reader_init(&rx_net, fd_NetRX, frame_buffer_size(obstacles_frame)) == -1 ||
+        frame_reader_init(&rx_targets, fd_TarBB, frame_buffer_size(targets_frame)) == -1)
+    {
+        perror("Server: frame reader"); exit(1);
+    }
+    FrameWriter tx_net;
+    frame_writer_init(&tx_net, fd_NetTX);
+
+    // NCURSES INIT
+    if (!headless) init_console();
 
     // DATA INIT 
-    WorldState world = {0};
+    // Entity arrays are allocated once here; ticks never allocate
+    WorldState world;
+    if (world_alloc(&world, max_obstacles, max_targets, max_agents) == -1) { endwin(); perror("Server: world alloc"); exit(1); }
+    log_msg("MAIN", "Capacities: %d obstacles, %d targets, %d drones", max_obstacles, max_targets, n_drones);
     world.drone.x = MAP_WIDTH / 2.0; 
     world.drone.y = MAP_HEIGHT / 2.0;
     world.drone.vx = 0; world.drone.vy = 0;
     world.score = 0;
     world.game_active = 0;
-    TargetPacket tar_pkt;
-
-    for(int i=0; i<MAX_OBSTACLES; i++) world.obstacles[i].active = 0;
-    for(int i=0; i<MAX_TARGETS; i++) world.targets[i].active = 0;
+    uint32_t first_valid_tick = 0; // Target packets for older frames predate a reset
+
+    world.n_obstacles = 0;
+    world.n_targets = 0;
+
+    // First frame, so readers have a valid snapshot before the first tick
+    board_publish(board, &world);
+
+    // REACTOR SETUP
+    // A periodic timerfd gives a fixed tick: its schedule is anchored to the first
+    // expiry, so the time spent inside a tick never shifts the following ones.
+    // The pipes are watched by the same epoll set and handled as soon as they are readable.
+    int tick_us = 1000000 / tick_hz;
+    int fd_timer = create_tick_timer(tick_us);
+    if (fd_timer == -1) { endwin(); perror("Server: timerfd"); exit(1); }
+
+    int fd_epoll = epoll_create1(0);
+    if (fd_epoll == -1) { endwin(); perror("Server: epoll_create1"); exit(1); }
+    if (reactor_watch(fd_epoll, fd_timer) == -1 ||
+        reactor_watch(fd_epoll, fd_DBB) == -1 ||
+        reactor_watch(fd_epoll, fd_NetRX) == -1 ||
+        (fd_TarBB != -1 && reactor_watch(fd_epoll, fd_TarBB) == -1))
+    {
+        endwin(); perror("Server: epoll_ctl"); exit(1);
+    }
+    log_msg("MAIN", "Tick loop running at %d Hz (%d us)", tick_hz, tick_us);
+    heartbeat_start(board, COMPONENT_SERVER, board->tick_ns);
+
+    // TICK METRICS
+    // Exported roughly once per second; 'cat' the file to see where ticks go
+    static TickMetrics metrics;
+    metrics.deadline_ns = (uint64_t)tick_us * 1000ULL;
+    metrics.startup_ready_ns = t_ready - t_launch;
+    struct timespec run_start;
+    clock_gettime(CLOCK_MONOTONIC, &run_start);
+
+    // FLIGHT RECORDER
+    // Every tick goes to a mapped ring file that survives a crash; dump it with ./flight_dump
+    static FlightRecorder recorder = { .fd = -1 };
+    TickInputs tick_inputs;
+    memset(&tick_inputs, 0, sizeof(tick_inputs));
+    if (recorder_mb > 0) 
+    {
+        if (recorder_open(&recorder, recorder_path, (size_t)recorder_mb, &world, board->tick_ns) == -1) 
+        {
+            log_msg("MAIN", "Flight recorder off: cannot map %s (%s)", recorder_path, strerror(errno));
+        }
+        else 
+        {
+            log_msg("MAIN", "Flight recorder: %s, %u blocks of %u KiB", recorder_path,
+                    recorder.header->n_blocks, recorder.header->block_size / 1024);
+        }
+    }
 
     while(keep_running) 
     {
-        // Send heartbeat to the watchdog
-        if (pid_wd > 0) 
+        struct epoll_event events[8];
+        int n_events = epoll_wait(fd_epoll, events, 8, -1);
+        if (n_events == -1) 
         {
-            kill(pid_wd, SIGUSR1);
+            if (errno != EINTR) perror("Server: epoll_wait");
+            continue; // Signals land here; keep_running decides
         }
 
-        // READ INPUT (From Local Drone Controller)
-        DroneState incoming_drone_state;
-        // Drain Pipe Loop
-        while (1) 
+        int tick_due = 0;
+        for (int e = 0; e < n_events; e++) 
         {
-            ssize_t bytesRead = read(fd_DBB, &incoming_drone_state, sizeof(DroneState));
+            int fd = events[e].data.fd;
 
-            if (bytesRead == -1) 
+            if (fd == fd_timer) 
             {
-                if (errno != EAGAIN) perror("Server: Error reading from Drone Pipe (fifoDBB)");
-                break; // No more data
-            } 
-            else if (bytesRead == 0)  
+                // Expirations > 1 means the previous tick overran: run one tick now
+                // and drop the backlog instead of bursting to catch up
+                uint64_t expirations = 0;
+                if (read(fd_timer, &expirations, sizeof(expirations)) == sizeof(expirations)) 
+                {
+                    if (expirations > 1) 
+                    {
+                        metrics.ticks_missed += expirations - 1;
+                        log_msg("SERVER", "Tick overran, skipped %llu tick(s) (total %llu)",
+                                (unsigned long long)(expirations - 1), (unsigned long long)metrics.ticks_missed);
+                    }
+                    tick_due = 1;
+                }
+            }
+            else if (fd == fd_DBB) 
             {
-                log_msg("SERVER", "Drone disconnected.");
-                keep_running = 0;
-                break;
-            } 
-
-            // Process Data
-            if (incoming_drone_state.x == -1.0)
+                // READ INPUT (From Local Drone Controller) as soon as it arrives
+                uint64_t t_stage = monotonic_ns();
+                int drone_status = drain_drone_pipe(&rx_drone, &world, &tick_inputs);
+                if (drone_status == -1) keep_running = 0;
+                else if (drone_status == 1) first_valid_tick = world.tick + 1;
+                metrics_record(&metrics, STAGE_DRONE_RX, monotonic_ns() - t_stage);
+            }
+            else if (fd == fd_NetRX) 
             {
-                log_msg("SERVER", "Detected Quit Signal from Drone.");
-                keep_running = 0; 
-                break;
-            } 
-
-            if (incoming_drone_state.x == -2.0) 
+                // Read Remote Obstacles (Non-blocking)
+                uint64_t t_stage = monotonic_ns();
+                ResizeMsg resize;
+                int net_status = drain_obstacle_pipe(&rx_net, &world, &resize);
+                if (net_status == -1) 
+                {
+                    // Writer is gone: stop watching, otherwise epoll reports the hangup forever
+                    epoll_ctl(fd_epoll, EPOLL_CTL_DEL, fd_NetRX, NULL);
+                }
+                else if (net_status & DRAIN_GOT_RESIZE) 
+                {
+                    // CLIENT MODE WINDOW RESIZING: the network process forwards the server's map size
+                    if (!headless) 
+                    {
+                        resizeterm(resize.height, resize.width);
+                        wresize(stdscr, resize.height, resize.width);
+                        erase(); refresh();
+                        render_invalidate();
+                    }
+                    log_msg("MAIN", "Resized window to %dx%d", resize.width, resize.height);
+                }
+                metrics_record(&metrics, STAGE_NET_RX, monotonic_ns() - t_stage);
+            }
+            else if (fd == fd_TarBB) 
             {
-                // Reset World State
-                world.score = 0;
-                world.game_active = 0;
-
-                // Clear Arrays (Set active = 0)
-                for(int i=0; i<MAX_OBSTACLES; i++) world.obstacles[i].active = 0;
-                for(int i=0; i<MAX_TARGETS; i++) world.targets[i].active = 0;
-                
-                // Reset Drone Position visually
-                world.drone.x = 10.0;
-                world.drone.y = 10.0;
-
-                continue; 
+                // TARGETS (Standalone Only): newest packet wins, every score increment counts once
+                uint64_t t_stage = monotonic_ns();
+                if (drain_target_pipe(&rx_targets, &world, first_valid_tick) == -1) 
+                {
+                    epoll_ctl(fd_epoll, EPOLL_CTL_DEL, fd_TarBB, NULL);
+                }
+                metrics_record(&metrics, STAGE_TARGETS, monotonic_ns() - t_stage);
             }
-            // Update Blackboard State
-            world.drone = incoming_drone_state;
         }
 
+        if (!tick_due || !keep_running) continue;
+        uint64_t t_tick = monotonic_ns();
+        uint64_t t_stage;
+        metrics.ticks++;
+
+        // Heartbeat for the watchdog: a store to the shared table, no signal per tick
+        heartbeat_beat(board, COMPONENT_SERVER);
+
         // CORE LOGIC
-        write(fd_NetTX, &world.drone, sizeof(DroneState));
-        // Read Remote Obstacles (Non-blocking)
-        ssize_t netBytes = read(fd_NetRX, world.obstacles, sizeof(world.obstacles));
-        if (netBytes == -1 && errno != EAGAIN) 
+        if (fd_NetTX != -1) 
         {
-            perror("Server: Error reading from Network RX");
+            t_stage = monotonic_ns();
+            frame_send(&tx_net, MSG_DRONE_STATE, &world.drone, sizeof(DroneState));
+            metrics_record(&metrics, STAGE_NET_TX, monotonic_ns() - t_stage);
         }
 
-        // TARGETS (Standalone Only)
-        if (operation_mode == 0) 
-        {
-            write(fd_BBTar, &world.drone, sizeof(DroneState));
-            read(fd_TarBB, &tar_pkt, sizeof(TargetPacket));
-            memcpy(world.targets, tar_pkt.targets, sizeof(world.targets));
-            world.score += tar_pkt.score_increment;
-        }
-        else 
+        // TARGETS
+        // Standalone: already applied from fifoTarBB as packets arrived
+        if (operation_mode != 0) 
         {
             // Network mode: No targets required by assignment spec
             // Ensure they remain inactive so they don't get drawn
-            for(int i=0; i<MAX_TARGETS; i++) world.targets[i].active = 0;
+            world.n_targets = 0;
         }
 
         // DISPLAY
-        draw_map(&world);
-
-        // BROADCAST 
-        // WRITING OBSTACLES TO DRONE 
-        ssize_t bytesWrittenBBD = write(fd_BBD, world.obstacles, sizeof(world.obstacles));
-        if (bytesWrittenBBD == -1) 
+        if (!headless) 
         {
-            if (errno == EPIPE) 
-            {
-                log_msg("SERVER", "Drone process disconnected (EPIPE). Stopping.");
-                keep_running = 0;
-            } 
-            else 
-            {
-                log_msg("SERVER", "Error writing to Drone Pipe: %s", strerror(errno));
-            }
+            t_stage = monotonic_ns();
+            draw_map(&world);
+            metrics_record(&metrics, STAGE_RENDER, monotonic_ns() - t_stage);
         }
 
-        // WRITING TO KEYBOARD DISPLAY
-        ssize_t bytesWrittenBBDIS = write(fd_BBDIS, &world, sizeof(WorldState));
-        if (bytesWrittenBBDIS == -1) 
+        // BROADCAST 
+        // One seqlock publish replaces the obstacle, display and target pipe writes
+        t_stage = monotonic_ns();
+        world.tick++;
+        board_publish(board, &world);
+        uint64_t t_end = monotonic_ns();
+        metrics_record(&metrics, STAGE_PUBLISH, t_end - t_stage);
+
+        metrics_record(&metrics, STAGE_TICK, t_end - t_tick);
+        if (t_end - t_tick > metrics.deadline_ns) metrics.ticks_over_deadline++;
+
+        // FLIGHT RECORDER: this tick's world, what came in since the last one and where the time went
+        t_stage = monotonic_ns();
+        recorder_append(&recorder, &world, &tick_inputs, metrics.tick_stage_ns, t_end);
+        memset(&tick_inputs, 0, sizeof(tick_inputs));
+        memset(metrics.tick_stage_ns, 0, sizeof(metrics.tick_stage_ns));
+        metrics_record(&metrics, STAGE_RECORD, monotonic_ns() - t_stage);
+
+        // Time to first frame: what a restart costs before the world is visible
+        if (metrics.ticks == 1) 
         {
-            if (errno == EPIPE) 
-            {
-                log_msg("SERVER", "Keyboard process disconnected (EPIPE). Stopping.");
-                keep_running = 0;
-            } 
-            else if (errno != EAGAIN) 
-            { 
-                log_msg("SERVER", "Error writing to Display Pipe: %s", strerror(errno));
-            }
+            metrics.startup_first_frame_ns = t_end - t_launch;
+            log_msg("MAIN", "Startup: first frame %s %.1f ms after launch",
+                    headless ? "published" : "rendered", metrics.startup_first_frame_ns / 1e6);
         }
 
-        usleep(30000); 
+        if (metrics.ticks % tick_hz == 0) metrics_write(&metrics, board, metrics_path);
     }
+    metrics_write(&metrics, board, metrics_path);
 
     // CLEANUP
     log_msg("MAIN", "Stopping system...");
-
-    // Close pipes
-    close(fd_DBB);
-    close(fd_BBD);
-    close(fd_BBDIS);
-    close(fd_NetTX);
-    close(fd_NetRX);
+    recorder_close(&recorder);
+
+    // Close reactor and pipes
+    frame_reader_free(&rx_drone);
+    frame_reader_free(&rx_net);
+    frame_reader_free(&rx_targets);
+    world_free(&world);
+    close(fd_epoll);
+    close(fd_timer);
+    link_close(fd_DBB);
+    if (fd_NetTX != -1) link_close(fd_NetTX);
+    link_close(fd_NetRX);
     if (operation_mode == 0)
     {
-        close(fd_BBTar);
-        close(fd_TarBB);
+        link_close(fd_TarBB);
     }
 
+    // Wake readers blocked on the next frame so they notice the shutdown
+    heartbeat_stop(board, COMPONENT_SERVER);
+    board_close(board);
+
     // Kill children using their PIDs
     if (pid_drone > 0) kill(pid_drone, SIGTERM);
     if (pid_keyboard > 0) kill(pid_keyboard, SIGTERM);
     if (pid_obst > 0) kill(pid_obst, SIGTERM);
     if (pid_targ > 0) kill(pid_targ, SIGTERM);
+    if (pid_wd > 0) kill(pid_wd, SIGTERM); // Orphaned, it would take its new parent down on timeout
     
-    // Wait for them to finish to avoid zombies
-    waitpid(pid_drone, NULL, 0);
-    waitpid(pid_keyboard, NULL, 0);
-    waitpid(pid_obst, NULL, 0);
-    waitpid(pid_targ, NULL, 0);
+    // Wait for them to finish to avoid zombies (0 = not started, or running as a thread)
+    if (pid_drone > 0) waitpid(pid_drone, NULL, 0);
+    if (pid_keyboard > 0) waitpid(pid_keyboard, NULL, 0);
+    if (pid_obst > 0) waitpid(pid_obst, NULL, 0);
+    if (pid_targ > 0) waitpid(pid_targ, NULL, 0);
+    if (pid_wd > 0) waitpid(pid_wd, NULL, 0);
+    join_subsystem_threads();
 
     // Destroy Ncurses window
-    endwin();  
+    if (!headless) endwin();  
+
+    // END-OF-RUN STATS (Headless soak runs)
+    if (headless) 
+    {
+        struct timespec run_end;
+        clock_gettime(CLOCK_MONOTONIC, &run_end);
+        double wall_s = (run_end.tv_sec - run_start.tv_sec) + (run_end.tv_nsec - run_start.tv_nsec) / 1e9;
+        write_run_stats(stats_file, &metrics, wall_s, world.score);
+    }
 
     // Unlink pipes so they don't persist
     // Unlink pipes so they don't persist
     unlink(fifoDBB);
-    unlink(fifoBBD);
-    unlink(fifoBBDIS);
     unlink(fifoNetTX);
     unlink(fifoNetRX);
     if (operation_mode == 0)
     {
-        unlink(fifoBBTar);
         unlink(fifoTarBB);
     }
+    board_destroy(board, suffix);
 
     // Force kill group to ensure terminal windows close
     system("pkill -f drone");
@@ -1,8 +1,15 @@
 #include <stdlib.h>
+#include <stdarg.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/resource.h>
+#include <pthread.h>
 #include <ncurses.h> 
 #include "Blackboard.h"
 #include "../common.h"
@@ -13,9 +20,90 @@
     - Added Error check after initializing ncurses window
 */
 
+// THREADED BUILD
+// Subsystems registered here run as threads of the server instead of child processes
+#define MAX_THREAD_SUBSYSTEMS 4
+#define MAX_SUBSYSTEM_ARGS 8
+
+typedef struct {
+    const char *program;
+    SubsystemMain entry;
+    pthread_t thread;
+    int started;
+    int argc;
+    char *argv[MAX_SUBSYSTEM_ARGS + 1];
+} ThreadSubsystem;
+
+static ThreadSubsystem thread_subsystems[MAX_THREAD_SUBSYSTEMS];
+static int n_thread_subsystems = 0;
+
+void register_thread_subsystem(const char *program, SubsystemMain entry) 
+{
+    if (n_thread_subsystems == MAX_THREAD_SUBSYSTEMS) return;
+    thread_subsystems[n_thread_subsystems].program = program;
+    thread_subsystems[n_thread_subsystems].entry = entry;
+    n_thread_subsystems++;
+}
+
+static ThreadSubsystem *find_thread_subsystem(const char *program) 
+{
+    for (int i = 0; i < n_thread_subsystems; i++) 
+    {
+        if (strcmp(thread_subsystems[i].program, program) == 0) return &thread_subsystems[i];
+    }
+    return NULL;
+}
+
+int subsystem_runs_in_thread(const char *program) 
+{
+    return find_thread_subsystem(program) != NULL;
+}
+
+static void *subsystem_thread_main(void *arg) 
+{
+    ThreadSubsystem *sub = arg;
+    subsystem_mark_thread();
+    int rc = sub->entry(sub->argc, sub->argv);
+    log_msg("MAIN", "Subsystem thread %s returned %d", sub->program, rc);
+    return NULL;
+}
+
+void join_subsystem_threads(void) 
+{
+    for (int i = 0; i < n_thread_subsystems; i++) 
+    {
+        ThreadSubsystem *sub = &thread_subsystems[i];
+        if (!sub->started) continue;
+        pthread_join(sub->thread, NULL);
+        sub->started = 0;
+        for (int a = 0; a < sub->argc; a++) free(sub->argv[a]);
+    }
+}
+
 // Function to spawn a child process
+// (or a thread, for a subsystem registered with register_thread_subsystem(); returns 0 then)
 pid_t spawn_process(const char *program, char *arg_list[]) 
 {
+    ThreadSubsystem *sub = find_thread_subsystem(program);
+    if (sub != NULL) 
+    {
+        sub->argc = 0;
+        while (arg_list[sub->argc] != NULL && sub->argc < MAX_SUBSYSTEM_ARGS) 
+        {
+            sub->argv[sub->argc] = strdup(arg_list[sub->argc]);
+            sub->argc++;
+        }
+        sub->argv[sub->argc] = NULL;
+        if (pthread_create(&sub->thread, NULL, subsystem_thread_main, sub) != 0) 
+        {
+            perror("Error starting subsystem thread");
+            return -1;
+        }
+        sub->started = 1;
+        log_msg("MAIN", "Started %s as a thread", program);
+        return 0;
+    }
+
     pid_t pid = fork();
     if (pid < 0) 
     {
@@ -34,6 +122,226 @@ pid_t spawn_process(const char *program, char *arg_list[])
     return pid;
 }
 
+// Periodic monotonic timer for the tick loop; each expiry makes the fd readable
+int create_tick_timer(int period_us) 
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd == -1) return -1;
+
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = period_us / 1000000;
+    spec.it_interval.tv_nsec = (long)(period_us % 1000000) * 1000L;
+    spec.it_value.tv_sec = 0;
+    spec.it_value.tv_nsec = 1; // First tick right away, so the first frame does not wait a period
+
+    if (timerfd_settime(fd, 0, &spec, NULL) == -1) 
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Add a read-side fd to the reactor
+int reactor_watch(int epoll_fd, int fd) 
+{
+    struct epoll_event ev = {0};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+// Outcome of one frame_fill() on a non-blocking pipe:
+// 1 = got bytes (parse them, then read again), 0 = drained, -1 = writer closed the pipe
+static int fill_status(ssize_t bytesRead, const char *pipe_name)
+{
+    if (bytesRead > 0) return 1;
+    if (bytesRead == 0) return -1;
+    if (errno != EAGAIN) perror(pipe_name);
+    return 0;
+}
+
+// Drain every pending frame from the drone pipe into the world.
+// Player inputs and resets/quits are noted in 'inputs' (may be NULL) for the flight recorder.
+// Returns -1 when the drone quit or disconnected, 1 if the game was reset, 0 otherwise.
+int drain_drone_pipe(FrameReader *reader, WorldState *world, TickInputs *inputs) 
+{
+    int result = 0;
+    int status;
+    FrameHeader hdr;
+    const void *payload;
+
+    // Parse after every read so a burst larger than the buffer never overflows it
+    while (1) 
+    {
+        status = fill_status(frame_fill(reader), "Server: Error reading from Drone Pipe (fifoDBB)");
+        while (frame_next(reader, &hdr, &payload)) 
+        {
+            switch (hdr.type) 
+            {
+                case MSG_QUIT:
+                    log_msg("SERVER", "Detected Quit Signal from Drone.");
+                    if (inputs) inputs->events |= TICK_EVENT_QUIT;
+                    return -1;
+
+                case MSG_INPUT:
+                    // The player's input as the drone applied it, for the flight recorder.
+                    // Past RECORDER_INPUTS_MAX in one tick the newest replaces the last one kept.
+                    if (hdr.length != sizeof(InputMsg)) break;
+                    // 's' starts the drone flying; 'r' also comes as MSG_RESET, which pauses it
+                    if (((const InputMsg *)payload)->command == 's') world->game_active = 1;
+                    if (inputs == NULL) break;
+                    if (inputs->n_inputs < RECORDER_INPUTS_MAX) inputs->n_inputs++;
+                    memcpy(&inputs->inputs[inputs->n_inputs - 1], payload, sizeof(InputMsg));
+                    break;
+
+                case MSG_RESET:
+                    // Reset World State
+                    world->score = 0;
+                    world->game_active = 0;
+
+                    // Clear Arrays
+                    world_set_obstacles(world, NULL, 0);
+                    world->n_targets = 0;
+                
+                    // Reset Drone Position visually (the agents' come with the next MSG_AGENTS)
+                    world->drone.x = 10.0;
+                    world->drone.y = 10.0;
+
+                    if (inputs) inputs->events |= TICK_EVENT_RESET;
+                    result = 1;
+                    break;
+
+                case MSG_DRONE_STATE:
+                    // Update Blackboard State
+                    if (hdr.length == sizeof(DroneState)) memcpy(&world->drone, payload, sizeof(DroneState));
+                    break;
+
+                case MSG_AGENTS:
+                    // The drone process sends every agent it flies; keep what the board has room for
+                    if (hdr.length % sizeof(DroneState) != 0) break;
+                    world->n_agents = hdr.length / sizeof(DroneState);
+                    if (world->n_agents > world->max_agents) world->n_agents = world->max_agents;
+                    memcpy(world->agents, payload, (size_t)world->n_agents * sizeof(DroneState));
+                    break;
+
+                default:
+                    log_msg("SERVER", "Warning: unexpected frame type %u on drone pipe", hdr.type);
+                    break;
+            }
+        }
+        if (status != 1) break;
+    }
+
+    if (status == -1) 
+    {
+        log_msg("SERVER", "Drone disconnected.");
+        return -1;
+    }
+    return result;
+}
+
+// Drain the obstacle pipe (obstacle generator, or the network process in networked mode).
+// Obstacles are taken from the newest frame; a MSG_RESIZE frame is copied into
+// 'resize' and flagged through the return value.
+// Returns -1 if the writer is gone, otherwise a mask of DRAIN_GOT_OBSTACLES / DRAIN_GOT_RESIZE.
+int drain_obstacle_pipe(FrameReader *reader, WorldState *world, ResizeMsg *resize) 
+{
+    int result = 0;
+    int status;
+    FrameHeader hdr;
+    const void *payload;
+
+    // Parse after every read so a burst larger than the buffer never overflows it
+    while (1) 
+    {
+        status = fill_status(frame_fill(reader), "Server: Error reading from Obstacle Pipe (fifoObsBB)");
+        while (frame_next(reader, &hdr, &payload)) 
+        {
+            if (hdr.type == MSG_OBSTACLES && hdr.length % sizeof(Obstacle) == 0) 
+            {
+                // Variable-length: the frame replaces the whole obstacle set
+                world_set_obstacles(world, payload, hdr.length / sizeof(Obstacle));
+                result |= DRAIN_GOT_OBSTACLES;
+            } 
+            else if (hdr.type == MSG_RESIZE && hdr.length == sizeof(ResizeMsg)) 
+            {
+                memcpy(resize, payload, sizeof(ResizeMsg));
+                result |= DRAIN_GOT_RESIZE;
+            } 
+            else 
+            {
+                log_msg("SERVER", "Warning: unexpected frame type %u (%u bytes) on obstacle pipe", hdr.type, hdr.length);
+            }
+        }
+        if (status != 1) break;
+    }
+
+    if (status == -1) 
+    {
+        log_msg("SERVER", "Obstacle/network process disconnected.");
+        return -1;
+    }
+    return result;
+}
+
+// Consume every pending target frame without blocking.
+// Targets come from the newest packet; the score increment of every packet is
+// added exactly once (each frame is parsed once), except for packets computed
+// for frames before 'first_valid_tick' (i.e. before a reset).
+// Returns the number of packets read, or -1 if the target process is gone.
+int drain_target_pipe(FrameReader *reader, WorldState *world, uint32_t first_valid_tick) 
+{
+    TargetPacket pkt;
+    int packets = 0;
+    int have_targets = 0;
+    uint32_t newest_tick = 0;
+    int status;
+    FrameHeader hdr;
+    const void *payload;
+
+    // Parse after every read so a burst larger than the buffer never overflows it
+    while (1) 
+    {
+        status = fill_status(frame_fill(reader), "Server: Error reading from Target Pipe (fifoTarBB)");
+        while (frame_next(reader, &hdr, &payload)) 
+        {
+            if (hdr.type != MSG_TARGETS || hdr.length < sizeof(TargetPacket)) 
+            {
+                log_msg("SERVER", "Warning: unexpected frame type %u (%u bytes) on target pipe", hdr.type, hdr.length);
+                continue;
+            }
+            memcpy(&pkt, payload, sizeof(TargetPacket));
+            if (hdr.length != sizeof(TargetPacket) + (size_t)pkt.count * sizeof(Target)) 
+            {
+                log_msg("SERVER", "Warning: target frame of %u bytes does not hold %u targets", hdr.length, pkt.count);
+                continue;
+            }
+            packets++;
+
+            if (pkt.tick < first_valid_tick) continue; // Earned before a reset
+
+            world->score += pkt.score_increment;
+            if (!have_targets || pkt.tick >= newest_tick) 
+            {
+                int n = (pkt.count > (uint32_t)world->max_targets) ? world->max_targets : (int)pkt.count;
+                memcpy(world->targets, (const unsigned char *)payload + sizeof(TargetPacket), (size_t)n * sizeof(Target));
+                world->n_targets = n;
+                newest_tick = pkt.tick;
+                have_targets = 1;
+            }
+        }
+        if (status != 1) break;
+    }
+
+    if (status == -1) 
+    {
+        log_msg("SERVER", "Target process disconnected.");
+        return -1;
+    }
+    return packets;
+}
+
 // Initialize NCURSES
 void init_console() 
 {
@@ -52,94 +360,191 @@ void init_console()
     init_pair(COLOR_TARGET, COLOR_GREEN, COLOR_BLACK);
 }
 
-void draw_map(WorldState *world) 
+// INCREMENTAL RENDERER
+// 'front' mirrors what has already been handed to ncurses, 'back' is the frame
+// being composed. Only cells that differ are written, and a frame with no
+// differences skips refresh() entirely.
+static chtype *fb_front = NULL;
+static chtype *fb_back = NULL;
+static int fb_rows = 0;
+static int fb_cols = 0;
+
+#define FB_INVALID ((chtype)-1) // Never a real cell: forces a repaint
+
+// (Re)allocate the buffers when the terminal size changes (never per frame)
+static int fb_fit_screen(void)
+{
+    if (fb_front && fb_rows == LINES && fb_cols == COLS) return 0;
+
+    free(fb_front);
+    free(fb_back);
+    fb_rows = LINES;
+    fb_cols = COLS;
+    fb_front = malloc(sizeof(chtype) * fb_rows * fb_cols);
+    fb_back = malloc(sizeof(chtype) * fb_rows * fb_cols);
+    if (fb_front == NULL || fb_back == NULL) 
+    {
+        free(fb_front); free(fb_back);
+        fb_front = fb_back = NULL;
+        fb_rows = fb_cols = 0;
+        return -1;
+    }
+    for (int i = 0; i < fb_rows * fb_cols; i++) fb_front[i] = FB_INVALID;
+    clear(); // Screen content is unknown after a resize
+    return 0;
+}
+
+static inline void fb_put(int y, int x, chtype cell)
+{
+    if (y >= 0 && y < fb_rows && x >= 0 && x < fb_cols) fb_back[y * fb_cols + x] = cell;
+}
+
+static void fb_print(int y, int x, chtype attr, const char *format, ...)
+{
+    char text[128];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    for (int i = 0; text[i] != '\0'; i++) fb_put(y, x + i, (unsigned char)text[i] | attr);
+}
+
+// Map coords -> screen cell inside the box
+static void map_to_screen(double x, double y, int *sx, int *sy)
+{
+    float scale_x = (float)fb_cols / MAP_WIDTH;
+    float scale_y = (float)fb_rows / MAP_HEIGHT;
+    *sx = (int)(x * scale_x);
+    *sy = (int)(y * scale_y);
+    if (*sx >= fb_cols-1) *sx = fb_cols-2;
+    if (*sy >= fb_rows-1) *sy = fb_rows-2;
+    if (*sx < 1) *sx = 1;
+    if (*sy < 1) *sy = 1;
+}
+
+// Forget what is on screen: the next frame repaints every cell
+void render_invalidate(void)
+{
+    for (int i = 0; i < fb_rows * fb_cols; i++) fb_front[i] = FB_INVALID;
+}
+
+int render_frame(const DroneState *drone, const DroneState agents[], int n_agents,
+                 const Obstacle obstacles[], int n_obstacles,
+                 const Target targets[], int n_targets, int score) 
 {
     extern int operation_mode; 
 
-    erase(); 
-    
-    // 1. Draw Borders & Header
-    box(stdscr, 0, 0);
-    
-    // Determine Mode String for Display
-    char mode_str[20];
-    if (operation_mode == 0) strcpy(mode_str, " LOCAL ");
-    else if (operation_mode == 1) strcpy(mode_str, " SERVER ");
-    else strcpy(mode_str, " CLIENT ");
-
-    // Print Header
-    attron(A_BOLD);
-    mvprintw(0, 2, " Mode:%s", mode_str);
-    mvprintw(0, 25, " Score: %d ", world->score);
-    
-    // Optional: Show Window Size to debug resizing
-    mvprintw(0, 45, " Window: %dx%d ", COLS, LINES); 
-    attroff(A_BOLD);
-
-    // Scaling Factors (Map Coords -> Screen Coords)
-    float scale_x = (float)COLS / MAP_WIDTH;
-    float scale_y = (float)LINES / MAP_HEIGHT;
-
-    // 2. Draw Obstacles (and Remote Drone)
-    attron(COLOR_PAIR(COLOR_OBSTACLE));
-    for(int i=0; i<MAX_OBSTACLES; i++) 
-    {
-        if(world->obstacles[i].active) 
-        {
-            int screen_x = (int)(world->obstacles[i].x * scale_x);
-            int screen_y = (int)(world->obstacles[i].y * scale_y);
-            
-            // Bounds check to keep inside box
-            if(screen_x >= COLS-1) screen_x = COLS-2;
-            if(screen_y >= LINES-1) screen_y = LINES-2;
-            if(screen_x < 1) screen_x = 1;
-            if(screen_y < 1) screen_y = 1;
-            
-            // If we are in Network Mode, the obstacle at Index 0 is the Remote Drone.
-            // We draw it as 'X' to distinguish it.
-            if (operation_mode != 0 && i == 0) 
-            {
-                 mvaddch(screen_y, screen_x, 'X' | A_BOLD); // Remote Drone
-            } 
-            else 
-            {
-                 mvaddch(screen_y, screen_x, 'O'); // Normal Obstacle
-            }
-        }
+    if (fb_fit_screen() == -1) return -1;
+
+    // 1. Borders & Header
+    for (int i = 0; i < fb_rows * fb_cols; i++) fb_back[i] = ' ';
+    for (int x = 1; x < fb_cols - 1; x++) 
+    {
+        fb_put(0, x, ACS_HLINE);
+        fb_put(fb_rows - 1, x, ACS_HLINE);
+    }
+    for (int y = 1; y < fb_rows - 1; y++) 
+    {
+        fb_put(y, 0, ACS_VLINE);
+        fb_put(y, fb_cols - 1, ACS_VLINE);
     }
-    attroff(COLOR_PAIR(COLOR_OBSTACLE));
+    fb_put(0, 0, ACS_ULCORNER);
+    fb_put(0, fb_cols - 1, ACS_URCORNER);
+    fb_put(fb_rows - 1, 0, ACS_LLCORNER);
+    fb_put(fb_rows - 1, fb_cols - 1, ACS_LRCORNER);
+
+    const char *mode_str = " CLIENT ";
+    if (operation_mode == 0) mode_str = " LOCAL ";
+    else if (operation_mode == 1) mode_str = " SERVER ";
+
+    fb_print(0, 2, A_BOLD, " Mode:%s", mode_str);
+    fb_print(0, 25, A_BOLD, " Score: %d ", score);
+    fb_print(0, 45, A_BOLD, " Window: %dx%d ", fb_cols, fb_rows);
 
-    // 3. Draw Targets
-    attron(COLOR_PAIR(COLOR_TARGET));
-    for(int i=0; i<MAX_TARGETS; i++) 
+    // 2. Obstacles (and Remote Drone at index 0 in Network Mode)
+    int sx, sy;
+    for (int i = 0; i < n_obstacles; i++) 
     {
-        if(world->targets[i].active) 
+        if (!obstacles[i].active) continue;
+        map_to_screen(obstacles[i].x, obstacles[i].y, &sx, &sy);
+        if (operation_mode != 0 && i == 0) fb_put(sy, sx, 'X' | A_BOLD | COLOR_PAIR(COLOR_OBSTACLE));
+        else fb_put(sy, sx, 'O' | COLOR_PAIR(COLOR_OBSTACLE));
+    }
+
+    // 3. Targets
+    for (int i = 0; i < n_targets; i++) 
+    {
+        if (!targets[i].active) continue;
+        map_to_screen(targets[i].x, targets[i].y, &sx, &sy);
+        fb_put(sy, sx, 'T' | COLOR_PAIR(COLOR_TARGET));
+    }
+
+    // 4. Agents, then the Local Drone on top
+    for (int i = 0; i < n_agents; i++) 
+    {
+        map_to_screen(agents[i].x, agents[i].y, &sx, &sy);
+        fb_put(sy, sx, '*' | COLOR_PAIR(COLOR_DRONE));
+    }
+    map_to_screen(drone->x, drone->y, &sx, &sy);
+    fb_put(sy, sx, '+' | COLOR_PAIR(COLOR_DRONE));
+
+    // 5. Push only the dirty cells
+    int changed = 0;
+    for (int y = 0; y < fb_rows; y++) 
+    {
+        for (int x = 0; x < fb_cols; x++) 
         {
-            int screen_x = (int)(world->targets[i].x * scale_x);
-            int screen_y = (int)(world->targets[i].y * scale_y);
-            
-            if(screen_x >= COLS-1) screen_x = COLS-2;
-            if(screen_y >= LINES-1) screen_y = LINES-2;
-            if(screen_x < 1) screen_x = 1;
-            if(screen_y < 1) screen_y = 1;
-
-            mvaddch(screen_y, screen_x, 'T');
+            int idx = y * fb_cols + x;
+            if (fb_back[idx] == fb_front[idx]) continue;
+            mvaddch(y, x, fb_back[idx]);
+            fb_front[idx] = fb_back[idx];
+            changed++;
         }
     }
-    attroff(COLOR_PAIR(COLOR_TARGET));
 
-    // 4. Draw Local Drone
-    attron(COLOR_PAIR(COLOR_DRONE));
-    int drone_screen_x = (int)(world->drone.x * scale_x);
-    int drone_screen_y = (int)(world->drone.y * scale_y);
-    
-    if(drone_screen_x >= COLS-1) drone_screen_x = COLS-2;
-    if(drone_screen_y >= LINES-1) drone_screen_y = LINES-2;
-    if(drone_screen_x < 1) drone_screen_x = 1;
-    if(drone_screen_y < 1) drone_screen_y = 1;
+    if (changed > 0) refresh();
+    return changed;
+}
 
-    mvaddch(drone_screen_y, drone_screen_x, '+');
-    attroff(COLOR_PAIR(COLOR_DRONE));
+void draw_map(WorldState *world) 
+{
+    render_frame(&world->drone, world->agents, world->n_agents, world->obstacles, world->n_obstacles,
+                 world->targets, world->n_targets, world->score);
+}
+
+// Headless end-of-run summary. Called after the children were reaped so
+// RUSAGE_CHILDREN covers drone, keyboard, generators and watchdog.
+void write_run_stats(const char *path, const TickMetrics *metrics, double wall_s, int score) 
+{
+    unsigned long long ticks = metrics->ticks;
+    unsigned long long missed = metrics->ticks_missed;
+    struct rusage self, children;
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
 
-    refresh();
+    double cpu_self = self.ru_utime.tv_sec + self.ru_stime.tv_sec +
+                      (self.ru_utime.tv_usec + self.ru_stime.tv_usec) / 1e6;
+    double cpu_children = children.ru_utime.tv_sec + children.ru_stime.tv_sec +
+                          (children.ru_utime.tv_usec + children.ru_stime.tv_usec) / 1e6;
+    double tps = wall_s > 0 ? ticks / wall_s : 0.0;
+
+    log_msg("MAIN", "Run stats: %llu ticks in %.2f s (%.1f ticks/s), %llu missed, score %d, CPU %.3f s server + %.3f s children",
+            ticks, wall_s, tps, missed, score, cpu_self, cpu_children);
+
+    FILE *f = fopen(path, "w");
+    if (f == NULL) 
+    {
+        perror("Server: cannot write stats file");
+        return;
+    }
+    fprintf(f, "ticks=%llu\n", ticks);
+    fprintf(f, "ticks_missed=%llu\n", missed);
+    fprintf(f, "wall_seconds=%.3f\n", wall_s);
+    fprintf(f, "ticks_per_second=%.2f\n", tps);
+    fprintf(f, "score=%d\n", score);
+    fprintf(f, "startup_ready_ms=%.3f\n", metrics->startup_ready_ns / 1e6);
+    fprintf(f, "first_frame_ms=%.3f\n", metrics->startup_first_frame_ns / 1e6);
+    fprintf(f, "cpu_seconds_server=%.3f\n", cpu_self);
+    fprintf(f, "cpu_seconds_children=%.3f\n", cpu_children);
+    fclose(f);
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Blackboard.h"
+#include "../common.h"
+
+/* FlightDump.c - Prints what the flight recorder kept (make -> ./flight_dump)
+   Usage: ./flight_dump [-s seconds] [-e] [file]
+     -s  only the last 'seconds' of the recording
+     -e  also list every obstacle, target and agent of each tick
+   The file defaults to the standalone recording; the one of the previous run is
+   <file>.prev. Works on the file of a running server too: a block that gets
+   reused while it is being read is skipped.
+*/
+
+typedef struct {
+    uint32_t index;
+    uint64_t seq;
+} BlockOrder;
+
+static int cmp_block(const void *a, const void *b)
+{
+    uint64_t x = ((const BlockOrder *)a)->seq, y = ((const BlockOrder *)b)->seq;
+    return (x > y) - (x < y);
+}
+
+static void print_tick(const RecorderHeader *header, const FlightRecord *record, const uint8_t *image,
+                       const uint64_t stage_ns[], int entities)
+{
+    // Wall clock of the tick, from the pair of bases in the header
+    uint64_t wall = header->real_base_ns + (record->t_ns - header->mono_base_ns);
+    time_t sec = (time_t)(wall / 1000000000ULL);
+    struct tm tm;
+    char date[32];
+    localtime_r(&sec, &tm);
+    strftime(date, sizeof(date), "%H:%M:%S", &tm);
+
+    WorldImageHead head;
+    memcpy(&head, image, sizeof(head));
+    printf("%s.%03u tick %u%s pos (%.2f, %.2f) vel (%.2f, %.2f) force (%.2f, %.2f) score %d %s obs %d tgt %d agents %d",
+           date, (unsigned)((wall / 1000000ULL) % 1000), record->tick, (record->flags & RECORD_KEYFRAME) ? "*" : "",
+           head.drone.x, head.drone.y, head.drone.vx, head.drone.vy, head.drone.force_x, head.drone.force_y,
+           head.score, head.game_active ? "flying" : "paused", head.n_obstacles, head.n_targets, head.n_agents);
+
+    const InputMsg *inputs = (const InputMsg *)(record + 1);
+    for (int i = 0; i < record->n_inputs; i++)
+    {
+        printf(" | input (%.2f, %.2f)", inputs[i].force_x, inputs[i].force_y);
+        if (inputs[i].command != 0) printf(" '%c'", inputs[i].command);
+    }
+    if (record->events & TICK_EVENT_RESET) printf(" | RESET");
+    if (record->events & TICK_EVENT_QUIT) printf(" | QUIT");
+
+    // Stage times in microseconds, the ones that saw any time
+    printf(" |");
+    for (uint32_t s = 0; s < header->stage_count; s++)
+    {
+        if (stage_ns[s] > 0) printf(" %s %.1f", metrics_stage_name(s), stage_ns[s] / 1e3);
+    }
+    printf("\n");
+
+    if (!entities) return;
+    const uint8_t *p = image + sizeof(head);
+    for (int i = 0; i < head.n_obstacles; i++, p += sizeof(Obstacle))
+    {
+        Obstacle o;
+        memcpy(&o, p, sizeof(o));
+        if (o.active) printf("    obstacle %d at %d,%d timer %d\n", i, o.x, o.y, o.timer);
+    }
+    for (int i = 0; i < head.n_targets; i++, p += sizeof(Target))
+    {
+        Target t;
+        memcpy(&t, p, sizeof(t));
+        if (t.active) printf("    target %d at %d,%d value %d\n", i, t.x, t.y, t.value);
+    }
+    for (int i = 0; i < head.n_agents; i++, p += sizeof(DroneState))
+    {
+        DroneState d;
+        memcpy(&d, p, sizeof(d));
+        printf("    agent %d at (%.2f, %.2f) vel (%.2f, %.2f)\n", i + 1, d.x, d.y, d.vx, d.vy);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    double seconds = 0.0;
+    int entities = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:e")) != -1)
+    {
+        if (opt == 's') seconds = atof(optarg);
+        else if (opt == 'e') entities = 1;
+        else
+        {
+            fprintf(stderr, "Usage: %s [-s seconds] [-e] [file]\n", argv[0]);
+            return 1;
+        }
+    }
+    char default_path[320];
+    snprintf(default_path, sizeof(default_path), "%s.rec", DEFAULT_RECORDER_FILE);
+    const char *path = (optind < argc) ? argv[optind] : default_path;
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) { perror(path); return 1; }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < RECORDER_HEADER_BYTES) { fprintf(stderr, "%s: not a recording\n", path); return 1; }
+    uint8_t *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) { perror("mmap"); return 1; }
+
+    const RecorderHeader *header = (const RecorderHeader *)map;
+    if (header->magic != RECORDER_MAGIC || header->version != RECORDER_VERSION ||
+        RECORDER_HEADER_BYTES + (size_t)header->n_blocks * header->block_size > (size_t)st.st_size)
+    {
+        fprintf(stderr, "%s: not a recording (or another version)\n", path);
+        return 1;
+    }
+
+    // Oldest block first
+    BlockOrder *order = calloc(header->n_blocks, sizeof(BlockOrder));
+    uint32_t n_used = 0;
+    for (uint32_t b = 0; b < header->n_blocks; b++)
+    {
+        const RecorderBlock *block = (const RecorderBlock *)(map + RECORDER_HEADER_BYTES + (size_t)b * header->block_size);
+        uint64_t seq = atomic_load((_Atomic uint64_t *)&block->seq);
+        if (seq != 0) order[n_used++] = (BlockOrder){ b, seq };
+    }
+    qsort(order, n_used, sizeof(BlockOrder), cmp_block);
+
+    size_t image_cap = recorder_image_size(header->max_obstacles, header->max_targets, header->max_agents);
+    uint8_t *image = calloc(1, image_cap);
+    uint8_t *copy = malloc(header->block_size);
+    uint64_t *stage_ns = calloc(header->stage_count, sizeof(uint64_t));
+
+    // With -s, the newest record sets where the window starts
+    uint64_t from_ns = 0;
+    if (seconds > 0.0 && n_used > 0)
+    {
+        const RecorderBlock *block = (const RecorderBlock *)(map + RECORDER_HEADER_BYTES + (size_t)order[n_used - 1].index * header->block_size);
+        const uint8_t *p = (const uint8_t *)(block + 1);
+        const uint8_t *end = p + atomic_load((_Atomic uint32_t *)&block->used);
+        uint64_t last_ns = 0;
+        while (p + sizeof(FlightRecord) <= end)
+        {
+            const FlightRecord *record = (const FlightRecord *)p;
+            if (record->len < sizeof(FlightRecord)) break;
+            last_ns = record->t_ns;
+            p += record->len;
+        }
+        if (last_ns > (uint64_t)(seconds * 1e9)) from_ns = last_ns - (uint64_t)(seconds * 1e9);
+    }
+
+    uint64_t shown = 0, damaged = 0;
+    for (uint32_t i = 0; i < n_used; i++)
+    {
+        // Copy the block, then make sure the server did not start reusing it meanwhile
+        const RecorderBlock *block = (const RecorderBlock *)(map + RECORDER_HEADER_BYTES + (size_t)order[i].index * header->block_size);
+        uint32_t used = atomic_load((_Atomic uint32_t *)&block->used);
+        if (used > header->block_size - sizeof(RecorderBlock)) continue;
+        memcpy(copy, block + 1, used);
+        if (atomic_load((_Atomic uint64_t *)&block->seq) != order[i].seq) continue;
+
+        size_t image_len = 0;
+        const uint8_t *p = copy;
+        const uint8_t *end = copy + used;
+        while (p + sizeof(FlightRecord) <= end)
+        {
+            const FlightRecord *record = (const FlightRecord *)p;
+            if (record->len < sizeof(FlightRecord) || p + record->len > end) break;
+            if (recorder_decode(record, p + record->len, image, image_cap, &image_len, stage_ns, header->stage_count) == -1)
+            {
+                damaged++;
+                break; // Later records of the block depend on this one
+            }
+            if (record->t_ns >= from_ns)
+            {
+                print_tick(header, record, image, stage_ns, entities);
+                shown++;
+            }
+            p += record->len;
+        }
+    }
+    fprintf(stderr, "%s: %llu tick(s) from %u block(s) of %u KiB%s\n", path, (unsigned long long)shown, n_used,
+            header->block_size / 1024, damaged ? ", damaged blocks cut short" : "");
+
+    free(stage_ns);
+    free(copy);
+    free(image);
+    free(order);
+    munmap(map, st.st_size);
+    close(fd);
+    return 0;
+}
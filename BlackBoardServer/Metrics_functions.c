@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "Blackboard.h"
+#include "../common.h"
+
+// Upper bound of each histogram bucket in microseconds (last bucket = +Inf)
+static const uint64_t bucket_bounds_us[METRIC_BUCKETS - 1] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500,
+    1000, 2000, 5000, 10000, 20000, 30000, 50000, 100000
+};
+
+static const char *stage_names[STAGE_COUNT] = {
+    "drone_rx", "net_rx", "net_tx", "targets", "render", "publish", "record", "tick"
+};
+
+const char *metrics_stage_name(TickStage stage) 
+{
+    return (stage >= 0 && stage < STAGE_COUNT) ? stage_names[stage] : "?";
+}
+
+void metrics_record(TickMetrics *metrics, TickStage stage, uint64_t elapsed_ns) 
+{
+    StageHistogram *hist = &metrics->stages[stage];
+    int b = 0;
+    while (b < METRIC_BUCKETS - 1 && elapsed_ns > bucket_bounds_us[b] * 1000ULL) b++;
+
+    metrics->tick_stage_ns[stage] += elapsed_ns;
+    hist->buckets[b]++;
+    hist->count++;
+    hist->sum_ns += elapsed_ns;
+    if (elapsed_ns > hist->max_ns) hist->max_ns = elapsed_ns;
+}
+
+// Upper bound of the bucket holding the q-quantile (the max for the +Inf bucket)
+uint64_t metrics_quantile_ns(const StageHistogram *hist, double q) 
+{
+    if (hist->count == 0) return 0;
+
+    uint64_t rank = (uint64_t)(q * hist->count);
+    if (rank >= hist->count) rank = hist->count - 1;
+
+    uint64_t seen = 0;
+    for (int b = 0; b < METRIC_BUCKETS - 1; b++) 
+    {
+        seen += hist->buckets[b];
+        if (seen > rank) 
+        {
+            uint64_t bound = bucket_bounds_us[b] * 1000ULL;
+            return bound < hist->max_ns ? bound : hist->max_ns;
+        }
+    }
+    return hist->max_ns;
+}
+
+int metrics_write(const TickMetrics *metrics, SharedBoard *board, const char *path) 
+{
+    char tmp_path[300];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE *f = fopen(tmp_path, "w");
+    if (f == NULL) return -1;
+
+    fprintf(f, "# HELP drone_ticks_total Ticks run by the blackboard.\n");
+    fprintf(f, "# TYPE drone_ticks_total counter\n");
+    fprintf(f, "drone_ticks_total %llu\n", (unsigned long long)metrics->ticks);
+    fprintf(f, "# HELP drone_ticks_over_deadline_total Ticks whose body took longer than one tick period.\n");
+    fprintf(f, "# TYPE drone_ticks_over_deadline_total counter\n");
+    fprintf(f, "drone_ticks_over_deadline_total %llu\n", (unsigned long long)metrics->ticks_over_deadline);
+    fprintf(f, "# HELP drone_ticks_missed_total Timer expirations dropped after an overrun.\n");
+    fprintf(f, "# TYPE drone_ticks_missed_total counter\n");
+    fprintf(f, "drone_ticks_missed_total %llu\n", (unsigned long long)metrics->ticks_missed);
+    fprintf(f, "# HELP drone_tick_deadline_seconds Tick period.\n");
+    fprintf(f, "# TYPE drone_tick_deadline_seconds gauge\n");
+    fprintf(f, "drone_tick_deadline_seconds %.6f\n", metrics->deadline_ns / 1e9);
+    fprintf(f, "# HELP drone_startup_ready_seconds Launch until every child reported ready.\n");
+    fprintf(f, "# TYPE drone_startup_ready_seconds gauge\n");
+    fprintf(f, "drone_startup_ready_seconds %.6f\n", metrics->startup_ready_ns / 1e9);
+    fprintf(f, "# HELP drone_startup_first_frame_seconds Launch until the first frame was rendered (published when headless).\n");
+    fprintf(f, "# TYPE drone_startup_first_frame_seconds gauge\n");
+    fprintf(f, "drone_startup_first_frame_seconds %.6f\n", metrics->startup_first_frame_ns / 1e9);
+
+    fprintf(f, "# HELP drone_tick_stage_seconds Time spent in each stage of the blackboard tick.\n");
+    fprintf(f, "# TYPE drone_tick_stage_seconds histogram\n");
+    for (int s = 0; s < STAGE_COUNT; s++) 
+    {
+        const StageHistogram *hist = &metrics->stages[s];
+        uint64_t cumulative = 0;
+        for (int b = 0; b < METRIC_BUCKETS - 1; b++) 
+        {
+            cumulative += hist->buckets[b];
+            fprintf(f, "drone_tick_stage_seconds_bucket{stage=\"%s\",le=\"%g\"} %llu\n",
+                    stage_names[s], bucket_bounds_us[b] / 1e6, (unsigned long long)cumulative);
+        }
+        fprintf(f, "drone_tick_stage_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %llu\n",
+                stage_names[s], (unsigned long long)hist->count);
+        fprintf(f, "drone_tick_stage_seconds_sum{stage=\"%s\"} %.9f\n", stage_names[s], hist->sum_ns / 1e9);
+        fprintf(f, "drone_tick_stage_seconds_count{stage=\"%s\"} %llu\n", stage_names[s], (unsigned long long)hist->count);
+    }
+
+    // Pre-computed summaries so a plain 'cat' is enough to spot a stall
+    const char *summaries[3] = { "p50", "p99", "max" };
+    for (int k = 0; k < 3; k++) 
+    {
+        fprintf(f, "# HELP drone_tick_stage_%s_seconds %s of each tick stage (bucket upper bound).\n", summaries[k], summaries[k]);
+        fprintf(f, "# TYPE drone_tick_stage_%s_seconds gauge\n", summaries[k]);
+        for (int s = 0; s < STAGE_COUNT; s++) 
+        {
+            const StageHistogram *hist = &metrics->stages[s];
+            uint64_t v = (k == 0) ? metrics_quantile_ns(hist, 0.50)
+                       : (k == 1) ? metrics_quantile_ns(hist, 0.99)
+                       : hist->max_ns;
+            fprintf(f, "drone_tick_stage_%s_seconds{stage=\"%s\"} %.9f\n", summaries[k], stage_names[s], v / 1e9);
+        }
+    }
+
+    // PROCESS HEARTBEATS (misses and stalls are counted by the watchdog)
+    if (board != NULL) 
+    {
+        fprintf(f, "# HELP drone_heartbeat_beats_total Loop iterations reported by each process.\n");
+        fprintf(f, "# TYPE drone_heartbeat_beats_total counter\n");
+        for (int c = 0; c < COMPONENT_COUNT; c++) 
+        {
+            fprintf(f, "drone_heartbeat_beats_total{process=\"%s\"} %llu\n", component_name(c),
+                    (unsigned long long)atomic_load(&board->heartbeats[c].beats));
+        }
+        fprintf(f, "# HELP drone_heartbeat_misses_total Beats that came later than their deadline.\n");
+        fprintf(f, "# TYPE drone_heartbeat_misses_total counter\n");
+        for (int c = 0; c < COMPONENT_COUNT; c++) 
+        {
+            fprintf(f, "drone_heartbeat_misses_total{process=\"%s\"} %llu\n", component_name(c),
+                    (unsigned long long)atomic_load(&board->heartbeats[c].misses));
+        }
+        fprintf(f, "# HELP drone_heartbeat_stalls_total Silences longer than the stall threshold.\n");
+        fprintf(f, "# TYPE drone_heartbeat_stalls_total counter\n");
+        for (int c = 0; c < COMPONENT_COUNT; c++) 
+        {
+            fprintf(f, "drone_heartbeat_stalls_total{process=\"%s\"} %llu\n", component_name(c),
+                    (unsigned long long)atomic_load(&board->heartbeats[c].stalls));
+        }
+        fprintf(f, "# HELP drone_heartbeat_worst_gap_seconds Longest time between two beats.\n");
+        fprintf(f, "# TYPE drone_heartbeat_worst_gap_seconds gauge\n");
+        for (int c = 0; c < COMPONENT_COUNT; c++) 
+        {
+            fprintf(f, "drone_heartbeat_worst_gap_seconds{process=\"%s\"} %.6f\n", component_name(c),
+                    atomic_load(&board->heartbeats[c].worst_gap_ns) / 1e9);
+        }
+    }
+
+    if (fclose(f) != 0) return -1;
+    // rename() is atomic: scrapers never see a half-written file
+    return rename(tmp_path, path);
+}
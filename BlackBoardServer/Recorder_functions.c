@@ -0,0 +1,285 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "Blackboard.h"
+#include "../common.h"
+
+// Largest record: header, inputs, stage times and a delta where every other byte changed
+static size_t record_bound(size_t image_cap)
+{
+    return sizeof(FlightRecord) + RECORDER_INPUTS_MAX * sizeof(InputMsg) + STAGE_COUNT * 10 + image_cap * 3 + 32;
+}
+
+static size_t put_varint(uint8_t *p, uint64_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80)
+    {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static int get_varint(const uint8_t **p, const uint8_t *end, uint64_t *v)
+{
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64 && *p < end; shift += 7)
+    {
+        uint8_t b = *(*p)++;
+        value |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+        {
+            *v = value;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+size_t recorder_image_size(int max_obstacles, int max_targets, int max_agents)
+{
+    return sizeof(WorldImageHead) + (size_t)max_obstacles * sizeof(Obstacle) +
+           (size_t)max_targets * sizeof(Target) + (size_t)max_agents * sizeof(DroneState);
+}
+
+// Flattens the part of the world that is in use
+static size_t world_image(const WorldState *world, uint8_t *image)
+{
+    WorldImageHead head;
+    memset(&head, 0, sizeof(head));
+    head.drone = world->drone;
+    head.score = world->score;
+    head.game_active = world->game_active;
+    head.n_obstacles = world->n_obstacles;
+    head.n_targets = world->n_targets;
+    head.n_agents = world->n_agents;
+    memcpy(image, &head, sizeof(head));
+
+    size_t len = sizeof(head);
+    memcpy(image + len, world->obstacles, (size_t)world->n_obstacles * sizeof(Obstacle));
+    len += (size_t)world->n_obstacles * sizeof(Obstacle);
+    memcpy(image + len, world->targets, (size_t)world->n_targets * sizeof(Target));
+    len += (size_t)world->n_targets * sizeof(Target);
+    memcpy(image + len, world->agents, (size_t)world->n_agents * sizeof(DroneState));
+    len += (size_t)world->n_agents * sizeof(DroneState);
+    return len;
+}
+
+// Any of the next RECORDER_ZERO_RUN bytes changed (the end of the image counts as unchanged)
+static int changed_soon(const uint8_t *diff, size_t at, size_t len)
+{
+    for (size_t k = at; k < at + RECORDER_ZERO_RUN && k < len; k++)
+    {
+        if (diff[k] != 0) return 1;
+    }
+    return 0;
+}
+
+// (unchanged, changed) varint pairs, each followed by the changed bytes
+static size_t encode_delta(const uint8_t *diff, size_t len, uint8_t *out)
+{
+    size_t n = 0, i = 0;
+    while (i < len)
+    {
+        size_t start = i;
+        while (i < len && diff[i] == 0) i++;
+        if (i == len) break; // Trailing bytes unchanged: nothing to write
+
+        size_t literal = i;
+        while (i < len && changed_soon(diff, i, len)) i++;
+        n += put_varint(out + n, literal - start);
+        n += put_varint(out + n, i - literal);
+        memcpy(out + n, diff + literal, i - literal);
+        n += i - literal;
+    }
+    return n;
+}
+
+static RecorderBlock *block_at(FlightRecorder *rec, uint32_t index)
+{
+    return (RecorderBlock *)(rec->map + RECORDER_HEADER_BYTES + (size_t)index * rec->header->block_size);
+}
+
+// Moves to the oldest block; its records are gone from here on
+static RecorderBlock *next_block(FlightRecorder *rec)
+{
+    rec->block = (rec->block + 1) % rec->header->n_blocks;
+    RecorderBlock *block = block_at(rec, rec->block);
+    atomic_store_explicit(&block->seq, 0, memory_order_release); // A reader drops it while it is being rewritten
+    atomic_store_explicit(&block->used, 0, memory_order_release);
+    block->records = 0;
+    atomic_store_explicit(&block->seq, atomic_fetch_add(&rec->header->next_seq, 1), memory_order_release);
+    return block;
+}
+
+int recorder_open(FlightRecorder *rec, const char *path, size_t megabytes, const WorldState *world, uint64_t tick_ns)
+{
+    memset(rec, 0, sizeof(*rec));
+    rec->fd = -1;
+    rec->image_cap = recorder_image_size(world->max_obstacles, world->max_targets, world->max_agents);
+
+    // A block must hold at least two keyframes, so filling one never skips a tick
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t block_size = 2 * record_bound(rec->image_cap) + sizeof(RecorderBlock);
+    if (block_size < RECORDER_BLOCK_MIN) block_size = RECORDER_BLOCK_MIN;
+    block_size = (block_size + page - 1) / page * page;
+    size_t n_blocks = (megabytes << 20) / block_size;
+    if (n_blocks < 2) n_blocks = 2;
+    rec->size = RECORDER_HEADER_BYTES + n_blocks * block_size;
+
+    rec->image = malloc(rec->image_cap);
+    rec->prev = calloc(1, rec->image_cap);
+    rec->diff = malloc(rec->image_cap);
+    rec->record = malloc(record_bound(rec->image_cap));
+    if (rec->image == NULL || rec->prev == NULL || rec->diff == NULL || rec->record == NULL) goto fail;
+
+    // Whatever the last run left (maybe the reason we are restarting) is kept once
+    char prev_path[320];
+    snprintf(prev_path, sizeof(prev_path), "%s.prev", path);
+    rename(path, prev_path);
+
+    rec->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (rec->fd == -1) goto fail;
+    if (ftruncate(rec->fd, (off_t)rec->size) == -1) goto fail;
+    rec->map = mmap(NULL, rec->size, PROT_READ | PROT_WRITE, MAP_SHARED, rec->fd, 0);
+    if (rec->map == MAP_FAILED)
+    {
+        rec->map = NULL;
+        goto fail;
+    }
+
+    struct timespec real;
+    clock_gettime(CLOCK_REALTIME, &real);
+    rec->header = (RecorderHeader *)rec->map;
+    rec->header->version = RECORDER_VERSION;
+    rec->header->block_size = (uint32_t)block_size;
+    rec->header->n_blocks = (uint32_t)n_blocks;
+    rec->header->stage_count = STAGE_COUNT;
+    rec->header->max_obstacles = world->max_obstacles;
+    rec->header->max_targets = world->max_targets;
+    rec->header->max_agents = world->max_agents;
+    rec->header->tick_ns = tick_ns;
+    rec->header->mono_base_ns = monotonic_ns();
+    rec->header->real_base_ns = (uint64_t)real.tv_sec * 1000000000ULL + (uint64_t)real.tv_nsec;
+    atomic_store(&rec->header->next_seq, 1);
+    atomic_thread_fence(memory_order_release);
+    rec->header->magic = RECORDER_MAGIC; // Last: a reader ignores a half-written header
+
+    rec->block = (uint32_t)n_blocks - 1; // next_block() starts at block 0
+    next_block(rec);
+    return 0;
+
+fail:
+    recorder_close(rec);
+    return -1;
+}
+
+void recorder_append(FlightRecorder *rec, const WorldState *world, const TickInputs *inputs,
+                     const uint64_t stage_ns[STAGE_COUNT], uint64_t t_ns)
+{
+    if (rec->map == NULL) return;
+
+    size_t len = world_image(world, rec->image);
+    RecorderBlock *block = block_at(rec, rec->block);
+    size_t room = rec->header->block_size - sizeof(RecorderBlock);
+
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        int keyframe = (block->records == 0);
+        FlightRecord head;
+        memset(&head, 0, sizeof(head));
+        head.tick = world->tick;
+        head.t_ns = t_ns;
+        head.image_len = (uint32_t)len;
+        head.flags = keyframe ? RECORD_KEYFRAME : 0;
+        head.n_inputs = inputs ? (uint16_t)inputs->n_inputs : 0;
+        head.events = inputs ? inputs->events : 0;
+
+        size_t n = sizeof(head);
+        if (head.n_inputs > 0)
+        {
+            memcpy(rec->record + n, inputs->inputs, head.n_inputs * sizeof(InputMsg));
+            n += head.n_inputs * sizeof(InputMsg);
+        }
+        for (int s = 0; s < STAGE_COUNT; s++) n += put_varint(rec->record + n, stage_ns[s]);
+
+        // Bytes past the previous image count as zero in it, like in the decoder
+        for (size_t i = 0; i < len; i++)
+        {
+            rec->diff[i] = rec->image[i] ^ ((keyframe || i >= rec->prev_len) ? 0 : rec->prev[i]);
+        }
+        n += encode_delta(rec->diff, len, rec->record + n);
+        size_t padded = (n + 7) & ~(size_t)7;
+        memset(rec->record + n, 0, padded - n);
+        n = padded;
+        head.len = (uint32_t)n;
+        memcpy(rec->record, &head, sizeof(head));
+
+        uint32_t used = atomic_load_explicit(&block->used, memory_order_relaxed);
+        if (used + n <= room)
+        {
+            memcpy((uint8_t *)(block + 1) + used, rec->record, n);
+            block->records++;
+            atomic_store_explicit(&block->used, used + (uint32_t)n, memory_order_release);
+            break;
+        }
+        // Block full: the record goes into the next one as its keyframe
+        block = next_block(rec);
+    }
+
+    uint8_t *swap = rec->prev;
+    rec->prev = rec->image;
+    rec->image = swap;
+    rec->prev_len = len;
+}
+
+void recorder_close(FlightRecorder *rec)
+{
+    // The mapping is the file: everything appended is already in the page cache
+    if (rec->map != NULL) munmap(rec->map, rec->size);
+    if (rec->fd != -1) close(rec->fd);
+    free(rec->image);
+    free(rec->prev);
+    free(rec->diff);
+    free(rec->record);
+    memset(rec, 0, sizeof(*rec));
+    rec->fd = -1;
+}
+
+int recorder_decode(const FlightRecord *record, const uint8_t *end, uint8_t *image, size_t image_cap,
+                    size_t *image_len, uint64_t stage_ns[], uint32_t stage_count)
+{
+    if (record->image_len > image_cap) return -1;
+    const uint8_t *p = (const uint8_t *)(record + 1) + record->n_inputs * sizeof(InputMsg);
+    if (p > end) return -1;
+    for (uint32_t s = 0; s < stage_count; s++)
+    {
+        if (get_varint(&p, end, &stage_ns[s]) == -1) return -1;
+    }
+
+    // Bytes the previous image did not have start out as zero
+    if (record->flags & RECORD_KEYFRAME) memset(image, 0, record->image_len);
+    else if (record->image_len > *image_len) memset(image + *image_len, 0, record->image_len - *image_len);
+
+    size_t pos = 0;
+    while (p < end)
+    {
+        uint64_t skip, changed;
+        // The zero padding reads as empty pairs
+        if (get_varint(&p, end, &skip) == -1 || p == end) break;
+        if (get_varint(&p, end, &changed) == -1) return -1;
+        pos += skip;
+        if (pos + changed > record->image_len || p + changed > end) return -1;
+        for (uint64_t k = 0; k < changed; k++) image[pos + k] ^= p[k];
+        p += changed;
+        pos += changed;
+    }
+    *image_len = record->image_len;
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include "Blackboard.h"
+#include "../common.h"
+
+/* ThreadedServer.c - Single-binary deployment (make threaded -> ./server_threaded)
+   The server, the drone and both generators are linked into one process. Their
+   main() functions are compiled under other names (see the Makefile) and
+   spawn_process() starts them as threads; the links between them become
+   in-process SPSC rings (link_register) carrying the same frames as the FIFOs.
+   The keyboard, watchdog and network process stay separate processes.
+*/
+
+int server_main(void);
+int drone_main(int argc, char *argv[]);
+int obstacles_main(int argc, char *argv[]);
+int targets_main(int argc, char *argv[]);
+
+int main(void)
+{
+    register_thread_subsystem("./drone", drone_main);
+    register_thread_subsystem("./obstacle_process", obstacles_main);
+    register_thread_subsystem("./target_process", targets_main);
+    return server_main();
+}
@@ -20,39 +20,22 @@
 */
 
 // GLOBAL FLAG FOR CLEANUP
-volatile sig_atomic_t keep_running = 1;
+static volatile sig_atomic_t keep_running = 1;
 
-void handle_signal(int sig) 
+static void handle_signal(int sig) 
 {
     keep_running = 0;
 }
 
-// PHYSICS ENGINE 
-void update_physics(DroneState *drone) 
-{
-    // Add Drag Force (Air Resistance), Drag always opposes velocity: F_drag = -K * v
-    drone->force_x -= DRAG_COEF * drone->vx;
-    drone->force_y -= DRAG_COEF * drone->vy;
-
-    // Calculate Acceleration (a = F / m)
-    double ax = drone->force_x / MASS;
-    double ay = drone->force_y / MASS;
-
-    // Integration (Euler Method: NewValue = OldValue + (RateOfChange × Δt) )
-    // Update Velocity
-    drone->vx += ax * DT;
-    drone->vy += ay * DT;
-
-    // Update Position
-    drone->x += drone->vx * DT;
-    drone->y += drone->vy * DT;
-}
-
 int main(int argc, char *argv[]) 
 {
     // REGISTER SIGNALS
-    signal(SIGINT, handle_signal);  // Ctrl+C
-    signal(SIGTERM, handle_signal); // Kill command
+    // As a thread of the threaded build the server owns the signals; we stop when the board closes
+    if (!subsystem_is_thread())
+    {
+        signal(SIGINT, handle_signal);  // Ctrl+C
+        signal(SIGTERM, handle_signal); // Kill command
+    }
 
     static int frame_count = 0;
 
@@ -60,7 +43,6 @@ int main(int argc, char *argv[])
     // Pipes Setup 
     char fifoKD[100]; 
     char fifoDBB[100]; 
-    char fifoBBD[100];
 
     char suffix[50] = "";
     if (argc > 1) {
@@ -69,92 +51,120 @@ int main(int argc, char *argv[])
 
     snprintf(fifoKD, sizeof(fifoKD), "/tmp/fifoKD%s", suffix);
     snprintf(fifoDBB, sizeof(fifoDBB), "/tmp/fifoDBB%s", suffix);
-    snprintf(fifoBBD, sizeof(fifoBBD), "/tmp/fifoBBD%s", suffix);
 
     if (mkfifo(fifoKD, 0666) == -1 && errno != EEXIST) { perror("Drone fifoKD"); exit(1); }
     if (mkfifo(fifoDBB, 0666) == -1 && errno != EEXIST) { perror("Drone fifoDBB"); exit(1); }
-    if (mkfifo(fifoBBD, 0666) == -1 && errno != EEXIST) { perror("Drone fifoBBD"); exit(1); }
     
-    int fd_KD = open(fifoKD, O_RDONLY);
-    int fd_DBB = open(fifoDBB, O_WRONLY);
-    int fd_BBD = open(fifoBBD, O_RDONLY);
+    // Non-blocking: the keyboard may not have opened its end yet, and waiting for it
+    // here would serialise the bring-up (see the readiness check in the loop)
+    int fd_KD = link_open(fifoKD, O_RDONLY | O_NONBLOCK);
+    int fd_DBB = link_open(fifoDBB, O_WRONLY);
 
     if (fd_KD == -1) { perror("Pipe From Keyboard to Drone: open read"); exit(1); }
     if (fd_DBB == -1) { perror("Pipe From Drone to BlackBoard: open write"); exit(1); }
-    if (fd_BBD == -1)  { perror("Pipe From BlackBoard to Drone: open read"); exit(1); }
 
-    // Set Keyboard Pipe to Non-Blocking
-    fcntl(fd_KD, F_SETFL, fcntl(fd_KD, F_GETFL, 0) | O_NONBLOCK);
+    // Obstacles are read in place from the shared blackboard
+    SharedBoard *board = board_attach(suffix);
+    if (board == NULL) { perror("Drone: attach shared board"); exit(1); }
+
+    // Repulsion kernel: picked once from the CPU (AVX2 / SSE / scalar)
+    int kernel = repulsion_kernel_select(KERNEL_AUTO);
+    int vector_scan = (kernel != KERNEL_SCALAR); // Otherwise the grid is always cheaper
+    log_msg("DRONE", "Repulsion kernel: %s", repulsion_kernel_name(kernel));
 
-    // Set Blackboard Read Pipe to Non-Blocking 
-    fcntl(fd_BBD, F_SETFL, fcntl(fd_BBD, F_GETFL, 0) | O_NONBLOCK);
+    // Framed links
+    FrameReader kd_reader;
+    if (frame_reader_init(&kd_reader, fd_KD, FRAME_BUFFER_CAP) == -1) { perror("Drone: frame reader"); exit(1); }
+    FrameWriter dbb_writer;
+    frame_writer_init(&dbb_writer, fd_DBB);
 
     // Initial State
-    DroneState drone = { .x = 10.0, .y = 10.0, .vx = 0, .vy = 0, .force_x = 0, .force_y = 0 };
+    // Drone 0 is the player, drones 1..n-1 the agents the server made room for
+    int n_drones = 1 + board->max_agents;
+    DroneState *drones = calloc(n_drones, sizeof(DroneState));
+    InputMsg *inputs = calloc(n_drones, sizeof(InputMsg));
+    if (drones == NULL || inputs == NULL) { perror("Drone: alloc"); exit(1); }
+    for (int i = 0; i < n_drones; i++) drone_spawn(&drones[i], i, n_drones);
     int game_active = 0; // 0 = IDLE, 1 = FLYING
-    Obstacle obstacles[MAX_OBSTACLES];
+
+    SwarmPool *pool = swarm_pool_create(argc > 2 ? atoi(argv[2]) : 0);
+    if (pool == NULL) { perror("Drone: thread pool"); exit(1); }
+    log_msg("DRONE", "Flying %d drone(s) on %d thread(s)", n_drones, pool->threads);
+    // Integrator and substeps from param.conf (INTEGRATOR / SUBSTEPS), passed on by the server
+    Integrator integrator = { INTEGRATOR_SEMI_IMPLICIT, 1, DRAG_COEF };
+    if (argc > 3 && integrator_parse(argv[3]) != -1) integrator.kind = integrator_parse(argv[3]);
+    else if (argc > 3) log_msg("DRONE", "Unknown integrator '%s', using %s", argv[3], integrator_name(integrator.kind));
+    if (argc > 4 && atoi(argv[4]) >= 1 && atoi(argv[4]) <= MAX_SUBSTEPS) integrator.substeps = atoi(argv[4]);
+    log_msg("DRONE", "Integrator: %s, %d substep(s) of %.4f s", integrator_name(integrator.kind),
+            integrator.substeps, DT / integrator.substeps);
+    SwarmBatch batch = { drones, inputs, n_drones, board, NULL, vector_scan, &integrator };
+    board_set_ready(board, COMPONENT_DRONE);
+    heartbeat_start(board, COMPONENT_DRONE, FRAME_PERIOD_US * 1000ULL);
 
     while(keep_running) 
     {
-        InputMsg msg = {0,0,0};
+        heartbeat_beat(board, COMPONENT_DRONE);
+
+        // Inputs only last one frame, like a key that is no longer held
+        memset(inputs, 0, (size_t)n_drones * sizeof(InputMsg));
+        InputMsg msg = {0,0,0,0}; // Drone 0's stream, which also carries the game commands
 
         // Read Input (Non-blocking)
-        // Read Input (Non-blocking)
-        // DRAIN THE PIPE to prevent lag (process only the latest inputs)
+        // DRAIN THE PIPE to prevent lag: one read() pulls the whole burst of
+        // frames, then every frame in it is parsed (process only the latest inputs)
         ssize_t bytesRead = 0;
-        InputMsg temp_msg;
         int any_input = 0;
+        FrameHeader hdr;
+        const void *payload;
 
-        while ((bytesRead = read(fd_KD, &temp_msg, sizeof(temp_msg))) > 0) 
+        while ((bytesRead = frame_fill(&kd_reader)) > 0) 
         {
-            any_input = 1;
-
-            // Always take the latest force (overwrites previous ones in the buffer)
-            msg.force_x = temp_msg.force_x;
-            msg.force_y = temp_msg.force_y;
-
-            // Latch commands: If a command is seen in the buffer, keep it.
-            // If multiple commands are in the buffer (unlikely in 30ms), the last one prevails 
-            // unless we want to prioritize specific ones. 
-            // For now, if we see a command, we update our msg to have it.
-            if (temp_msg.command != 0) 
+            while (frame_next(&kd_reader, &hdr, &payload)) 
             {
-                msg.command = temp_msg.command;
+                if (hdr.type != MSG_INPUT || hdr.length != sizeof(InputMsg)) continue;
+                InputMsg temp_msg;
+                memcpy(&temp_msg, payload, sizeof(InputMsg));
+                if (temp_msg.drone >= (uint32_t)n_drones) continue; // No such drone in this world
+
+                // Always take the latest force (overwrites previous ones in the buffer)
+                InputMsg *in = &inputs[temp_msg.drone];
+                in->force_x = temp_msg.force_x;
+                in->force_y = temp_msg.force_y;
+                // Latch commands: If a command is seen in the buffer, keep it.
+                // If multiple commands are in the buffer (unlikely in 30ms), the last one prevails.
+                if (temp_msg.command != 0) in->command = temp_msg.command;
+
+                if (temp_msg.drone == 0) 
+                {
+                    any_input = 1;
+                    msg = *in;
+                }
             }
         }
-
-        // If 'any_input' is true, we have a valid 'msg' (state composed of latest force + any command).
-        // 'bytesRead' will be -1 (EAGAIN) at the end of the loop, or 0 if closed.
-        
-        // To respect existing logic below that checks 'bytesRead', we simulate it:
-        if (any_input) 
-        {
-            bytesRead = sizeof(msg); // Pretend we read one full message successfully
-        } 
-        else 
+        // Agents can only brake; starting, resetting and quitting belong to the player
+        for (int i = 1; i < n_drones; i++) 
         {
-            // If no input was found, we rely on the LAST read result.
-            // If the loop never ran (first read failed), bytesRead is from the condition check?
-            // Wait, "while ((bytesRead = read...))".
-            // If first read is -1, loop doesn't run. bytesRead is -1. Correct.
-            // If first read is 0, loop doesn't run. bytesRead is 0. Correct.
+            if (inputs[i].command != ' ') inputs[i].command = 0;
         }
-        
-        // Read Obstacles (Non-blocking)
-        ssize_t obsBytes = read(fd_BBD, obstacles, sizeof(obstacles));
-        
-        if (obsBytes == -1) 
+
+        // 'bytesRead' is -1 (EAGAIN) once the pipe is drained, or 0 if the keyboard closed it.
+        // Any parsed input counts as a successful read for the logic below.
+        if (any_input && bytesRead != 0) 
         {
-            if (errno != EAGAIN) 
-            {
-                perror("Drone: Error reading obstacles");
-            }
+            bytesRead = sizeof(msg);
         } 
-        else if (obsBytes > 0 && obsBytes < sizeof(obstacles)) 
+        
+        // Until the keyboard has opened fifoKD there is no writer and read() returns 0 as well:
+        // that is only a disconnect once the keyboard reported ready (it opens before it reports)
+        if (bytesRead == 0 && !board_is_ready(board, COMPONENT_KEYBOARD)) 
         {
-            fprintf(stderr, "Drone: Warning - Partial obstacle data received.\n");
+            bytesRead = -1;
+            errno = EAGAIN;
         }
-        
+
+        // Server gone: nothing will consume our state any more
+        if (atomic_load(&board->closed)) break;
+
         // HANDLE QUIT 
         // The next is from assignment1 fixes; Keyboard process has died, We should quit too.
         if (bytesRead == 0) 
@@ -170,9 +180,7 @@ int main(int argc, char *argv[])
 
         if (bytesRead > 0 && msg.command == 'q') 
         {
-            drone.x = -1.0; // A distinct value to signal termination           
-            ssize_t quitBytes = write(fd_DBB, &drone, sizeof(drone));
-            if (quitBytes == -1) perror("Drone: Failed to send reset signal");
+            if (frame_send(&dbb_writer, MSG_QUIT, NULL, 0) == -1) perror("Drone: Failed to send quit signal");
             keep_running = 0; // Break loop gracefully 
             break;
         }
@@ -187,13 +195,8 @@ int main(int argc, char *argv[])
             }
             else if (msg.command == 'r') 
             {
-                DroneState reset_sig = drone;
-                reset_sig.x = -2.0; 
-                ssize_t resetBytes = write(fd_DBB, &reset_sig, sizeof(DroneState));
-                if (resetBytes == -1) perror("Drone: Failed to send reset signal");
-                drone.x = 10.0; drone.y = 10.0;
-                drone.vx = 0.0; drone.vy = 0.0;
-                drone.force_x = 0.0; drone.force_y = 0.0;
+                if (frame_send(&dbb_writer, MSG_RESET, NULL, 0) == -1) perror("Drone: Failed to send reset signal");
+                for (int i = 0; i < n_drones; i++) drone_spawn(&drones[i], i, n_drones);
                 game_active = 0; 
                 log_msg("DRONE", "Game reset");
             }
@@ -201,37 +204,27 @@ int main(int argc, char *argv[])
 
         // PHYSICS LOOP
         if (game_active) {
-            drone.force_x = 0; 
-            drone.force_y = 0;
-
-            // Add Input Forces
-            drone.force_x += msg.force_x * THRUST_MULTIPLIER;
-            drone.force_y += msg.force_y * THRUST_MULTIPLIER;
-
             // Log force input for debugging diagonal movement
             if (frame_count % 100 == 0 && (msg.force_x != 0.0 || msg.force_y != 0.0)) 
             {
                 log_msg("DRONE", "Input force: Fx=%.3f, Fy=%.3f (normalized)", 
                         msg.force_x, msg.force_y);
             }
+            if (msg.command == ' ') log_msg("DRONE", "Brake applied");
 
-            // Brake
-            if (msg.command == ' ') 
-            {
-                drone.vx *= 0.5;
-                drone.vy *= 0.5;
-                log_msg("DRONE", "Brake applied");
-            }
-
-            // Repulsion & Integration
-            apply_repulsive_forces(&drone, obstacles);
-            apply_border_forces(&drone);
-            update_physics(&drone);
+            // Every drone in one batch, split across the pool
+            swarm_step(pool, &batch);
         }
 
         // SEND STATE TO BLACKBOARD
-        ssize_t stateBytes = write(fd_DBB, &drone, sizeof(drone));
-        if (stateBytes == -1) 
+        // The player's input of this frame (for the server's flight recorder), the player, then the agents in one frame
+        int sent = any_input ? frame_send(&dbb_writer, MSG_INPUT, &msg, sizeof(InputMsg)) : 0;
+        if (sent == 0) sent = frame_send(&dbb_writer, MSG_DRONE_STATE, &drones[0], sizeof(DroneState));
+        if (sent == 0 && n_drones > 1) 
+        {
+            sent = frame_send(&dbb_writer, MSG_AGENTS, &drones[1], (uint32_t)((n_drones - 1) * sizeof(DroneState)));
+        }
+        if (sent == -1) 
         {
             perror("Drone: Error sending state to Blackboard");
             // If the server is dead (EPIPE), we might want to quit the drone too.
@@ -241,14 +234,19 @@ int main(int argc, char *argv[])
         // Logging drone Data to the log file only every 100 frames
         if (frame_count++ % 100 == 0) 
         {
-            log_msg("PHYSICS", "Pos: (%.2f, %.2f), Vel: (%.2f, %.2f)", drone.x, drone.y, drone.vx, drone.vy);
+            log_msg("PHYSICS", "Pos: (%.2f, %.2f), Vel: (%.2f, %.2f)", drones[0].x, drones[0].y, drones[0].vx, drones[0].vy);
         }
 
-        usleep(30000); 
+        usleep(FRAME_PERIOD_US); 
     }
-    close(fd_KD);
-    close(fd_DBB);
-    close(fd_BBD);
+    swarm_pool_destroy(pool);
+    free(inputs);
+    free(drones);
+    frame_reader_free(&kd_reader);
+    link_close(fd_KD);
+    link_close(fd_DBB);
+    heartbeat_stop(board, COMPONENT_DRONE);
+    board_detach(board);
     log_msg("DRONE", "Exiting cleanly");
     return 0;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef DRONECONTROLLER_H
 #define DRONECONTROLLER_H
 
+#include <pthread.h>
 #include "../common.h"
 
 /*  ASSIGNMENT1 CORRECTION:
@@ -18,9 +19,84 @@
 #define DRAG_COEF 0.5
 #define DT 0.05         
 #define THRUST_MULTIPLIER 10.0
+#define FRAME_PERIOD_US 30000 // Sleep between frames, also the heartbeat period
+
+// INTEGRATORS
+// How a drone moves over one frame of DT under m a = F(x) - drag * v, where
+// F is the thrust plus the obstacle and border pushes at the drone's position.
+// Picked with INTEGRATOR / SUBSTEPS in param.conf; each substep covers DT / substeps.
+typedef enum {
+    INTEGRATOR_SEMI_IMPLICIT, // Velocity, then position with the new velocity (the classic step, default)
+    INTEGRATOR_VERLET,        // Velocity Verlet, drag averaged over the step (trapezoidal)
+    INTEGRATOR_RK4,           // Classic 4th-order Runge-Kutta: 4 force evaluations per substep
+    INTEGRATOR_EXACT_DRAG,    // Closed-form drag, F held over each substep
+    INTEGRATOR_COUNT
+} IntegratorKind;
+#define MAX_SUBSTEPS 64
+
+typedef struct {
+    int kind;       // IntegratorKind
+    int substeps;   // 1..MAX_SUBSTEPS
+    double drag;    // DRAG_COEF, unless a parameter sweep varies it
+} Integrator;
+
+// Force on a drone in state 's', drag left out; 'ctx' is the caller's
+typedef void (*ForceField)(const DroneState *s, void *ctx, double *fx, double *fy);
+
+// MULTI-DRONE WORLDS
+// The drone process steps all DRONES drones of the world every frame: drone 0 is
+// the player, the others are agents. The batch is split across a pool of threads
+// (DRONE_THREADS in param.conf, 0 = one per CPU), which claim SWARM_BLOCK drones at a time.
+#define SWARM_BLOCK 32
+#define MAX_DRONE_THREADS 64
+#define SPAWN_MARGIN 6.0 // Agents spawn this far inside the map, clear of the border push
+
+// One frame of work for the pool
+typedef struct {
+    DroneState *drones;       // 'n' drones, stepped in place
+    const InputMsg *inputs;   // This frame's input per drone (all zero = none)
+    int n;
+    SharedBoard *board;       // Obstacles are read in place under the seqlock...
+    const WorldState *world;  // ...or from a private world if 'board' is NULL (benchmarks)
+    int vector_scan;          // Column kernel up to REPULSION_SCAN_MAX slots, else the grid
+    const Integrator *integrator; // NULL = one semi-implicit step per frame
+} SwarmBatch;
+
+// Persistent workers, woken once per frame; the caller works on the batch too
+typedef struct {
+    pthread_t *workers;
+    int threads;              // Including the caller
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long generation; // Bumped for every batch
+    int pending;              // Workers still on the current batch
+    int shutdown;
+    const SwarmBatch *batch;
+    _Atomic int next_block;
+} SwarmPool;
 
 // Functions
-// PHYSICS ENGINE
-void update_physics(DroneState *drone);
+// PHYSICS ENGINE (Integrator_functions.c)
+// Advances 'drone' by 'dt' ('integrator' NULL = one semi-implicit step with DRAG_COEF);
+// leaves the net force at the start of the step in force_x/y
+void integrate(DroneState *drone, double dt, const Integrator *integrator, ForceField field, void *ctx);
+// "semi", "verlet", "rk4" or "exact"; -1 if unknown
+int integrator_parse(const char *name);
+const char *integrator_name(int kind);
+// Force evaluations one frame of 'substeps' costs
+int integrator_evaluations(int kind, int substeps);
+
+// One drone for one frame: input, brake, repulsion, borders, integration
+void drone_step(DroneState *drone, const InputMsg *input, const SwarmBatch *batch);
+// Starting position of drone 'index' out of 'count' (drone 0 keeps the classic spot)
+void drone_spawn(DroneState *drone, int index, int count);
+
+// THREAD POOL (Drone_functions.c)
+// 'threads' <= 0 means one per online CPU; returns NULL on failure
+SwarmPool *swarm_pool_create(int threads);
+void swarm_pool_destroy(SwarmPool *pool);
+// Steps every drone of the batch; returns once all of them are done
+void swarm_step(SwarmPool *pool, const SwarmBatch *batch);
 
 #endif
\ No newline at end of file
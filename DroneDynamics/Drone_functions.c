@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <pthread.h>
+#include "DroneController.h"
+#include "../common.h"
+#include "../ObstaclesGenerator/ObstaclesGenerator.h"
+
+// Obstacle push from one consistent set of obstacles: one vector pass over the
+// SoA columns, or only the grid cells around the drone for very large sets
+static void repel(DroneState *drone, int n_obstacles, const Obstacle *obstacles, const int *head,
+                  const GridLink *links, const ObstacleColumns *cols, int vector_scan)
+{
+    if (vector_scan && n_obstacles <= REPULSION_SCAN_MAX) apply_repulsive_forces_columns(drone, cols, n_obstacles);
+    else apply_repulsive_forces_grid(drone, obstacles, n_obstacles, head, links);
+}
+
+static void apply_obstacle_forces(DroneState *drone, const SwarmBatch *batch)
+{
+    if (batch->board == NULL)
+    {
+        const WorldState *world = batch->world;
+        repel(drone, world->n_obstacles, world->obstacles, world->grid.head, world->grid.links,
+              &world->cols, batch->vector_scan);
+        return;
+    }
+
+    // Read in place; if the server republished mid-read, redo the sum on the new frame
+    SharedBoard *board = batch->board;
+    DroneState pushed;
+    uint32_t seq;
+    do
+    {
+        pushed = *drone;
+        seq = board_read_begin(board);
+        int n_obstacles;
+        const Obstacle *obstacles = board_obstacles(board, &n_obstacles);
+        ObstacleColumns cols = board_columns(board);
+        repel(&pushed, n_obstacles, obstacles, board->world.grid.head, board_grid_links(board),
+              &cols, batch->vector_scan);
+    } while (board_read_retry(board, seq));
+    *drone = pushed;
+}
+
+// Everything but drag pushing a drone at 's': the frame's thrust, obstacles and borders
+typedef struct {
+    double thrust_x, thrust_y;
+    const SwarmBatch *batch;
+} DroneForces;
+
+static void drone_forces(const DroneState *s, void *ctx, double *fx, double *fy)
+{
+    const DroneForces *forces = ctx;
+    DroneState probe = *s;
+    probe.force_x = forces->thrust_x;
+    probe.force_y = forces->thrust_y;
+    apply_obstacle_forces(&probe, forces->batch);
+    apply_border_forces_kernel(&probe);
+    *fx = probe.force_x;
+    *fy = probe.force_y;
+}
+
+void drone_step(DroneState *drone, const InputMsg *input, const SwarmBatch *batch)
+{
+    // Input Forces
+    DroneForces forces = { input->force_x * THRUST_MULTIPLIER, input->force_y * THRUST_MULTIPLIER, batch };
+
+    // Brake
+    if (input->command == ' ')
+    {
+        drone->vx *= 0.5;
+        drone->vy *= 0.5;
+    }
+
+    // Repulsion & Integration (the integrator asks for the forces wherever it needs them)
+    integrate(drone, DT, batch->integrator, drone_forces, &forces);
+}
+
+void drone_spawn(DroneState *drone, int index, int count)
+{
+    DroneState start = {0};
+    if (index == 0)
+    {
+        start.x = 10.0;
+        start.y = 10.0;
+    }
+    else
+    {
+        // Agents: rows evenly spaced down the map, columns scattered by the golden ratio
+        double width = MAP_WIDTH - 2 * SPAWN_MARGIN;
+        double height = MAP_HEIGHT - 2 * SPAWN_MARGIN;
+        start.x = SPAWN_MARGIN + fmod(index * 0.6180339887, 1.0) * width;
+        start.y = SPAWN_MARGIN + (index - 0.5) / (count > 1 ? count - 1 : 1) * height;
+    }
+    *drone = start;
+}
+
+// THREAD POOL
+// Every participant (workers and the caller) claims blocks of SWARM_BLOCK drones
+// from a shared counter until the batch is used up, so a block that costs more
+// (a crowded part of the map) does not hold the others back.
+
+static void swarm_run_blocks(SwarmPool *pool, const SwarmBatch *batch)
+{
+    int blocks = (batch->n + SWARM_BLOCK - 1) / SWARM_BLOCK;
+    int b;
+    while ((b = atomic_fetch_add(&pool->next_block, 1)) < blocks)
+    {
+        int end = (b + 1) * SWARM_BLOCK;
+        if (end > batch->n) end = batch->n;
+        for (int i = b * SWARM_BLOCK; i < end; i++) drone_step(&batch->drones[i], &batch->inputs[i], batch);
+    }
+}
+
+static void *swarm_worker(void *arg)
+{
+    SwarmPool *pool = arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1)
+    {
+        while (pool->generation == seen && !pool->shutdown) pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->shutdown) break;
+        seen = pool->generation;
+        const SwarmBatch *batch = pool->batch;
+        pthread_mutex_unlock(&pool->lock);
+
+        swarm_run_blocks(pool, batch);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+SwarmPool *swarm_pool_create(int threads)
+{
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > MAX_DRONE_THREADS) threads = MAX_DRONE_THREADS;
+
+    SwarmPool *pool = calloc(1, sizeof(SwarmPool));
+    if (pool == NULL) return NULL;
+    pool->workers = calloc(threads, sizeof(pthread_t));
+    if (pool->workers == NULL) { free(pool); return NULL; }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    // The caller is participant 0, so only threads - 1 workers are started
+    pool->threads = 1;
+    for (int t = 1; t < threads; t++)
+    {
+        if (pthread_create(&pool->workers[t], NULL, swarm_worker, pool) != 0)
+        {
+            perror("Drone: worker thread");
+            break; // Run with what we have
+        }
+        pool->threads++;
+    }
+    return pool;
+}
+
+void swarm_pool_destroy(SwarmPool *pool)
+{
+    if (pool == NULL) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int t = 1; t < pool->threads; t++) pthread_join(pool->workers[t], NULL);
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+void swarm_step(SwarmPool *pool, const SwarmBatch *batch)
+{
+    atomic_store(&pool->next_block, 0);
+
+    // A single block is not worth waking anybody for
+    if (pool->threads == 1 || batch->n <= SWARM_BLOCK)
+    {
+        swarm_run_blocks(pool, batch);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->batch = batch;
+    pool->pending = pool->threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    swarm_run_blocks(pool, batch);
+
+    // Workers may still be finishing their last block
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "DroneController.h"
+#include "../common.h"
+
+static const char *integrator_names[INTEGRATOR_COUNT] = { "semi", "verlet", "rk4", "exact" };
+
+int integrator_parse(const char *name)
+{
+    for (int k = 0; k < INTEGRATOR_COUNT; k++)
+    {
+        if (strcmp(name, integrator_names[k]) == 0) return k;
+    }
+    return -1;
+}
+
+const char *integrator_name(int kind)
+{
+    return (kind >= 0 && kind < INTEGRATOR_COUNT) ? integrator_names[kind] : "?";
+}
+
+int integrator_evaluations(int kind, int substeps)
+{
+    if (kind == INTEGRATOR_RK4) return 4 * substeps;
+    // Verlet also needs the force at the end of the last substep, and the next frame starts afresh
+    if (kind == INTEGRATOR_VERLET) return substeps + 1;
+    return substeps;
+}
+
+// Integration (Euler Method: NewValue = OldValue + (RateOfChange × Δt) ),
+// velocity first: the position moves with the velocity it ends up with
+static void step_semi_implicit(DroneState *d, double fx, double fy, double h, double drag)
+{
+    double ax = (fx - drag * d->vx) / MASS;
+    double ay = (fy - drag * d->vy) / MASS;
+    d->vx += ax * h;
+    d->vy += ay * h;
+    d->x += d->vx * h;
+    d->y += d->vy * h;
+}
+
+// m v' = F - k v with F constant has a closed form: v relaxes towards F / k
+// with rate k / m, and x follows the integral of that
+static void step_exact_drag(DroneState *d, double fx, double fy, double h, double drag)
+{
+    double rate = drag / MASS;
+    if (rate * h < 1e-12)
+    {
+        // No drag to speak of: constant acceleration
+        d->x += d->vx * h + 0.5 * fx / MASS * h * h;
+        d->y += d->vy * h + 0.5 * fy / MASS * h * h;
+        d->vx += fx / MASS * h;
+        d->vy += fy / MASS * h;
+        return;
+    }
+    double decay = exp(-rate * h);
+    double spread = -expm1(-rate * h) / rate; // Integral of the decay over the step
+    double tx = fx / drag, ty = fy / drag; // Terminal velocity
+    d->x += tx * h + (d->vx - tx) * spread;
+    d->y += ty * h + (d->vy - ty) * spread;
+    d->vx = tx + (d->vx - tx) * decay;
+    d->vy = ty + (d->vy - ty) * decay;
+}
+
+// Position from the start force and velocity, then the velocity from the average
+// of both ends; drag at the end uses the new velocity, solved in closed form
+static void step_verlet(DroneState *d, double *fx, double *fy, double h, double drag, ForceField field, void *ctx)
+{
+    double ax = (*fx - drag * d->vx) / MASS;
+    double ay = (*fy - drag * d->vy) / MASS;
+    d->x += d->vx * h + 0.5 * ax * h * h;
+    d->y += d->vy * h + 0.5 * ay * h * h;
+    double hvx = d->vx + 0.5 * ax * h;
+    double hvy = d->vy + 0.5 * ay * h;
+
+    field(d, ctx, fx, fy); // Also the start force of the next substep
+    double damp = 1.0 + 0.5 * h * drag / MASS;
+    d->vx = (hvx + 0.5 * h * *fx / MASS) / damp;
+    d->vy = (hvy + 0.5 * h * *fy / MASS) / damp;
+}
+
+// Rate of change of (x, y, vx, vy) at 's'
+static void derivative(const DroneState *s, double drag, ForceField field, void *ctx, double out[4])
+{
+    double fx, fy;
+    field(s, ctx, &fx, &fy);
+    out[0] = s->vx;
+    out[1] = s->vy;
+    out[2] = (fx - drag * s->vx) / MASS;
+    out[3] = (fy - drag * s->vy) / MASS;
+}
+
+static void step_rk4(DroneState *d, double fx, double fy, double h, double drag, ForceField field, void *ctx)
+{
+    double k1[4] = { d->vx, d->vy, (fx - drag * d->vx) / MASS, (fy - drag * d->vy) / MASS };
+    double k2[4], k3[4], k4[4];
+    DroneState s = *d;
+
+    s.x = d->x + 0.5 * h * k1[0]; s.y = d->y + 0.5 * h * k1[1];
+    s.vx = d->vx + 0.5 * h * k1[2]; s.vy = d->vy + 0.5 * h * k1[3];
+    derivative(&s, drag, field, ctx, k2);
+    s.x = d->x + 0.5 * h * k2[0]; s.y = d->y + 0.5 * h * k2[1];
+    s.vx = d->vx + 0.5 * h * k2[2]; s.vy = d->vy + 0.5 * h * k2[3];
+    derivative(&s, drag, field, ctx, k3);
+    s.x = d->x + h * k3[0]; s.y = d->y + h * k3[1];
+    s.vx = d->vx + h * k3[2]; s.vy = d->vy + h * k3[3];
+    derivative(&s, drag, field, ctx, k4);
+
+    d->x += h / 6.0 * (k1[0] + 2.0 * k2[0] + 2.0 * k3[0] + k4[0]);
+    d->y += h / 6.0 * (k1[1] + 2.0 * k2[1] + 2.0 * k3[1] + k4[1]);
+    d->vx += h / 6.0 * (k1[2] + 2.0 * k2[2] + 2.0 * k3[2] + k4[2]);
+    d->vy += h / 6.0 * (k1[3] + 2.0 * k2[3] + 2.0 * k3[3] + k4[3]);
+}
+
+void integrate(DroneState *drone, double dt, const Integrator *integrator, ForceField field, void *ctx)
+{
+    int kind = integrator ? integrator->kind : INTEGRATOR_SEMI_IMPLICIT;
+    int substeps = integrator ? integrator->substeps : 1;
+    if (substeps < 1) substeps = 1;
+    if (substeps > MAX_SUBSTEPS) substeps = MAX_SUBSTEPS;
+    double drag = integrator ? integrator->drag : DRAG_COEF;
+    double h = dt / substeps;
+
+    double fx, fy;
+    field(drone, ctx, &fx, &fy);
+    // What the display and the recorder show: the net force the frame started with
+    drone->force_x = fx - drag * drone->vx;
+    drone->force_y = fy - drag * drone->vy;
+
+    for (int s = 0; s < substeps; s++)
+    {
+        // Verlet carries the force at the end of a substep over to the next one
+        if (s > 0 && kind != INTEGRATOR_VERLET) field(drone, ctx, &fx, &fy);
+        switch (kind)
+        {
+            case INTEGRATOR_VERLET: step_verlet(drone, &fx, &fy, h, drag, field, ctx); break;
+            case INTEGRATOR_RK4: step_rk4(drone, fx, fy, h, drag, field, ctx); break;
+            case INTEGRATOR_EXACT_DRAG: step_exact_drag(drone, fx, fy, h, drag); break;
+            default: step_semi_implicit(drone, fx, fy, h, drag); break;
+        }
+    }
+}
@@ -28,7 +28,6 @@ int main(int argc, char *argv[])
     // PIPE SETUP + Checking their errros
     // PIPE SETUP + Checking their errros
     char fifoKD[100];
-    char fifoBBDIS[100];
 
     char suffix[50] = "";
     if (argc > 1) {
@@ -36,17 +35,31 @@ int main(int argc, char *argv[])
     }
 
     snprintf(fifoKD, sizeof(fifoKD), "/tmp/fifoKD%s", suffix);
-    snprintf(fifoBBDIS, sizeof(fifoBBDIS), "/tmp/fifoBBDIS%s", suffix);
     
     if (mkfifo(fifoKD, 0666) == -1 && errno != EEXIST) { perror("Keyboard: Failed to create fifoKD"); exit(EXIT_FAILURE); }
 
-    if (mkfifo(fifoBBDIS, 0666) == -1 && errno != EEXIST) { perror("Keyboard: Failed to create fifoBBDIS"); exit(EXIT_FAILURE); }
-
     int fd_KD = open(fifoKD, O_WRONLY);  
     if (fd_KD == -1) { perror("Pipe From Keyboard to Drone: open write"); exit(1); }
-    // Non-blocking read for display data so input doesn't lag
-    int fd_BBDIS = open(fifoBBDIS, O_RDONLY | O_NONBLOCK);
-    if (fd_BBDIS == -1) { perror("Pipe From Blackboard server to Keyboard Manager: open read"); exit(1); }
+    FrameWriter kd_writer;
+    frame_writer_init(&kd_writer, fd_KD);
+    // Display data comes from the shared blackboard, so reading it never blocks input
+    SharedBoard *board = board_attach(suffix);
+    if (board == NULL) { perror("Keyboard: attach shared board"); exit(1); }
+    board_set_ready(board, COMPONENT_KEYBOARD); // fifoKD is open, the drone may treat EOF as a disconnect
+    heartbeat_start(board, COMPONENT_KEYBOARD, INPUT_PERIOD_US * 1000ULL);
+
+    // HEADLESS MODE
+    // With an input script there is no terminal: replay it and exit
+    if (argc > 2) 
+    {
+        signal(SIGPIPE, SIG_IGN);
+        int rc = play_input_script(argv[2], &kd_writer, board, &keep_running);
+        close(fd_KD);
+        heartbeat_stop(board, COMPONENT_KEYBOARD);
+        board_detach(board);
+        log_msg("KEYBOARD", "Exiting cleanly");
+        return rc == 0 ? 0 : 1;
+    }
 
     // NCURSES SETUP
     initscr();
@@ -73,11 +86,13 @@ int main(int argc, char *argv[])
     WorldState current_state; 
     
     // Init state to zero
-    memset(&current_state, 0, sizeof(WorldState));
+    memset(&current_state, 0, sizeof(WorldState)); // No entity arrays: only the scalars are displayed
 
     // MAIN LOOP
     while(keep_running) 
     {
+        heartbeat_beat(board, COMPONENT_KEYBOARD);
+
         int ch;
         int last_ch = 0;
         char cmd = 0;
@@ -197,10 +212,9 @@ int main(int argc, char *argv[])
         msg.force_x = fx;  // Normalized direction (-1 to +1)
         msg.force_y = fy;
         msg.command = cmd;
+        msg.drone = 0;     // The keyboard always flies the player
 
-        ssize_t bytesWrittenKD = write(fd_KD, &msg, sizeof(msg));
-
-        if (bytesWrittenKD == -1) 
+        if (frame_send(&kd_writer, MSG_INPUT, &msg, sizeof(msg)) == -1) 
         {
             if (errno != EPIPE && errno != EAGAIN) 
             {
@@ -223,16 +237,9 @@ int main(int argc, char *argv[])
         else if (cmd != 0) log_msg("INPUT", "Command received: %c", cmd);
 
         // READ DATA FROM BLACKBOARD
-        // Non-blocking read
-        ssize_t bytes = read(fd_BBDIS, &current_state, sizeof(WorldState));
-        if (bytes == -1) 
-        {
-            if (errno != EAGAIN) 
-            {
-                log_msg("KEYBOARD", "Error reading from Blackboard Pipe: %s", strerror(errno));
-            }
-        } 
-        else if (bytes == 0) 
+        // Always the newest published frame, never a backlog of old ones
+        uint32_t seq = board_snapshot(board, &current_state);
+        if (atomic_load(&board->closed)) 
         {
             fprintf(stderr, "Keyboard: Server closed connection\n");
             keep_running = 0;
@@ -242,14 +249,14 @@ int main(int argc, char *argv[])
         draw_input_display(win_input, last_ch);
         
         // Only update dynamics if we actually have data (or at least draw the initial frame)
-        if (bytes > 0 || current_state.drone.x != 0) 
+        if (seq != 0 || current_state.drone.x != 0) 
         {
             draw_dynamics_display(win_dynamics, &current_state);
         }
 
         // TIMING
         // 30ms sleep 
-        usleep(30000);
+        usleep(INPUT_PERIOD_US);
     }
 
     // CLEANUP
@@ -257,7 +264,8 @@ int main(int argc, char *argv[])
     delwin(win_dynamics);
     endwin();
     close(fd_KD);
-    close(fd_BBDIS);
+    heartbeat_stop(board, COMPONENT_KEYBOARD);
+    board_detach(board);
     log_msg("KEYBOARD", "Exiting cleanly");
     return 0;
 }
\ No newline at end of file
@@ -2,8 +2,17 @@
 #define KEYBOARDMANAGER_H
 
 #include <ncurses.h>
+#include <signal.h>
 #include "../common.h"
 
+// Period of the input loop (interactive and scripted)
+#define INPUT_PERIOD_US 30000
+
+// Max entries read from a headless input script
+#define MAX_SCRIPT_STEPS 4096
+// Input streams a script can address with '@<drone>'
+#define MAX_SCRIPT_DRONES 1024
+
 //FUNCTIONS
 
 // Draws the 3x3 control grid and highlights the active key
@@ -12,4 +21,31 @@ void draw_input_display(WINDOW *win, int last_ch) ;
 // Displays the Physics Data received from Blackboard
 void draw_dynamics_display(WINDOW *win, WorldState *state);
 
+// HEADLESS MODE
+// A timed input script (format in Keyboard_functions.c), replayed against a clock
+typedef struct {
+    long time_ms;
+    int drone;
+    char command;       // 0 for force-only steps
+    int sets_force;
+    float force_x, force_y;
+} ScriptStep;
+
+typedef struct {
+    ScriptStep steps[MAX_SCRIPT_STEPS];
+    int count;
+    int next;                             // First step not applied yet
+    InputMsg streams[MAX_SCRIPT_DRONES];  // Held input per drone, this frame's commands included
+    int n_streams;
+} ScriptPlayer;
+
+// Returns -1 if the script cannot be read
+int script_player_load(ScriptPlayer *player, const char *path);
+// Applies every step due at 'now_ms' to the streams; returns 1 once the player quits
+int script_player_advance(ScriptPlayer *player, long now_ms);
+
+// Replays a timed input script to the drone instead of reading the keyboard;
+// beats the keyboard's heartbeat on 'board' every frame
+int play_input_script(const char *path, FrameWriter *kd_writer, SharedBoard *board, volatile sig_atomic_t *running);
+
 #endif 
\ No newline at end of file
@@ -1,5 +1,10 @@
 #include <ncurses.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h> 
@@ -167,4 +172,142 @@ void draw_dynamics_display(WINDOW *win, WorldState *state)
     mvwprintw(win, 22, 2, "MODE: 8-Direction");
     
     wrefresh(win);
+}
+
+// HEADLESS MODE
+/*  Script format, one step per line ('#' starts a comment):
+        <time_ms> [@<drone>] start | reset | quit | brake | idle | thrust <fx> <fy>
+    Times are measured from the start of playback. 'thrust' and 'idle' set a
+    force that is held until the next one; the other actions are one-shot
+    commands. Reaching the end of the script sends a quit.
+    '@<drone>' sends the step down that drone's input stream (default 0, the
+    player); agents only act on brake, idle and thrust.
+*/
+static long elapsed_ms(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000L + (now.tv_nsec - start->tv_nsec) / 1000000L;
+}
+
+static int parse_script(const char *path, ScriptStep steps[], int max_steps)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) return -1;
+
+    char line[256];
+    int count = 0;
+    int line_no = 0;
+    while (fgets(line, sizeof(line), f) && count < max_steps)
+    {
+        line_no++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char action[32];
+        ScriptStep step = {0};
+        int fields = sscanf(line, "%ld @%d %31s %f %f", &step.time_ms, &step.drone, action, &step.force_x, &step.force_y);
+        if (fields >= 2) fields--; // Addressed step: same fields as below plus the drone
+        else fields = sscanf(line, "%ld %31s %f %f", &step.time_ms, action, &step.force_x, &step.force_y);
+        if (fields < 2) continue; // Blank or comment line
+        if (step.drone < 0 || step.drone >= MAX_SCRIPT_DRONES)
+        {
+            log_msg("KEYBOARD", "Input script %s:%d: drone %d out of range", path, line_no, step.drone);
+            continue;
+        }
+
+        if (strcmp(action, "start") == 0) step.command = 's';
+        else if (strcmp(action, "reset") == 0) step.command = 'r';
+        else if (strcmp(action, "quit") == 0) step.command = 'q';
+        else if (strcmp(action, "brake") == 0) step.command = ' ';
+        else if (strcmp(action, "idle") == 0) { step.sets_force = 1; step.force_x = 0; step.force_y = 0; }
+        else if (strcmp(action, "thrust") == 0 && fields == 4) step.sets_force = 1;
+        else
+        {
+            log_msg("KEYBOARD", "Input script %s:%d: cannot parse '%s'", path, line_no, action);
+            continue;
+        }
+        steps[count++] = step;
+    }
+    fclose(f);
+    return count;
+}
+
+int script_player_load(ScriptPlayer *player, const char *path)
+{
+    memset(player, 0, sizeof(*player));
+    player->count = parse_script(path, player->steps, MAX_SCRIPT_STEPS);
+    if (player->count < 0) return -1;
+
+    // One held input per drone stream; every stream up to the highest drone named goes out each frame
+    player->n_streams = 1;
+    for (int i = 0; i < player->count; i++)
+    {
+        if (player->steps[i].drone >= player->n_streams) player->n_streams = player->steps[i].drone + 1;
+    }
+    for (int d = 0; d < player->n_streams; d++) player->streams[d] = (InputMsg){ 0, 0, 0, (uint32_t)d };
+    return 0;
+}
+
+int script_player_advance(ScriptPlayer *player, long now_ms)
+{
+    // Apply every force change that is due, but at most one command per
+    // stream and frame so the drone sees each of them
+    for (int d = 0; d < player->n_streams; d++) player->streams[d].command = 0;
+    while (player->next < player->count && player->steps[player->next].time_ms <= now_ms)
+    {
+        const ScriptStep *step = &player->steps[player->next];
+        InputMsg *in = &player->streams[step->drone];
+        if (step->command != 0)
+        {
+            if (in->command != 0) break;
+            in->command = step->command;
+        }
+        if (step->sets_force)
+        {
+            in->force_x = step->force_x;
+            in->force_y = step->force_y;
+        }
+        player->next++;
+    }
+    if (player->next >= player->count && player->streams[0].command == 0) player->streams[0].command = 'q'; // Script finished
+    return player->streams[0].command == 'q';
+}
+
+int play_input_script(const char *path, FrameWriter *kd_writer, SharedBoard *board, volatile sig_atomic_t *running)
+{
+    static ScriptPlayer player;
+    if (script_player_load(&player, path) == -1)
+    {
+        log_msg("KEYBOARD", "Cannot open input script %s: %s", path, strerror(errno));
+        return -1;
+    }
+    log_msg("KEYBOARD", "Headless: playing %d scripted steps from %s", player.count, path);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (*running)
+    {
+        heartbeat_beat(board, COMPONENT_KEYBOARD);
+        long now_ms = elapsed_ms(&start);
+        int finished = script_player_advance(&player, now_ms);
+
+        // Agents first, so the player's quit is the last frame of the run
+        for (int d = player.n_streams - 1; d >= 0; d--)
+        {
+            if (frame_send(kd_writer, MSG_INPUT, &player.streams[d], sizeof(InputMsg)) == -1)
+            {
+                log_msg("KEYBOARD", "Headless: drone pipe closed: %s", strerror(errno));
+                return -1;
+            }
+        }
+        if (finished)
+        {
+            log_msg("KEYBOARD", "Headless: script finished after %ld ms", now_ms);
+            return 0;
+        }
+        usleep(INPUT_PERIOD_US);
+    }
+    return 0;
 }
\ No newline at end of file
@@ -4,48 +4,236 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <netinet/tcp.h>
 #include <errno.h>
 #include <stdarg.h>
-#include "common.h" 
+#include "common.h"
 
 /* NetworkProcess.c - ROBUST VERSION
    - Uses Ring Buffer to handle TCP fragmentation
    - Handles Assignment 3 Handshake (size w, h)
    - Triggers Client Window Resize via Blackboard
+   - Negotiates the binary state stream (NET_PROTO_BINARY) in that handshake and
+     falls back to the drone/dok/obst/pok text exchange for peers without it
+   - One epoll loop over the sockets and both pipes; nothing blocks on a peer,
+     so the local drone keeps draining whatever the peers are doing
+   - Server role is a session host: up to NET_MAX_PEERS peers, each with its own
+     link. Every local tick fans out to all of them, and binary peers also get
+     the other peers' drones relayed. All remote drones go to the Blackboard as
+     one MSG_OBSTACLES frame
+   - With NET_PROTO_UDP negotiated, the state stream goes over UDP with the last
+     NET_UDP_REDUNDANCY local states in every datagram; TCP stays for the rest
+   - With NET_PROTO_SNAPSHOT negotiated, the host sends the world as delta
+     snapshots against the newest one the peer acknowledged
+   Usage: ./network_process <mode> <port> <ip> [binary|text|snapshot] [tcp|udp]
 */
 
+// Where a link is; every line or frame from the peer moves it on
+typedef enum {
+    PHASE_FREE,          // Unused peer slot
+    PHASE_CONNECTING,    // Client: connect() in progress, or waiting to retry
+    PHASE_WAIT_OK,       // Client: "ok"
+    PHASE_WAIT_OOK,      // Server: "ook [bin1]"
+    PHASE_WAIT_SIZE,     // Client: "size w, h [bin1]"
+    PHASE_WAIT_SOK,      // Server: "sok w h"
+    PHASE_TEXT_IDLE,     // Server: next exchange starts at the deadline
+    PHASE_TEXT_DOK,      // Server: sent drone + coords, waiting "dok"
+    PHASE_TEXT_OBST_XY,  // Server: sent "obst", waiting the client's coords
+    PHASE_TEXT_DRONE,    // Client: "drone" (or "q")
+    PHASE_TEXT_DRONE_XY, // Client: the server's coords
+    PHASE_TEXT_OBST,     // Client: "obst"
+    PHASE_TEXT_POK,      // Client: "pok"
+    PHASE_BINARY         // Both: NetStateFrames each way, no acks
+} LinkPhase;
 
-// Helpers 
+// epoll tokens: peer slots are 0..NET_MAX_PEERS-1
+#define TOKEN_PIPE_IN  (NET_MAX_PEERS + 0)
+#define TOKEN_PIPE_OUT (NET_MAX_PEERS + 1)
+#define TOKEN_LISTEN   (NET_MAX_PEERS + 2)
+#define TOKEN_UDP      (NET_MAX_PEERS + 3)
+
+typedef struct {
+    LinkContext link;        // Socket, receive ring, send queue
+    int slot;                // Server: its drone is id slot + 1 on the wire
+    LinkPhase phase;
+    int binary;
+    uint64_t deadline_ns;    // Next text exchange (server) or connect retry (client); 0 = none
+    int snapshot_pending;    // A tick found the socket backed up: send every drone once it drains
+    int watching_out;        // EPOLLOUT is in its epoll mask
+
+    // UDP state stream
+    int udp;
+    uint32_t token;          // Host: slot in the low byte
+    struct sockaddr_in udp_addr; // Host: where its datagrams come from
+    int udp_known;           // Host: until then the stream stays on TCP
+
+    // Delta snapshots (host side)
+    int snap;
+    int has_ack;
+    uint32_t acked;          // Newest snapshot tick it applied: the baseline
+    uint32_t sent_tick;      // Newest one sent
+} NetPeer;
+
+// A drone somewhere else, by wire id. Server: the peers' (1..); client: the host's (0) and relayed ones
+typedef struct {
+    int active;
+    int dirty;               // Changed since the last fan-out
+    uint32_t seq;
+    uint64_t sent_ns;
+    float x, y, vx, vy;      // Virtual coordinates
+} RemoteDrone;
+
+typedef struct {
+    int role;
+    int epoll_fd;
+    int listen_fd;           // Server role
+    int pipe_in_fd, pipe_out_fd;
+    struct sockaddr_in addr; // Client role: where to connect
+    const char *target_ip;
+    int want_binary;
+    int want_udp;
+    int want_snap;
+    int udp_fd;              // -1 unless UDP is wanted (host) or was agreed (client)
+    int done;
+
+    FrameReader bb_reader;
+    FrameWriter bb_writer;
+    DroneState local;        // Newest drone from the Blackboard
+    uint64_t local_ns;       // When it arrived: the sent_ns of its frames
+    uint32_t tx_seq;
+    NetStateFrame history[NET_UDP_REDUNDANCY]; // The local drone's last frames, newest first
+    int n_history;
+
+    NetPeer *peers[NET_MAX_PEERS]; // Client role: peers[0] is the host
+    int n_peers;
+    RemoteDrone remotes[NET_MAX_PEERS + 1];
+    int relay_dirty;         // Host: a peer's drone changed since the last fan-out
+    int obstacles_dirty;     // The remote drones changed since the Blackboard last got them
+    int obstacles_pending;   // ... and its pipe had no room: wait for EPOLLOUT
+    long dropped;            // Stale frames
+    long udp_sent, udp_received;
+    long lost;               // UDP: states of a drone that never arrived, redundancy included
+
+    // Host: the world as sent, by tick. Client: the snapshots received, by tick
+    NetSnapshot snaps[NET_SNAP_HISTORY];
+    NetSnapshot next_world;  // Host: the world being taken, kept only if it changed
+    uint32_t snap_tick;      // Host: newest world. Client: newest applied (0 = none)
+    int ack_pending;         // Client: snap_tick goes out with the next local state
+    long snap_sent, snap_full, snap_bytes;
+} NetSession;
+
+// Helpers
 float to_virtual_y(float y) { return (float)(MAP_HEIGHT - 1) - y; }
 float to_local_y(float y) { return (float)(MAP_HEIGHT - 1) - y; }
 
-// ROBUST RECEIVER (The Fix for Fragmentation)
-int recv_line(LinkContext *ctx, char *dest, int max_len) 
+static void watch(int epoll_fd, int op, int fd, uint32_t token, uint32_t events)
+{
+    struct epoll_event ev = {0};
+    ev.events = events;
+    ev.data.u32 = token;
+    epoll_ctl(epoll_fd, op, fd, &ev);
+}
+
+// RECEIVE RING (The Fix for Fragmentation)
+// Reads whatever the socket has into the free part of the ring, which may wrap.
+// Returns the bytes read, 0 when the peer closed, -1 with errno (EAGAIN = drained)
+static ssize_t ring_fill(LinkContext *ctx)
+{
+    uint32_t used = ctx->buf_end - ctx->buf_start;
+    uint32_t free_bytes = BUFFER_CAP - used;
+    if (free_bytes == 0)
+    {
+        errno = ENOBUFS;
+        return -1;
+    }
+    uint32_t at = ctx->buf_end & (BUFFER_CAP - 1);
+    uint32_t first = BUFFER_CAP - at;
+    if (first > free_bytes) first = free_bytes;
+    struct iovec iov[2] = {
+        { ctx->net_buffer + at, first },
+        { ctx->net_buffer, free_bytes - first }
+    };
+    ssize_t n = readv(ctx->conn_fd, iov, (free_bytes > first) ? 2 : 1);
+    if (n > 0) ctx->buf_end += (uint32_t)n;
+    return n;
+}
+
+// Copies 'len' bytes from the front of the ring without taking them; 0 if fewer are buffered
+static int ring_peek(const LinkContext *ctx, void *dest, uint32_t len)
+{
+    if (ctx->buf_end - ctx->buf_start < len) return 0;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        ((char *)dest)[i] = ctx->net_buffer[(ctx->buf_start + i) & (BUFFER_CAP - 1)];
+    }
+    return 1;
+}
+
+// Copies 'len' bytes out of the ring; 0 if fewer are buffered
+static int ring_take(LinkContext *ctx, void *dest, uint32_t len)
+{
+    if (!ring_peek(ctx, dest, len)) return 0;
+    ctx->buf_start += len;
+    return 1;
+}
+
+// Takes one '\n'-terminated line out of the ring; 0 if no full line is buffered
+static int ring_line(LinkContext *ctx, char *dest, int max_len)
 {
     int line_idx = 0;
-    while (1) {
-        // 1. Drain internal buffer
-        while (ctx->buf_start < ctx->buf_end) {
-            char c = ctx->net_buffer[ctx->buf_start++];
-            if (c == '\n') 
-            {
-                dest[line_idx] = '\0'; 
-                return line_idx; 
-            }
-            if (line_idx < max_len - 1) dest[line_idx++] = c;
+    for (uint32_t i = ctx->buf_start; i != ctx->buf_end; i++)
+    {
+        char c = ctx->net_buffer[i & (BUFFER_CAP - 1)];
+        if (c == '\n')
+        {
+            dest[line_idx] = '\0';
+            ctx->buf_start = i + 1;
+            return 1;
         }
-        // 2. Refill buffer from socket
-        ctx->buf_start = 0;
-        int n = read(ctx->conn_fd, ctx->net_buffer, BUFFER_CAP);
-        if (n <= 0) return -1; // Disconnect or Error
-        ctx->buf_end = n;
+        if (line_idx < max_len - 1) dest[line_idx++] = c;
     }
+    return 0;
+}
+
+// SEND QUEUE
+// Writes what the socket takes and keeps the rest for EPOLLOUT; -1 if the peer is gone
+static int flush_tx(NetSession *s, NetPeer *peer)
+{
+    LinkContext *ctx = &peer->link;
+    while (ctx->tx_len > 0)
+    {
+        ssize_t n = send(ctx->conn_fd, ctx->tx_buffer, ctx->tx_len, MSG_NOSIGNAL);
+        if (n == -1 && errno == EINTR) continue;
+        if (n == -1 && errno == EAGAIN) break;
+        if (n <= 0) return -1;
+        memmove(ctx->tx_buffer, ctx->tx_buffer + n, ctx->tx_len - n);
+        ctx->tx_len -= (int)n;
+    }
+    // EPOLLOUT only while something waits
+    if ((ctx->tx_len > 0) != peer->watching_out)
+    {
+        peer->watching_out = ctx->tx_len > 0;
+        watch(s->epoll_fd, EPOLL_CTL_MOD, ctx->conn_fd, peer->slot, EPOLLIN | (peer->watching_out ? EPOLLOUT : 0));
+    }
+    return 0;
 }
 
-ssize_t send_line(int fd, const char *format, ...) 
+// Appends to the queue without writing; -1 if it does not fit
+static int queue_bytes(NetPeer *peer, const void *data, int len)
+{
+    LinkContext *ctx = &peer->link;
+    if (ctx->tx_len + len > NET_TX_CAP) return -1; // The peer stopped reading altogether
+    memcpy(ctx->tx_buffer + ctx->tx_len, data, len);
+    ctx->tx_len += len;
+    return 0;
+}
+
+static int send_line(NetSession *s, NetPeer *peer, const char *format, ...)
 {
     char payload[BUFFER_CAP];
     va_list args;
@@ -53,160 +241,904 @@ ssize_t send_line(int fd, const char *format, ...)
     vsnprintf(payload, sizeof(payload), format, args);
     va_end(args);
     strncat(payload, "\n", BUFFER_CAP - strlen(payload) - 1);
-    return write(fd, payload, strlen(payload));
+    if (queue_bytes(peer, payload, (int)strlen(payload)) == -1) return -1;
+    return flush_tx(s, peer);
+}
+
+static void queue_frame(NetPeer *peer, uint8_t type, uint8_t drone, uint32_t seq, uint64_t sent_ns,
+                        float x, float y, float vx, float vy)
+{
+    NetStateFrame frame = { type, drone, seq, sent_ns, x, y, vx, vy };
+    uint8_t bytes[NET_FRAME_BYTES];
+    net_frame_encode(&frame, bytes);
+    queue_bytes(peer, bytes, sizeof(bytes));
+}
+
+// UDP STATE STREAM
+// Nothing waits on a datagram: one the socket has no room for is only a state
+// that a newer one replaces
+// 'count' frames after the header, then 'extra' bytes (a snapshot)
+static void udp_send(NetSession *s, NetPeer *peer, uint8_t *buf, int count, int extra)
+{
+    net_udp_header_encode(buf, count, peer->token);
+    size_t len = NET_UDP_HEADER_BYTES + (size_t)count * NET_FRAME_BYTES + (size_t)extra;
+    ssize_t n = (s->role == 1) ? sendto(s->udp_fd, buf, len, 0, (struct sockaddr *)&peer->udp_addr, sizeof(peer->udp_addr))
+                               : send(s->udp_fd, buf, len, 0);
+    if (n == (ssize_t)len) s->udp_sent++;
+}
+
+// Oldest local state first, so a receiver applies them in order; the relayed
+// drones that changed follow, as many datagrams as they take
+static int send_datagrams(NetSession *s, NetPeer *peer, int with_local, int full)
+{
+    static uint8_t buf[NET_UDP_HEADER_BYTES + NET_UDP_MAX_FRAMES * NET_FRAME_BYTES];
+    int count = 0;
+    if (with_local && peer->snap && s->snap_tick != 0)
+    {
+        // Every datagram acks, so a lost one costs the host no more than a tick
+        NetStateFrame ack = { NET_ACK, 0, s->snap_tick, 0, 0, 0, 0, 0 };
+        net_frame_encode(&ack, buf + NET_UDP_HEADER_BYTES + count++ * NET_FRAME_BYTES);
+        s->ack_pending = 0;
+    }
+    if (with_local || full)
+    {
+        for (int i = s->n_history - 1; i >= 0; i--)
+        {
+            net_frame_encode(&s->history[i], buf + NET_UDP_HEADER_BYTES + count++ * NET_FRAME_BYTES);
+        }
+    }
+    for (int id = 1; s->role == 1 && id <= NET_MAX_PEERS; id++)
+    {
+        const RemoteDrone *r = &s->remotes[id];
+        if (!r->active || id == peer->slot + 1 || !(full || r->dirty)) continue;
+        NetStateFrame frame = { NET_STATE, (uint8_t)id, r->seq, r->sent_ns, r->x, r->y, r->vx, r->vy };
+        net_frame_encode(&frame, buf + NET_UDP_HEADER_BYTES + count++ * NET_FRAME_BYTES);
+        if (count == NET_UDP_MAX_FRAMES)
+        {
+            udp_send(s, peer, buf, count, 0);
+            count = 0;
+        }
+    }
+    if (count > 0) udp_send(s, peer, buf, count, 0);
+    return 0;
+}
+
+// DELTA SNAPSHOTS
+// Same drones on the same quantized states (ticks aside)
+static int same_world(const NetSnapshot *a, const NetSnapshot *b)
+{
+    if (memcmp(a->present, b->present, sizeof(a->present)) != 0) return 0;
+    for (int id = 0; id < NET_SNAP_ENTITIES; id++)
+    {
+        if (!(a->present[id >> 3] & (1u << (id & 7)))) continue;
+        const NetSnapEntity *ea = &a->entities[id], *eb = &b->entities[id];
+        if (ea->x != eb->x || ea->y != eb->y || ea->vx != eb->vx || ea->vy != eb->vy) return 0;
+    }
+    return 1;
+}
+
+// Host, once per fan-out: the world every snapshot of this round encodes. A world
+// that quantizes to the newest snapshot keeps its tick, so peers that acked it
+// stay on a live baseline however long nothing moves
+static void take_world(NetSession *s)
+{
+    NetSnapshot *next = &s->next_world;
+    net_snap_clear(next, 0);
+    if (s->n_history > 0)
+    {
+        const NetStateFrame *f = &s->history[0];
+        net_snap_set(next, 0, f->x, f->y, f->vx, f->vy);
+    }
+    for (int id = 1; id <= NET_MAX_PEERS; id++)
+    {
+        const RemoteDrone *r = &s->remotes[id];
+        if (r->active) net_snap_set(next, id, r->x, r->y, r->vx, r->vy);
+    }
+    if (s->snap_tick != 0 && same_world(next, &s->snaps[s->snap_tick % NET_SNAP_HISTORY])) return;
+
+    if (++s->snap_tick == 0) s->snap_tick = 1; // 0 means no baseline
+    next->tick = s->snap_tick;
+    s->snaps[s->snap_tick % NET_SNAP_HISTORY] = *next;
 }
 
-int establish_link(int role, const char *target_ip, int port) 
+// The world against the newest snapshot the peer acked, while that is still
+// kept. Nothing goes out once the peer has acked everything there is
+static int send_world(NetSession *s, NetPeer *peer)
 {
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    static uint8_t buf[NET_UDP_HEADER_BYTES + NET_SNAP_MAX_BYTES];
+    if (s->snap_tick == 0) return 0;
+    const NetSnapshot *world = &s->snaps[s->snap_tick % NET_SNAP_HISTORY];
+    const NetSnapshot *base = NULL;
+    if (peer->has_ack && s->snap_tick - peer->acked < NET_SNAP_HISTORY) base = &s->snaps[peer->acked % NET_SNAP_HISTORY];
+
+    int entries;
+    int len = net_snap_encode(world, base, peer->slot + 1, buf + NET_UDP_HEADER_BYTES, &entries);
+    if (entries == 0 && base != NULL && peer->sent_tick == peer->acked) return 0;
+    peer->sent_tick = s->snap_tick;
+    s->snap_sent++;
+    s->snap_full += base == NULL;
+    s->snap_bytes += len;
+    if (peer->udp && peer->udp_known)
+    {
+        udp_send(s, peer, buf, 0, len);
+        return 0;
+    }
+    if (queue_bytes(peer, buf + NET_UDP_HEADER_BYTES, len) == -1) return -1;
+    return flush_tx(s, peer);
+}
+
+// The local drone if it is new, and for a host the other peers' drones that
+// changed (everything after a backlog). Latest state wins: while the socket is
+// backed up nothing is queued, and one full snapshot goes out once it drains
+static int send_snapshot(NetSession *s, NetPeer *peer, int with_local)
+{
+    if (peer->link.tx_len > 0)
+    {
+        peer->snapshot_pending = 1;
+        return 0;
+    }
+    int full = peer->snapshot_pending;
+    peer->snapshot_pending = 0;
+    if (s->role == 1 && peer->snap) return send_world(s, peer);
+    if (peer->udp && (s->role != 1 || peer->udp_known)) return send_datagrams(s, peer, with_local, full);
+    if (with_local && peer->snap && s->ack_pending)
+    {
+        queue_frame(peer, NET_ACK, 0, s->snap_tick, 0, 0, 0, 0, 0);
+        s->ack_pending = 0;
+    }
+    if ((with_local || full) && s->n_history > 0)
+    {
+        uint8_t bytes[NET_FRAME_BYTES];
+        net_frame_encode(&s->history[0], bytes);
+        queue_bytes(peer, bytes, sizeof(bytes));
+    }
+    if (s->role == 1)
+    {
+        for (int id = 1; id <= NET_MAX_PEERS; id++)
+        {
+            const RemoteDrone *r = &s->remotes[id];
+            if (!r->active || id == peer->slot + 1 || !(full || r->dirty)) continue;
+            queue_frame(peer, NET_STATE, (uint8_t)id, r->seq, r->sent_ns, r->x, r->y, r->vx, r->vy);
+        }
+    }
+    return flush_tx(s, peer);
+}
+
+// BLACKBOARD PIPES
+// Every remote drone goes to the Blackboard in one obstacle frame. The pipe is
+// non-blocking: when it is full the newest set waits for EPOLLOUT
+static void flush_obstacles(NetSession *s)
+{
+    static Obstacle obstacles[NET_MAX_PEERS + 1];
+    int n = 0;
+    for (int id = 0; id <= NET_MAX_PEERS; id++)
+    {
+        const RemoteDrone *r = &s->remotes[id];
+        if (!r->active) continue;
+        memset(&obstacles[n], 0, sizeof(Obstacle));
+        obstacles[n].x = (int)r->x;
+        obstacles[n].y = (int)to_local_y(r->y);
+        obstacles[n].active = 1;
+        n++;
+    }
+    int blocked = frame_send(&s->bb_writer, MSG_OBSTACLES, obstacles, n * sizeof(Obstacle)) == -1 && errno == EAGAIN;
+    if (blocked != s->obstacles_pending)
+    {
+        watch(s->epoll_fd, blocked ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, s->pipe_out_fd, TOKEN_PIPE_OUT, EPOLLOUT);
+    }
+    s->obstacles_pending = blocked;
+    s->obstacles_dirty = blocked;
+}
+
+static void set_remote(NetSession *s, int id, uint32_t seq, uint64_t sent_ns, float x, float y, float vx, float vy)
+{
+    RemoteDrone *r = &s->remotes[id];
+    r->active = 1;
+    r->dirty = 1;
+    r->seq = seq;
+    r->sent_ns = sent_ns;
+    r->x = x; r->y = y; r->vx = vx; r->vy = vy;
+    s->relay_dirty = s->role == 1;
+    s->obstacles_dirty = 1;
+}
+
+// Newest drone state the Blackboard sent; returns 1 if there was one, -1 once it closed the pipe
+static int drain_local(NetSession *s)
+{
+    FrameHeader hdr;
+    const void *payload;
+    int fresh = 0;
+    ssize_t n;
+    while ((n = frame_fill(&s->bb_reader)) > 0)
+    {
+        while (frame_next(&s->bb_reader, &hdr, &payload))
+        {
+            if (hdr.type == MSG_DRONE_STATE && hdr.length == sizeof(DroneState))
+            {
+                memcpy(&s->local, payload, sizeof(DroneState));
+                fresh = 1;
+            }
+        }
+    }
+    if (fresh) s->local_ns = monotonic_ns();
+    return (n == 0 && !fresh) ? -1 : fresh;
+}
+
+// PEERS
+static NetPeer *add_peer(NetSession *s, int fd)
+{
+    int slot = 0;
+    while (slot < NET_MAX_PEERS && s->peers[slot] != NULL) slot++;
+    if (slot == NET_MAX_PEERS) return NULL;
+    NetPeer *peer = calloc(1, sizeof(NetPeer));
+    if (peer == NULL) return NULL;
+    peer->slot = slot;
+    peer->link.conn_fd = fd;
+    peer->link.pipe_in_fd = s->pipe_in_fd;
+    peer->link.pipe_out_fd = s->pipe_out_fd;
+    peer->link.role = s->role;
+    s->peers[slot] = peer;
+    s->n_peers++;
+    return peer;
+}
+
+static void link_up(NetSession *s, NetPeer *peer)
+{
+    int opt = 1;
+    setsockopt(peer->link.conn_fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt)); // Small frames go out at once
+    fcntl(peer->link.conn_fd, F_SETFL, fcntl(peer->link.conn_fd, F_GETFL, 0) | O_NONBLOCK);
+    peer->link.buf_start = peer->link.buf_end = 0;
+    peer->link.tx_len = 0;
+}
+
+// Server: the peer's drone leaves the table and the other binary peers are told.
+// Client: losing the host ends the session
+static void drop_peer(NetSession *s, NetPeer *peer, const char *why)
+{
+    epoll_ctl(s->epoll_fd, EPOLL_CTL_DEL, peer->link.conn_fd, NULL);
+    close(peer->link.conn_fd);
+    s->peers[peer->slot] = NULL;
+    s->n_peers--;
+    if (s->role != 1)
+    {
+        log_msg("NET", "Host %s", why);
+        s->done = 1;
+        free(peer);
+        return;
+    }
+
+    int id = peer->slot + 1;
+    log_msg("NET", "Peer %d: %s (%d connected)", id, why, s->n_peers);
+    if (s->remotes[id].active)
+    {
+        memset(&s->remotes[id], 0, sizeof(RemoteDrone));
+        s->obstacles_dirty = 1;
+        for (int k = 0; k < NET_MAX_PEERS; k++)
+        {
+            NetPeer *other = s->peers[k];
+            if (other == NULL || other->phase != PHASE_BINARY) continue;
+            queue_frame(other, NET_QUIT, (uint8_t)id, 0, monotonic_ns(), 0, 0, 0, 0);
+            flush_tx(s, other); // A dead link shows up as its own event
+        }
+    }
+    free(peer);
+}
+
+// Host: bound to the listening port number. Client: connected to the host's
+static int open_udp(NetSession *s)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (fd == -1) return -1;
+    struct sockaddr_in any = s->addr;
+    any.sin_addr.s_addr = INADDR_ANY;
+    int failed = (s->role == 1) ? bind(fd, (struct sockaddr *)&any, sizeof(any))
+                                : connect(fd, (struct sockaddr *)&s->addr, sizeof(s->addr));
+    if (failed == -1)
+    {
+        perror("NET: UDP socket");
+        close(fd);
+        return -1;
+    }
+    s->udp_fd = fd;
+    watch(s->epoll_fd, EPOLL_CTL_ADD, fd, TOKEN_UDP, EPOLLIN);
+    return 0;
+}
+
+// CONNECTION
+static int open_listener(int port)
+{
+    int sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
     struct sockaddr_in s_addr = {0};
     s_addr.sin_family = AF_INET;
     s_addr.sin_port = htons(port);
-
-    if (role == 1) { // SERVER
-        s_addr.sin_addr.s_addr = INADDR_ANY;
-        int opt = 1;
-        setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-        bind(sockfd, (struct sockaddr *)&s_addr, sizeof(s_addr));
-        listen(sockfd, 1);
-        log_msg("NET", "Waiting for client on port %d...", port);
-        int c = accept(sockfd, NULL, NULL);
+    s_addr.sin_addr.s_addr = INADDR_ANY;
+    int opt = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (bind(sockfd, (struct sockaddr *)&s_addr, sizeof(s_addr)) == -1 || listen(sockfd, SOMAXCONN) == -1)
+    {
+        perror("NET: listen");
         close(sockfd);
-        return c;
-    } else { // CLIENT
-        struct hostent *h = gethostbyname(target_ip);
-        if(!h) return -1;
-        memcpy(&s_addr.sin_addr, h->h_addr_list[0], h->h_length);
-        while (connect(sockfd, (struct sockaddr *)&s_addr, sizeof(s_addr)) < 0) 
+        return -1;
+    }
+    log_msg("NET", "Hosting on port %d, up to %d peers...", port, NET_MAX_PEERS);
+    return sockfd;
+}
+
+// Non-blocking connect; the result shows up as EPOLLOUT on the socket
+static void start_connect(NetSession *s, NetPeer *peer)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    peer->link.conn_fd = fd;
+    peer->deadline_ns = 0;
+    if (connect(fd, (struct sockaddr *)&s->addr, sizeof(s->addr)) == 0 || errno == EINPROGRESS)
+    {
+        watch(s->epoll_fd, EPOLL_CTL_ADD, fd, peer->slot, EPOLLOUT);
+        return;
+    }
+    close(fd);
+    peer->link.conn_fd = -1;
+    log_msg("NET", "Connecting to %s...", s->target_ip);
+    peer->deadline_ns = monotonic_ns() + RETRY_SEC * 1000000000ULL;
+}
+
+static void on_connected(NetSession *s, NetPeer *peer)
+{
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(peer->link.conn_fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err != 0)
+    {
+        epoll_ctl(s->epoll_fd, EPOLL_CTL_DEL, peer->link.conn_fd, NULL);
+        close(peer->link.conn_fd);
+        peer->link.conn_fd = -1;
+        log_msg("NET", "Connecting to %s...", s->target_ip);
+        peer->deadline_ns = monotonic_ns() + RETRY_SEC * 1000000000ULL;
+        return;
+    }
+    link_up(s, peer);
+    watch(s->epoll_fd, EPOLL_CTL_MOD, peer->link.conn_fd, peer->slot, EPOLLIN);
+    peer->phase = PHASE_WAIT_OK;
+}
+
+// Every pending connection; a full session turns the newcomer away
+static void on_accept(NetSession *s)
+{
+    int fd;
+    while ((fd = accept(s->listen_fd, NULL, NULL)) >= 0)
+    {
+        NetPeer *peer = add_peer(s, fd);
+        if (peer == NULL)
         {
-            log_msg("NET", "Connecting to %s...", target_ip);
-            sleep(RETRY_SEC);
+            log_msg("NET", "Session full (%d peers), connection refused", s->n_peers);
+            close(fd);
+            continue;
+        }
+        link_up(s, peer);
+        watch(s->epoll_fd, EPOLL_CTL_ADD, fd, peer->slot, EPOLLIN);
+        peer->phase = PHASE_WAIT_OOK;
+        if (send_line(s, peer, "ok") == -1) drop_peer(s, peer, "disconnected");
+    }
+}
+
+static void start_stream(NetSession *s, NetPeer *peer)
+{
+    const char *protocol = peer->udp ? "binary over UDP" : (peer->binary ? "binary" : "text");
+    const char *snap = peer->snap ? " with delta snapshots" : "";
+    if (s->role == 1) log_msg("NET", "Peer %d connected, %s protocol%s (%d connected)", peer->slot + 1, protocol, snap, s->n_peers);
+    else log_msg("NET", "Peer connected, %s protocol%s", protocol, snap);
+    if (peer->binary)
+    {
+        peer->phase = PHASE_BINARY;
+        peer->snapshot_pending = 1; // Every drone with the next tick
+        if (peer->udp && s->role != 1) udp_send(s, peer, (uint8_t[NET_UDP_HEADER_BYTES]){0}, 0, 0); // Tells the host where we are
+        return;
+    }
+    peer->phase = (s->role == 1) ? PHASE_TEXT_IDLE : PHASE_TEXT_DRONE;
+    peer->deadline_ns = (s->role == 1) ? monotonic_ns() : 0;
+}
+
+// The text protocol carries one drone each way; its coords get a local sequence
+static void set_text_remote(NetSession *s, NetPeer *peer, const char *buf)
+{
+    float rx, ry;
+    if (sscanf(buf, "%f %f", &rx, &ry) != 2) return;
+    int id = (s->role == 1) ? peer->slot + 1 : 0;
+    set_remote(s, id, s->remotes[id].seq + 1, monotonic_ns(), rx, ry, 0, 0);
+}
+
+// TEXT PROTOCOL (handshake, then the lock-step drone/dok/obst/pok exchange)
+// One received line at a time; returns -1 to drop the link
+static int on_line(NetSession *s, NetPeer *peer, const char *buf)
+{
+    switch (peer->phase)
+    {
+        // SERVER HANDSHAKE
+        case PHASE_WAIT_OOK: // "ook", "ook bin1" or "ook bin1 udp1": each is an extra word older peers ignore
+            peer->binary = s->want_binary && strstr(buf, NET_PROTO_BINARY) != NULL;
+            peer->udp = peer->binary && s->udp_fd >= 0 && strstr(buf, NET_PROTO_UDP) != NULL;
+            peer->snap = peer->binary && s->want_snap && strstr(buf, NET_PROTO_SNAPSHOT) != NULL;
+            peer->phase = PHASE_WAIT_SOK;
+            const char *snap = peer->snap ? " " NET_PROTO_SNAPSHOT : "";
+            if (peer->udp)
+            {
+                uint64_t r = rng_seed_or_clock(0);
+                peer->token = ((uint32_t)(r ^ (r >> 32)) & ~0xFFu) | (uint32_t)peer->slot;
+                return send_line(s, peer, "size %d, %d " NET_PROTO_BINARY " " NET_PROTO_UDP " %u%s", MAP_WIDTH, MAP_HEIGHT, peer->token, snap);
+            }
+            return send_line(s, peer, "size %d, %d%s%s", MAP_WIDTH, MAP_HEIGHT, peer->binary ? " " NET_PROTO_BINARY : "", snap); // Note the comma
+        case PHASE_WAIT_SOK:
+            start_stream(s, peer);
+            return 0;
+
+        // CLIENT HANDSHAKE
+        case PHASE_WAIT_OK:
+            peer->phase = PHASE_WAIT_SIZE;
+            return send_line(s, peer, "ook%s%s%s", s->want_binary ? " " NET_PROTO_BINARY : "",
+                             s->want_udp ? " " NET_PROTO_UDP : "", s->want_snap ? " " NET_PROTO_SNAPSHOT : "");
+        case PHASE_WAIT_SIZE:
+        { // "size w, h" (+ " bin1", " udp1 <token>" and " snap1" for what the server agreed to)
+            peer->binary = s->want_binary && strstr(buf, NET_PROTO_BINARY) != NULL;
+            peer->snap = peer->binary && s->want_snap && strstr(buf, NET_PROTO_SNAPSHOT) != NULL;
+            const char *udp = strstr(buf, NET_PROTO_UDP);
+            if (peer->binary && s->want_udp && udp != NULL && sscanf(udp + strlen(NET_PROTO_UDP), "%u", &peer->token) == 1)
+            {
+                peer->udp = open_udp(s) == 0;
+            }
+
+            // PARSE SIZE & SEND RESIZE COMMAND TO BLACKBOARD
+            int w=80, h=24;
+            if(sscanf(buf, "size %d, %d", &w, &h) != 2) sscanf(buf, "size %d %d", &w, &h);
+
+            ResizeMsg resize = { .width = w, .height = h };
+            frame_send(&s->bb_writer, MSG_RESIZE, &resize, sizeof(resize));
+
+            if (send_line(s, peer, "sok %d %d", w, h) == -1) return -1;
+            start_stream(s, peer);
+            return 0;
         }
-        return sockfd;
+
+        // SERVER BEHAVIOR
+        case PHASE_TEXT_DOK:
+            peer->phase = PHASE_TEXT_OBST_XY;
+            return send_line(s, peer, "obst");
+        case PHASE_TEXT_OBST_XY:
+            set_text_remote(s, peer, buf); // Send Remote Drone (as obstacle) to Blackboard
+            peer->phase = PHASE_TEXT_IDLE;
+            peer->deadline_ns = monotonic_ns() + SYNC_RATE_US * 1000ULL;
+            return send_line(s, peer, "pok");
+
+        // CLIENT BEHAVIOR
+        case PHASE_TEXT_DRONE:
+            if (buf[0] == 'q')
+            {
+                send_line(s, peer, "qok");
+                s->done = 1;
+                return 0;
+            }
+            peer->phase = PHASE_TEXT_DRONE_XY;
+            return 0;
+        case PHASE_TEXT_DRONE_XY:
+            set_text_remote(s, peer, buf); // Send Remote Drone to Blackboard
+            peer->phase = PHASE_TEXT_OBST;
+            return send_line(s, peer, "dok");
+        case PHASE_TEXT_OBST:
+            peer->phase = PHASE_TEXT_POK;
+            return send_line(s, peer, "%.2f %.2f", s->local.x, to_virtual_y(s->local.y));
+        case PHASE_TEXT_POK:
+            peer->phase = PHASE_TEXT_DRONE;
+            return 0;
+
+        default:
+            return 0;
     }
 }
 
-int main(int argc, char *argv[]) 
+// Server: the peer's next text exchange is due. Client: time to retry connecting
+static int on_deadline(NetSession *s, NetPeer *peer)
+{
+    peer->deadline_ns = 0;
+    if (peer->phase == PHASE_CONNECTING)
+    {
+        start_connect(s, peer);
+        return 0;
+    }
+    if (peer->phase != PHASE_TEXT_IDLE) return 0;
+    peer->phase = PHASE_TEXT_DOK;
+    if (send_line(s, peer, "drone") == -1) return -1;
+    return send_line(s, peer, "%.2f %.2f", s->local.x, to_virtual_y(s->local.y));
+}
+
+// BINARY STREAM
+// Each drone keeps its highest sequence number. A host only takes the peer's
+// own drone (id 0 from the peer). Returns -1 when the peer itself quits
+static int apply_frame(NetSession *s, NetPeer *peer, const NetStateFrame *frame, int count_lost)
+{
+    if (frame->type == NET_ACK)
+    {
+        // Only ticks that were sent, newest first
+        if (s->role == 1 && peer->snap && !net_seq_newer(frame->seq, peer->sent_tick) &&
+            (!peer->has_ack || net_seq_newer(frame->seq, peer->acked)))
+        {
+            peer->acked = frame->seq;
+            peer->has_ack = 1;
+        }
+        return 0;
+    }
+    if (s->role == 1 && frame->drone != 0) return 0;
+    int id = (s->role == 1) ? peer->slot + 1 : frame->drone;
+    RemoteDrone *r = &s->remotes[id];
+
+    if (frame->type == NET_QUIT)
+    {
+        if (id == 0 || s->role == 1) return -1; // The peer itself
+        if (r->active) s->obstacles_dirty = 1;
+        memset(r, 0, sizeof(*r)); // Its id may come back as someone else
+        return 0;
+    }
+    if (r->active && !net_seq_newer(frame->seq, r->seq))
+    {
+        if (!count_lost) s->dropped++; // Over UDP most are the redundant copies
+        return 0;
+    }
+    if (count_lost && r->active) s->lost += frame->seq - r->seq - 1;
+    set_remote(s, id, frame->seq, frame->sent_ns, frame->x, frame->y, frame->vx, frame->vy);
+    return 0;
+}
+
+// Client: a snapshot from the host. It is rebuilt on its baseline and replaces
+// the remote drones; one without its baseline (lost or too old) is skipped, and
+// the host falls back to a full one when the acks stop. -1 if it is malformed
+static int on_snapshot(NetSession *s, const uint8_t *in, int len)
+{
+    uint32_t tick, baseline;
+    if (len < NET_SNAP_HEADER_BYTES || net_snap_header(in, &tick, &baseline) != len) return -1;
+    if (s->snap_tick != 0 && !net_seq_newer(tick, s->snap_tick))
+    {
+        s->dropped++; // Late datagram
+        return 0;
+    }
+    const NetSnapshot *base = NULL;
+    if (baseline != 0)
+    {
+        base = &s->snaps[baseline % NET_SNAP_HISTORY];
+        if (base->tick != baseline || tick - baseline >= NET_SNAP_HISTORY) return 0;
+    }
+    NetSnapshot *view = &s->snaps[tick % NET_SNAP_HISTORY];
+    if (net_snap_decode(in, len, base, view) == -1)
+    {
+        view->tick = 0;
+        return -1;
+    }
+
+    uint64_t now = monotonic_ns();
+    for (int id = 0; id < NET_SNAP_ENTITIES; id++)
+    {
+        RemoteDrone *r = &s->remotes[id];
+        float x, y, vx, vy;
+        if (!net_snap_get(view, id, &x, &y, &vx, &vy))
+        {
+            if (r->active) s->obstacles_dirty = 1;
+            memset(r, 0, sizeof(*r));
+            continue;
+        }
+        if (!r->active || r->x != x || r->y != y || r->vx != vx || r->vy != vy) set_remote(s, id, tick, now, x, y, vx, vy);
+    }
+    s->snap_tick = tick;
+    s->ack_pending = 1;
+    return 0;
+}
+
+// Every complete frame (or snapshot, from a host) in the ring
+static int on_frames(NetSession *s, NetPeer *peer)
+{
+    static uint8_t bytes[NET_SNAP_MAX_BYTES];
+    NetStateFrame frame;
+    while (ring_peek(&peer->link, bytes, NET_SNAP_HEADER_BYTES))
+    {
+        uint32_t tick, baseline;
+        int len = (s->role != 1 && peer->snap) ? net_snap_header(bytes, &tick, &baseline) : -1;
+        if (len > 0)
+        {
+            if (!ring_take(&peer->link, bytes, (uint32_t)len)) break;
+            if (on_snapshot(s, bytes, len) == -1)
+            {
+                log_msg("NET", "Protocol error: bad snapshot from peer");
+                return -1;
+            }
+            continue;
+        }
+        if (!ring_take(&peer->link, bytes, NET_FRAME_BYTES)) break;
+        if (net_frame_decode(bytes, &frame) == -1)
+        {
+            log_msg("NET", "Protocol error: bad frame from peer");
+            return -1;
+        }
+        if (apply_frame(s, peer, &frame, 0) == -1) return -1;
+    }
+    return 0;
+}
+
+// Every waiting datagram. The host learns a peer's UDP address from its first
+// one (and follows it if it changes); anything without a known token is dropped
+static void on_datagrams(NetSession *s)
 {
-    if (argc < 4) 
+    static uint8_t buf[NET_UDP_HEADER_BYTES + NET_UDP_MAX_FRAMES * NET_FRAME_BYTES + NET_SNAP_MAX_BYTES];
+    struct sockaddr_in from;
+    socklen_t from_len = sizeof(from);
+    ssize_t n;
+    while ((n = recvfrom(s->udp_fd, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len)) >= 0)
     {
-        log_msg("NET", "Usage: ./network_process <mode> <port> <ip>");
+        uint32_t token;
+        int count = net_udp_header_decode(buf, (size_t)n, &token);
+        from_len = sizeof(from);
+        if (count < 0) continue;
+        int slot = (s->role == 1) ? (int)(token & 0xFF) : 0;
+        NetPeer *peer = (slot < NET_MAX_PEERS) ? s->peers[slot] : NULL;
+        if (peer == NULL || !peer->udp || peer->token != token || peer->phase != PHASE_BINARY) continue;
+        s->udp_received++;
+        if (s->role == 1)
+        {
+            peer->udp_addr = from;
+            if (!peer->udp_known) peer->snapshot_pending = 1; // Everything, now over UDP
+            peer->udp_known = 1;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            NetStateFrame frame;
+            if (net_frame_decode(buf + NET_UDP_HEADER_BYTES + i * NET_FRAME_BYTES, &frame) == 0 && frame.type != NET_QUIT)
+            {
+                apply_frame(s, peer, &frame, 1);
+            }
+        }
+        int used = NET_UDP_HEADER_BYTES + count * NET_FRAME_BYTES;
+        if (s->role != 1 && peer->snap && n > used) on_snapshot(s, buf + used, (int)n - used);
+    }
+}
+
+// Everything the peer sent: lines until the handshake switches to frames
+static int on_socket_readable(NetSession *s, NetPeer *peer, const char **why)
+{
+    ssize_t n;
+    *why = "disconnected";
+    while ((n = ring_fill(&peer->link)) > 0 || (n == -1 && errno == ENOBUFS))
+    {
+        // A full ring is parsed before reading on
+        char line[BUFFER_CAP];
+        while (peer->phase != PHASE_BINARY && !s->done && ring_line(&peer->link, line, sizeof(line)))
+        {
+            if (on_line(s, peer, line) == -1) return -1;
+        }
+        if (peer->phase == PHASE_BINARY && on_frames(s, peer) == -1)
+        {
+            *why = "left";
+            return -1;
+        }
+        if (s->done) return 0;
+        if (n == -1 && peer->link.buf_end - peer->link.buf_start == BUFFER_CAP)
+        {
+            *why = "protocol error: line too long";
+            return -1;
+        }
+    }
+    if (n == 0) return -1;
+    if (errno != EAGAIN && errno != EINTR)
+    {
+        *why = strerror(errno);
+        return -1;
+    }
+    return 0;
+}
+
+static void on_socket(NetSession *s, NetPeer *peer, uint32_t events)
+{
+    const char *why = "disconnected";
+    if (peer->phase == PHASE_CONNECTING)
+    {
+        on_connected(s, peer);
+        return;
+    }
+    int failed = (events & EPOLLOUT) && flush_tx(s, peer) == -1;
+    if (!failed && peer->snapshot_pending && peer->link.tx_len == 0) failed = send_snapshot(s, peer, 1) == -1;
+    if (!failed && (events & (EPOLLIN | EPOLLHUP | EPOLLERR))) failed = on_socket_readable(s, peer, &why) == -1;
+    if (failed) drop_peer(s, peer, why);
+}
+
+// End of an epoll round: a new local tick and the peers' drones that arrived in it
+// go to every binary peer in one write each. Text peers pick the local drone up
+// at their next exchange
+static void fan_out(NetSession *s, int local_fresh)
+{
+    if (s->role == 1) take_world(s);
+    for (int k = 0; k < NET_MAX_PEERS; k++)
+    {
+        NetPeer *peer = s->peers[k];
+        if (peer == NULL || peer->phase != PHASE_BINARY) continue;
+        if (send_snapshot(s, peer, local_fresh) == -1) drop_peer(s, peer, "disconnected");
+    }
+    for (int id = 0; id <= NET_MAX_PEERS; id++) s->remotes[id].dirty = 0;
+    s->relay_dirty = 0;
+}
+
+// Blackboard gone: every binary peer is told the local drone leaves
+static void say_goodbye(NetSession *s)
+{
+    for (int k = 0; k < NET_MAX_PEERS; k++)
+    {
+        NetPeer *peer = s->peers[k];
+        if (peer == NULL || peer->phase != PHASE_BINARY) continue;
+        queue_frame(peer, NET_QUIT, 0, ++s->tx_seq, monotonic_ns(), 0, 0, 0, 0);
+        flush_tx(s, peer);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 4)
+    {
+        log_msg("NET", "Usage: ./network_process <mode> <port> <ip> [binary|text|snapshot] [tcp|udp]");
         return 1;
     }
 
-    LinkContext ctx = {0};
-    ctx.role = atoi(argv[1]);
+    static NetSession s;
+    s.role = atoi(argv[1]);
+    s.listen_fd = -1;
+    s.target_ip = argv[3];
     int port = atoi(argv[2]);
-    char *ip = argv[3];
+    s.want_binary = !(argc > 4 && strcmp(argv[4], "text") == 0);
+    s.want_snap = argc > 4 && strcmp(argv[4], "snapshot") == 0;
+    s.want_udp = s.want_binary && argc > 5 && strcmp(argv[5], "udp") == 0;
+    s.udp_fd = -1;
 
     // Construct Pipe Paths based on Role
     char fifo_tx[100];
     char fifo_rx[100];
     char suffix[50] = "";
 
-    if (ctx.role == 1) strcpy(suffix, "_server");
-    else if (ctx.role == 2) strcpy(suffix, "_client");
+    if (s.role == 1) strcpy(suffix, "_server");
+    else if (s.role == 2) strcpy(suffix, "_client");
 
     // FIFO_NET_TX is /tmp/fifoBBObs (Blackboard -> Network)
     // FIFO_NET_RX is /tmp/fifoObsBB (Network -> Blackboard)
     snprintf(fifo_tx, sizeof(fifo_tx), "/tmp/fifoBBObs%s", suffix);
     snprintf(fifo_rx, sizeof(fifo_rx), "/tmp/fifoObsBB%s", suffix);
 
-    ctx.pipe_in_fd = open(fifo_tx, O_RDONLY); // Read Local Drone
-    ctx.pipe_out_fd = open(fifo_rx, O_WRONLY); // Write Remote Obstacle
+    // The server opens its write end only after we reported ready, so ours must not wait for it
+    s.pipe_in_fd = open(fifo_tx, O_RDONLY | O_NONBLOCK); // Read Local Drone
+    s.pipe_out_fd = open(fifo_rx, O_WRONLY); // Write Remote Obstacles
 
-    if (ctx.pipe_in_fd < 0 || ctx.pipe_out_fd < 0) 
+    if (s.pipe_in_fd < 0 || s.pipe_out_fd < 0)
     {
         log_msg("NET", "Error: Could not open named pipes. Is Server running?");
         return 1;
     }
+    fcntl(s.pipe_out_fd, F_SETFL, O_NONBLOCK); // A full pipe holds the newest remote drones back, not us
 
-    ctx.conn_fd = establish_link(ctx.role, ip, port);
-    if(ctx.conn_fd < 0) return 1;
-
-    // HANDSHAKE
-    char buf[BUFFER_CAP];
-    if (ctx.role == 1) 
-    { // SERVER HANDSHAKE
-        send_line(ctx.conn_fd, "ok");
-        recv_line(&ctx, buf, 1024); // "ook"
-        send_line(ctx.conn_fd, "size %d, %d", MAP_WIDTH, MAP_HEIGHT); // Note the comma
-        recv_line(&ctx, buf, 1024); // "sok ..."
-    } 
-    else 
-    { // CLIENT HANDSHAKE
-        recv_line(&ctx, buf, 1024); // "ok"
-        send_line(ctx.conn_fd, "ook");
-        recv_line(&ctx, buf, 1024); // "size w, h"
-        
-        // PARSE SIZE & SEND RESIZE COMMAND TO BLACKBOARD
-        int w=80, h=24;
-        if(sscanf(buf, "size %d, %d", &w, &h) != 2) sscanf(buf, "size %d %d", &w, &h);
-        
-        Obstacle resize_pkt[MAX_OBSTACLES] = {0};
-        resize_pkt[0].x = w; 
-        resize_pkt[0].y = h; 
-        resize_pkt[0].active = RESIZE_FLAG; // The Magic Flag
-        write(ctx.pipe_out_fd, resize_pkt, sizeof(resize_pkt));
-        
-        send_line(ctx.conn_fd, "sok %d %d", w, h);
+    // Both pipes carry framed messages (see FrameHeader in common.h)
+    frame_writer_init(&s.bb_writer, s.pipe_out_fd);
+    if (frame_reader_init(&s.bb_reader, s.pipe_in_fd, FRAME_BUFFER_CAP) == -1) return 1;
+
+    // Pipes are up: report ready before the peer handshake, which can take as long as the peer does
+    SharedBoard *board = board_attach(suffix);
+    if (board != NULL)
+    {
+        board_set_ready(board, COMPONENT_NETWORK);
+        board_detach(board);
+    }
+
+    // REACTOR SETUP
+    // The local drone pipe is drained from the start, so the Blackboard never
+    // backs up behind a peer that is slow, silent or not there yet
+    s.epoll_fd = epoll_create1(0);
+    if (s.epoll_fd == -1) { perror("NET: epoll_create1"); return 1; }
+    watch(s.epoll_fd, EPOLL_CTL_ADD, s.pipe_in_fd, TOKEN_PIPE_IN, EPOLLIN);
+
+    if (s.role == 1)
+    {
+        s.listen_fd = open_listener(port);
+        if (s.listen_fd < 0) return 1;
+        watch(s.epoll_fd, EPOLL_CTL_ADD, s.listen_fd, TOKEN_LISTEN, EPOLLIN);
+        s.addr.sin_family = AF_INET;
+        s.addr.sin_port = htons(port);
+        if (s.want_udp && open_udp(&s) == -1) log_msg("NET", "No UDP socket on port %d, peers stay on TCP", port);
+    }
+    else
+    {
+        struct hostent *h = gethostbyname(s.target_ip);
+        if(!h) return 1;
+        s.addr.sin_family = AF_INET;
+        s.addr.sin_port = htons(port);
+        memcpy(&s.addr.sin_addr, h->h_addr_list[0], h->h_length);
+        NetPeer *host = add_peer(&s, -1);
+        if (host == NULL) return 1;
+        host->phase = PHASE_CONNECTING;
+        start_connect(&s, host);
     }
 
     // MAIN LOOP
-    DroneState local = {0};
-    Obstacle remote[MAX_OBSTACLES];
-    fcntl(ctx.pipe_in_fd, F_SETFL, O_NONBLOCK); // Non-blocking read from local game
-
-    while(1) 
-    {
-        // Drain local pipe to get freshest drone position
-        while(read(ctx.pipe_in_fd, &local, sizeof(DroneState)) > 0);
-
-        if (ctx.role == 1) 
-        { // SERVER BEHAVIOR
-            send_line(ctx.conn_fd, "drone");
-            send_line(ctx.conn_fd, "%.2f %.2f", local.x, to_virtual_y(local.y));
-            recv_line(&ctx, buf, 1024); // "dok"
-
-            send_line(ctx.conn_fd, "obst");
-            recv_line(&ctx, buf, 1024); // "x y"
-            
-            float rx, ry; 
-            sscanf(buf, "%f %f", &rx, &ry);
-            
-            // Send Remote Drone (as obstacle) to Blackboard
-            memset(remote, 0, sizeof(remote));
-            remote[0].x = (int)rx; 
-            remote[0].y = (int)to_local_y(ry); 
-            remote[0].active = 1;
-            write(ctx.pipe_out_fd, remote, sizeof(remote));
-            
-            send_line(ctx.conn_fd, "pok");
-
-        } 
-        else 
-        { // CLIENT BEHAVIOR
-            recv_line(&ctx, buf, 1024); // "drone"
-            if(buf[0] == 'q') { send_line(ctx.conn_fd, "qok"); break; }
-            
-            recv_line(&ctx, buf, 1024); // Coords
-            float rx, ry; 
-            sscanf(buf, "%f %f", &rx, &ry);
-            
-            // Send Remote Drone to Blackboard
-            memset(remote, 0, sizeof(remote));
-            remote[0].x = (int)rx; 
-            remote[0].y = (int)to_local_y(ry); 
-            remote[0].active = 1;
-            write(ctx.pipe_out_fd, remote, sizeof(remote));
-            
-            send_line(ctx.conn_fd, "dok");
-
-            recv_line(&ctx, buf, 1024); // "obst"
-            send_line(ctx.conn_fd, "%.2f %.2f", local.x, to_virtual_y(local.y));
-            recv_line(&ctx, buf, 1024); // "pok"
-        }
-        usleep(SYNC_RATE_US);
+    while (!s.done)
+    {
+        uint64_t deadline = 0;
+        for (int k = 0; k < NET_MAX_PEERS; k++)
+        {
+            NetPeer *peer = s.peers[k];
+            if (peer != NULL && peer->deadline_ns != 0 && (deadline == 0 || peer->deadline_ns < deadline)) deadline = peer->deadline_ns;
+        }
+        int timeout_ms = -1;
+        if (deadline != 0)
+        {
+            uint64_t now = monotonic_ns();
+            timeout_ms = (deadline > now) ? (int)((deadline - now + 999999) / 1000000) : 0;
+        }
+        struct epoll_event events[NET_MAX_PEERS + 3]; // One round can see every link
+        int n_events = epoll_wait(s.epoll_fd, events, NET_MAX_PEERS + 3, timeout_ms);
+        if (n_events == -1)
+        {
+            if (errno == EINTR) continue;
+            perror("NET: epoll_wait");
+            break;
+        }
+
+        int local_fresh = 0;
+        for (int e = 0; e < n_events && !s.done; e++)
+        {
+            uint32_t token = events[e].data.u32;
+            if (token == TOKEN_PIPE_IN)
+            {
+                int fresh = drain_local(&s);
+                if (fresh == -1)
+                {
+                    say_goodbye(&s);
+                    log_msg("NET", "Blackboard closed the pipe");
+                    s.done = 1;
+                }
+                else if (fresh)
+                {
+                    memmove(&s.history[1], &s.history[0], (NET_UDP_REDUNDANCY - 1) * sizeof(NetStateFrame));
+                    s.history[0] = (NetStateFrame){ NET_STATE, 0, ++s.tx_seq, s.local_ns, (float)s.local.x,
+                                                    to_virtual_y((float)s.local.y), (float)s.local.vx, (float)-s.local.vy };
+                    if (s.n_history < NET_UDP_REDUNDANCY) s.n_history++;
+                    local_fresh = 1;
+                }
+            }
+            else if (token == TOKEN_PIPE_OUT) flush_obstacles(&s);
+            else if (token == TOKEN_LISTEN) on_accept(&s);
+            else if (token == TOKEN_UDP) on_datagrams(&s);
+            else if (token < NET_MAX_PEERS && s.peers[token] != NULL) on_socket(&s, s.peers[token], events[e].events);
+        }
+
+        uint64_t now = monotonic_ns();
+        for (int k = 0; k < NET_MAX_PEERS && !s.done; k++)
+        {
+            NetPeer *peer = s.peers[k];
+            if (peer != NULL && peer->deadline_ns != 0 && now >= peer->deadline_ns && on_deadline(&s, peer) == -1)
+            {
+                drop_peer(&s, peer, "disconnected");
+            }
+        }
+
+        // Whatever arrived in this round goes to the peers and to the Blackboard in one go
+        if (!s.done && (local_fresh || s.relay_dirty)) fan_out(&s, local_fresh);
+        if (s.obstacles_dirty && !s.obstacles_pending) flush_obstacles(&s);
     }
+
+    log_msg("NET", "Session closed: %u local states sent, %ld stale frames dropped", s.tx_seq, s.dropped);
+    if (s.snap_sent > 0)
+    {
+        log_msg("NET", "Snapshots: %ld sent (%ld full), %.1f bytes each", s.snap_sent, s.snap_full, (double)s.snap_bytes / s.snap_sent);
+    }
+    if (s.udp_fd >= 0)
+    {
+        log_msg("NET", "UDP: %ld datagrams sent, %ld received, %ld states lost after redundancy", s.udp_sent, s.udp_received, s.lost);
+        close(s.udp_fd);
+    }
+    for (int k = 0; k < NET_MAX_PEERS; k++)
+    {
+        if (s.peers[k] == NULL) continue;
+        if (s.peers[k]->link.conn_fd >= 0) close(s.peers[k]->link.conn_fd);
+        free(s.peers[k]);
+    }
+    if (s.listen_fd >= 0) close(s.listen_fd);
+    close(s.epoll_fd);
+    frame_reader_free(&s.bb_reader);
     return 0;
-}
\ No newline at end of file
+}
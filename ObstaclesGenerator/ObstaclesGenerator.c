@@ -8,58 +8,82 @@
 #include "ObstaclesGenerator.h"
 
 // Flags
-volatile sig_atomic_t keep_running = 1;
+static volatile sig_atomic_t keep_running = 1;
 
-void handle_signal(int sig) 
+static void handle_signal(int sig) 
 {
     keep_running = 0;
 }
 
 int main(int argc, char *argv[]) 
 {
-    signal(SIGINT, handle_signal);
-    signal(SIGTERM, handle_signal);
-    signal(SIGPIPE, SIG_IGN); // Prevent crash if Server dies
+    // As a thread of the threaded build the server owns the signals; we stop when the board closes
+    if (!subsystem_is_thread())
+    {
+        signal(SIGINT, handle_signal);
+        signal(SIGTERM, handle_signal);
+        signal(SIGPIPE, SIG_IGN); // Prevent crash if Server dies
+    }
+
+    char suffix[50] = "";
+    if (argc > 1) snprintf(suffix, sizeof(suffix), "%s", argv[1]);
 
-    srand(time(NULL) + getpid()); // Unique seed
+    // SHARED BOARD
+    // Drone State is read from the blackboard segment
+    SharedBoard *board = board_attach(suffix);
+    if (board == NULL) { perror("ObsProcess: attach board"); return 1; }
 
     // PIPES
-    // Read Drone State from Server 
-    const char *fifoBBObs = "/tmp/fifoBBObs"; 
     // Write Obstacle Array to Server 
     const char *fifoObsBB = "/tmp/fifoObsBB";
-    
-    // Open the reading Pipe 
-    int fd_BBObs = open(fifoBBObs, O_RDONLY);
-    if (fd_BBObs == -1) { perror("ObsProcess: open Req"); return 1; }
 
     // Open the writing Pipe 
-    int fd_ObsBB = open(fifoObsBB, O_WRONLY);
+    int fd_ObsBB = link_open(fifoObsBB, O_WRONLY);
     if (fd_ObsBB == -1) { perror("ObsProcess: open Data"); return 1; }
+    FrameWriter obs_writer;
+    frame_writer_init(&obs_writer, fd_ObsBB);
 
     // Local Data
     DroneState drone = {0};
-    Obstacle obstacles[MAX_OBSTACLES];
-    // Init obstacles
-    for(int i=0; i<MAX_OBSTACLES; i++) obstacles[i].active = 0;
+    uint32_t last_seq = 0;
+    // Slots are sized once from the board capacity: nothing is allocated per tick
+    int capacity = board->max_obstacles;
+    Obstacle *obstacles = calloc(capacity + 1, sizeof(Obstacle)); // Init obstacles (all inactive)
+    if (obstacles == NULL) { perror("ObsProcess: alloc"); return 1; }
+    // Own random stream: seeded from SEED in param.conf (via the board), or unique per run
+    Rng rng;
+    rng_seed(&rng, rng_seed_or_clock(board->seed), RNG_STREAM_OBSTACLES);
+    board_set_ready(board, COMPONENT_OBSTACLES);
+    heartbeat_start(board, COMPONENT_OBSTACLES, board->tick_ns); // Paced by the server's publishes
 
     while(keep_running) 
     {
-        // Wait for Drone State from Server 
-        ssize_t bytes = read(fd_BBObs, &drone, sizeof(DroneState));
-        if (bytes <= 0) break; // Server closed
+        heartbeat_beat(board, COMPONENT_OBSTACLES);
+
+        // Wait for the next frame from the Server 
+        if (!board_wait_update(board, last_seq, BOARD_WAIT_MS)) continue;
+        if (atomic_load(&board->closed)) break; // Server closed
+
+        do
+        {
+            last_seq = board_read_begin(board);
+            drone = board->world.drone;
+        } while (board_read_retry(board, last_seq));
 
         // Run Lifecycle Logic (Spawn/Despawn/Timers)
         // This function is defined in Obstacles_functions.c
-        update_obstacle_lifecycle(obstacles, &drone);
+        int in_use = update_obstacle_lifecycle(obstacles, capacity, &drone, &rng);
 
-        // Send Updated Array back to Server
-        write(fd_ObsBB, obstacles, sizeof(obstacles));
+        // Send the slots back to Server, up to the last active one (variable-length frame).
+        // Slot numbers stay stable, so the server only re-files spawned/expired obstacles.
+        if (frame_send(&obs_writer, MSG_OBSTACLES, obstacles, in_use * sizeof(Obstacle)) == -1) break; // Server gone (EPIPE)
     }
     
     // Cleanup
-    close(fd_BBObs);
-    close(fd_ObsBB);
+    free(obstacles);
+    link_close(fd_ObsBB);
+    heartbeat_stop(board, COMPONENT_OBSTACLES);
+    board_detach(board);
     return 0;
     
 }
\ No newline at end of file
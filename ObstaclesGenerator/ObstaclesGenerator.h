@@ -20,18 +20,61 @@
 
 // Physics Constants
 #define REPULSIVE_GAIN 15   // Strength of the push
-#define INFLUENCE_RANGE 3.0   // Distance at which the force starts working
+#define INFLUENCE_RANGE 3.0   // Distance at which the force starts working (<= GRID_CELL_SIZE)
 #define MAX_FORCE 15        // Safety cap to prevent physics glitches
 #define BORDER_MARGIN_SPAWN 5 // Border margin for spawning (don't spawn too close to edges)
 #define BORDER_MARGIN 4.0      // Start pushing 2 units away from wall
 #define BORDER_GAIN 5       // How strong the wall pushes
 
+// The grid query only looks one cell around the drone
+_Static_assert((int)(INFLUENCE_RANGE * 1000) <= GRID_CELL_SIZE * 1000, "GRID_CELL_SIZE must cover INFLUENCE_RANGE");
+
 // Functions
 // GENERATOR (Lifecycle Logic) 
-void update_obstacle_lifecycle(Obstacle obstacles[], DroneState *drone);
+// Returns the number of leading slots in use (last active slot + 1); spawns draw from 'rng'
+int update_obstacle_lifecycle(Obstacle obstacles[], int capacity, DroneState *drone, Rng *rng);
 
 // PHYSICS (Repulsive Logic) 
-void apply_repulsive_forces(DroneState *drone, Obstacle obstacles[]); 
+// Scans every slot
+void apply_repulsive_forces(DroneState *drone, const Obstacle obstacles[], int count); 
+// Only visits the 3x3 grid cells around the drone; same forces up to summation order
+void apply_repulsive_forces_grid(DroneState *drone, const Obstacle obstacles[], int count,
+                                 const int head[], const GridLink links[]);
 void apply_border_forces(DroneState *drone);
 
+// The gains and range as runtime values, for parameter sweeps (sim_sweep);
+// REPULSION_DEFAULTS are the compiled-in ones
+typedef struct {
+    double repulsive_gain;
+    double influence_range;
+    double border_gain;
+} RepulsionModel;
+#define REPULSION_DEFAULTS { REPULSIVE_GAIN, INFLUENCE_RANGE, BORDER_GAIN }
+
+// Same as apply_repulsive_forces() / apply_border_forces() with the values of 'model'
+void apply_repulsive_forces_model(DroneState *drone, const Obstacle obstacles[], int count, const RepulsionModel *model);
+void apply_border_forces_model(DroneState *drone, const RepulsionModel *model);
+
+// VECTOR KERNELS (Repulsion_functions.c)
+// Same forces computed over the ObstacleColumns, variant chosen at runtime from the CPU
+typedef enum {
+    KERNEL_AUTO = -1,
+    KERNEL_SCALAR,
+    KERNEL_SSE,
+    KERNEL_AVX2
+} KernelLevel;
+
+// Max deviation of one obstacle's push from apply_repulsive_forces(), relative to MAX_FORCE
+#define REPULSION_TOLERANCE 1e-4
+
+// Up to this many slots a vector scan of the columns beats walking the grid
+// (bench_repulsion: AVX2 is ahead up to tens of thousands on the 80x24 map)
+#define REPULSION_SCAN_MAX 16384
+
+// Force a variant (KERNEL_AUTO = best supported); returns the one actually used
+int repulsion_kernel_select(int level);
+const char *repulsion_kernel_name(int level);
+void apply_repulsive_forces_columns(DroneState *drone, const ObstacleColumns *cols, int count);
+void apply_border_forces_kernel(DroneState *drone);
+
 #endif
\ No newline at end of file
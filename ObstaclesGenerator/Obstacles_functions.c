@@ -4,9 +4,10 @@
 #include "ObstaclesGenerator.h"
 
 // GENERATOR (Lifecycle Logic) 
-void update_obstacle_lifecycle(Obstacle obstacles[], DroneState *drone) 
+int update_obstacle_lifecycle(Obstacle obstacles[], int capacity, DroneState *drone, Rng *rng) 
 {   
-    for (int i = 0; i < MAX_OBSTACLES; i++) 
+    int in_use = 0;
+    for (int i = 0; i < capacity; i++) 
     {  
         // Manage Active Obstacles
         if (obstacles[i].active) 
@@ -20,11 +21,11 @@ void update_obstacle_lifecycle(Obstacle obstacles[], DroneState *drone)
         else 
         {
             // Random roll (0-99) < Chance
-            if ((rand() % 100) < SPAWN_CHANCE) 
+            if (rng_below(rng, 100) < SPAWN_CHANCE) 
             {  
                 // Generate random coords inside the map borders
-                int cand_x = (rand() % (MAP_WIDTH - 2 * BORDER_MARGIN_SPAWN)) + BORDER_MARGIN_SPAWN;
-                int cand_y = (rand() % (MAP_HEIGHT - 2 * BORDER_MARGIN_SPAWN)) + BORDER_MARGIN_SPAWN;
+                int cand_x = rng_below(rng, MAP_WIDTH - 2 * BORDER_MARGIN_SPAWN) + BORDER_MARGIN_SPAWN;
+                int cand_y = rng_below(rng, MAP_HEIGHT - 2 * BORDER_MARGIN_SPAWN) + BORDER_MARGIN_SPAWN;
 
                 // SAFETY CHECK: Calculate distance to drone
                 double dx = cand_x - drone->x;
@@ -40,52 +41,86 @@ void update_obstacle_lifecycle(Obstacle obstacles[], DroneState *drone)
                 }
             }
         }
+        if (obstacles[i].active) in_use = i + 1;
     }
+    return in_use;
 }
 
 // PHYSICS (Repulsive Logic) 
-void apply_repulsive_forces(DroneState *drone, Obstacle obstacles[]) 
+// Push the drone away from one obstacle if it is within range
+// (the compiled-in gain and range everywhere but in the parameter sweep)
+static inline void repulse_from(DroneState *drone, const Obstacle *obstacle, double gain, double range) 
+{
+    // Vector from Obstacle TO Drone (Pushing away)
+    double dx = drone->x - obstacle->x;
+    double dy = drone->y - obstacle->y;
+    double distance = sqrt(dx*dx + dy*dy);
+
+    // Check Range
+    if (distance < range && distance > 0.1) {
+        
+        /* Calculate Force Magnitude (Inverse Square Law)
+         Formula: Gain * (1/dist - 1/range) * (1/dist^2)
+         Simpler Game Version: Gain / dist^2 */
+        
+        double magnitude = gain / (distance * distance);
+
+        // Cap the force to prevent "Teleporting" glitches
+        if (magnitude > MAX_FORCE) magnitude = MAX_FORCE;
+
+        // Calculate Unit Vector (Direction)
+        double unit_x = dx / distance;
+        double unit_y = dy / distance;
+
+        // Apply to Drone
+        drone->force_x += magnitude * unit_x;
+        drone->force_y += magnitude * unit_y;
+    }
+}
+
+void apply_repulsive_forces(DroneState *drone, const Obstacle obstacles[], int count) 
 {  
-    for (int i = 0; i < MAX_OBSTACLES; i++) {
+    for (int i = 0; i < count; i++) {
         // Ignore inactive obstacles
         if (!obstacles[i].active) continue;
+        repulse_from(drone, &obstacles[i], REPULSIVE_GAIN, INFLUENCE_RANGE);
+    }
+}
+
+void apply_repulsive_forces_grid(DroneState *drone, const Obstacle obstacles[], int count,
+                                 const int head[], const GridLink links[]) 
+{
+    int center = grid_cell(drone->x, drone->y);
+    int col = center % GRID_COLS;
+    int row = center / GRID_COLS;
+
+    for (int r = row - 1; r <= row + 1; r++) 
+    {
+        if (r < 0 || r >= GRID_ROWS) continue;
+        for (int c = col - 1; c <= col + 1; c++) 
+        {
+            if (c < 0 || c >= GRID_COLS) continue;
 
-        // Vector from Obstacle TO Drone (Pushing away)
-        double dx = drone->x - obstacles[i].x;
-        double dy = drone->y - obstacles[i].y;
-        double distance = sqrt(dx*dx + dy*dy);
-
-        // Check Range
-        if (distance < INFLUENCE_RANGE && distance > 0.1) {
-            
-            /* Calculate Force Magnitude (Inverse Square Law)
-             Formula: Gain * (1/dist - 1/range) * (1/dist^2)
-             Simpler Game Version: Gain / dist^2 */
-            
-            double magnitude = REPULSIVE_GAIN / (distance * distance);
-
-            // Cap the force to prevent "Teleporting" glitches
-            if (magnitude > MAX_FORCE) magnitude = MAX_FORCE;
-
-            // Calculate Unit Vector (Direction)
-            double unit_x = dx / distance;
-            double unit_y = dy / distance;
-
-            // Apply to Drone
-            drone->force_x += magnitude * unit_x;
-            drone->force_y += magnitude * unit_y;
+            // 'steps' bounds the walk: a torn seqlock read may show a broken chain,
+            // the caller retries but we must not loop or leave the arrays meanwhile
+            int steps = 0;
+            for (int i = head[r * GRID_COLS + c]; i >= 0 && i < count && steps < count; i = links[i].next, steps++) 
+            {
+                if (!obstacles[i].active) continue;
+                repulse_from(drone, &obstacles[i], REPULSIVE_GAIN, INFLUENCE_RANGE);
+            }
         }
     }
 }
 
-void apply_border_forces(DroneState *drone) 
+static inline void push_from_borders(DroneState *drone, double gain)
 {   
     // LEFT WALL (x = 0)
     if (drone->x < BORDER_MARGIN) 
     {
         double dist = drone->x;
         if (dist < 0.1) dist = 0.1; 
-        double force = BORDER_GAIN / (dist * dist);
+        double force = gain / (dist * dist);
         if (force > MAX_FORCE) force = MAX_FORCE;
         drone->force_x += force; // Push RIGHT 
     }
@@ -95,7 +130,7 @@ void apply_border_forces(DroneState *drone)
     {
         double dist = MAP_WIDTH - drone->x;
         if (dist < 0.1) dist = 0.1;
-        double force = BORDER_GAIN / (dist * dist);
+        double force = gain / (dist * dist);
         if (force > MAX_FORCE) force = MAX_FORCE;
         drone->force_x -= force; // Push LEFT
     }
@@ -105,7 +140,7 @@ void apply_border_forces(DroneState *drone)
     {
         double dist = drone->y;
         if (dist < 0.1) dist = 0.1;
-        double force = BORDER_GAIN / (dist * dist);
+        double force = gain / (dist * dist);
         if (force > MAX_FORCE) force = MAX_FORCE;
         drone->force_y += force; // Push DOWN 
     }
@@ -115,8 +150,29 @@ void apply_border_forces(DroneState *drone)
     {
         double dist = MAP_HEIGHT - drone->y;
         if (dist < 0.1) dist = 0.1;
-        double force = BORDER_GAIN / (dist * dist);
+        double force = gain / (dist * dist);
         if (force > MAX_FORCE) force = MAX_FORCE;
         drone->force_y -= force; // Push UP 
     }
-}
\ No newline at end of file
+}
+
+void apply_border_forces(DroneState *drone) 
+{
+    push_from_borders(drone, BORDER_GAIN);
+}
+
+// PARAMETER SWEEPS
+// Linear scan: the grid only covers ranges up to GRID_CELL_SIZE
+void apply_repulsive_forces_model(DroneState *drone, const Obstacle obstacles[], int count, const RepulsionModel *model)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (!obstacles[i].active) continue;
+        repulse_from(drone, &obstacles[i], model->repulsive_gain, model->influence_range);
+    }
+}
+
+void apply_border_forces_model(DroneState *drone, const RepulsionModel *model)
+{
+    push_from_borders(drone, model->border_gain);
+}
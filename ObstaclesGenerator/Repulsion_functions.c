@@ -0,0 +1,229 @@
+#include <stdlib.h>
+#include <math.h>
+#include "../common.h"
+#include "ObstaclesGenerator.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define REPULSION_X86 1
+#endif
+
+/* Repulsion_functions.c - Vector kernels for the obstacle and border forces
+   The obstacle kernel runs over the ObstacleColumns (SoA, float) instead of the
+   Obstacle slots, with no branches: lanes out of range or inactive are masked.
+   The variant is picked once at runtime from the CPU (AVX2+FMA, SSE2, scalar).
+
+   TOLERANCE vs apply_repulsive_forces() (double, one obstacle at a time):
+     - each obstacle's push agrees within REPULSION_TOLERANCE relative to MAX_FORCE
+       (float math, FMA and a different summation order);
+     - an obstacle closer than ~1e-5 to the 0.1 / INFLUENCE_RANGE cut-offs may be
+       counted by one and not the other (the force is discontinuous there).
+   The border kernel does the same double operations as apply_border_forces(),
+   so it matches exactly (barring a drone within an ulp of BORDER_MARGIN).
+*/
+
+#define RANGE_SQ ((float)(INFLUENCE_RANGE * INFLUENCE_RANGE))
+#define MIN_DIST_SQ 0.01f // 0.1 squared: closer than this the direction is meaningless
+
+static const char *kernel_names[] = { "scalar", "sse", "avx2" };
+
+// SCALAR (reference for the vector lanes, and the fallback)
+
+static void obstacles_scalar(const ObstacleColumns *cols, int len, float px, float py, double *fx, double *fy)
+{
+    float sum_x = 0.0f, sum_y = 0.0f;
+    for (int i = 0; i < len; i++)
+    {
+        if (!cols->mask[i]) continue;
+        float dx = px - cols->x[i];
+        float dy = py - cols->y[i];
+        float d2 = dx * dx + dy * dy;
+        if (d2 >= RANGE_SQ || d2 <= MIN_DIST_SQ) continue;
+
+        float inv = 1.0f / sqrtf(d2);
+        float magnitude = fminf((float)REPULSIVE_GAIN * inv * inv, (float)MAX_FORCE);
+        sum_x += magnitude * inv * dx;
+        sum_y += magnitude * inv * dy;
+    }
+    *fx += sum_x;
+    *fy += sum_y;
+}
+
+#ifdef REPULSION_X86
+
+// SSE2 (4 lanes, baseline on x86-64)
+
+__attribute__((target("sse2")))
+static void obstacles_sse(const ObstacleColumns *cols, int len, float px, float py, double *fx, double *fy)
+{
+    const __m128 vpx = _mm_set1_ps(px);
+    const __m128 vpy = _mm_set1_ps(py);
+    const __m128 range_sq = _mm_set1_ps(RANGE_SQ);
+    const __m128 min_sq = _mm_set1_ps(MIN_DIST_SQ);
+    const __m128 gain = _mm_set1_ps((float)REPULSIVE_GAIN);
+    const __m128 cap = _mm_set1_ps((float)MAX_FORCE);
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 acc_x = _mm_setzero_ps();
+    __m128 acc_y = _mm_setzero_ps();
+
+    for (int i = 0; i < len; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(vpx, _mm_loadu_ps(cols->x + i));
+        __m128 dy = _mm_sub_ps(vpy, _mm_loadu_ps(cols->y + i));
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+        __m128 live = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(cols->mask + i)));
+        live = _mm_and_ps(live, _mm_and_ps(_mm_cmplt_ps(d2, range_sq), _mm_cmpgt_ps(d2, min_sq)));
+
+        // Dead lanes may hold inf (d2 == 0); the mask zeroes them before they reach the sums
+        __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(d2));
+        __m128 magnitude = _mm_min_ps(_mm_mul_ps(gain, _mm_mul_ps(inv, inv)), cap);
+        __m128 k = _mm_and_ps(_mm_mul_ps(magnitude, inv), live);
+        acc_x = _mm_add_ps(acc_x, _mm_mul_ps(k, dx));
+        acc_y = _mm_add_ps(acc_y, _mm_mul_ps(k, dy));
+    }
+
+    float lanes_x[4], lanes_y[4];
+    _mm_storeu_ps(lanes_x, acc_x);
+    _mm_storeu_ps(lanes_y, acc_y);
+    *fx += (lanes_x[0] + lanes_x[1]) + (lanes_x[2] + lanes_x[3]);
+    *fy += (lanes_y[0] + lanes_y[1]) + (lanes_y[2] + lanes_y[3]);
+}
+
+// Lanes: left, right, top, bottom wall distances
+__attribute__((target("sse2")))
+static void border_sse(DroneState *drone)
+{
+    const __m128d margin = _mm_set1_pd(BORDER_MARGIN);
+    const __m128d floor_d = _mm_set1_pd(0.1);
+    const __m128d gain = _mm_set1_pd(BORDER_GAIN);
+    const __m128d cap = _mm_set1_pd(MAX_FORCE);
+
+    __m128d dist[2] = {
+        _mm_set_pd(MAP_WIDTH - drone->x, drone->x),   // lane 0 = left, lane 1 = right
+        _mm_set_pd(MAP_HEIGHT - drone->y, drone->y)   // lane 0 = top,  lane 1 = bottom
+    };
+    double force[2][2];
+    for (int axis = 0; axis < 2; axis++)
+    {
+        __m128d live = _mm_cmplt_pd(dist[axis], margin);
+        __m128d d = _mm_max_pd(dist[axis], floor_d);
+        __m128d f = _mm_min_pd(_mm_div_pd(gain, _mm_mul_pd(d, d)), cap);
+        _mm_storeu_pd(force[axis], _mm_and_pd(f, live));
+    }
+    drone->force_x += force[0][0] - force[0][1];
+    drone->force_y += force[1][0] - force[1][1];
+}
+
+// AVX2 + FMA (8 lanes)
+
+__attribute__((target("avx2,fma")))
+static void obstacles_avx2(const ObstacleColumns *cols, int len, float px, float py, double *fx, double *fy)
+{
+    const __m256 vpx = _mm256_set1_ps(px);
+    const __m256 vpy = _mm256_set1_ps(py);
+    const __m256 range_sq = _mm256_set1_ps(RANGE_SQ);
+    const __m256 min_sq = _mm256_set1_ps(MIN_DIST_SQ);
+    const __m256 gain = _mm256_set1_ps((float)REPULSIVE_GAIN);
+    const __m256 cap = _mm256_set1_ps((float)MAX_FORCE);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 acc_x = _mm256_setzero_ps();
+    __m256 acc_y = _mm256_setzero_ps();
+
+    for (int i = 0; i < len; i += 8)
+    {
+        __m256 dx = _mm256_sub_ps(vpx, _mm256_loadu_ps(cols->x + i));
+        __m256 dy = _mm256_sub_ps(vpy, _mm256_loadu_ps(cols->y + i));
+        __m256 d2 = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+
+        __m256 live = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i *)(cols->mask + i)));
+        live = _mm256_and_ps(live, _mm256_and_ps(_mm256_cmp_ps(d2, range_sq, _CMP_LT_OQ),
+                                                 _mm256_cmp_ps(d2, min_sq, _CMP_GT_OQ)));
+
+        __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(d2));
+        __m256 magnitude = _mm256_min_ps(_mm256_mul_ps(gain, _mm256_mul_ps(inv, inv)), cap);
+        __m256 k = _mm256_and_ps(_mm256_mul_ps(magnitude, inv), live);
+        acc_x = _mm256_fmadd_ps(k, dx, acc_x);
+        acc_y = _mm256_fmadd_ps(k, dy, acc_y);
+    }
+
+    __m128 sum_x = _mm_add_ps(_mm256_castps256_ps128(acc_x), _mm256_extractf128_ps(acc_x, 1));
+    __m128 sum_y = _mm_add_ps(_mm256_castps256_ps128(acc_y), _mm256_extractf128_ps(acc_y, 1));
+    float lanes_x[4], lanes_y[4];
+    _mm_storeu_ps(lanes_x, sum_x);
+    _mm_storeu_ps(lanes_y, sum_y);
+    *fx += (lanes_x[0] + lanes_x[1]) + (lanes_x[2] + lanes_x[3]);
+    *fy += (lanes_y[0] + lanes_y[1]) + (lanes_y[2] + lanes_y[3]);
+}
+
+// Lanes: left, right, top, bottom wall distances
+__attribute__((target("avx2")))
+static void border_avx2(DroneState *drone)
+{
+    __m256d dist = _mm256_set_pd(MAP_HEIGHT - drone->y, drone->y, MAP_WIDTH - drone->x, drone->x);
+    __m256d live = _mm256_cmp_pd(dist, _mm256_set1_pd(BORDER_MARGIN), _CMP_LT_OQ);
+    __m256d d = _mm256_max_pd(dist, _mm256_set1_pd(0.1));
+    __m256d f = _mm256_min_pd(_mm256_div_pd(_mm256_set1_pd(BORDER_GAIN), _mm256_mul_pd(d, d)),
+                              _mm256_set1_pd(MAX_FORCE));
+    double force[4];
+    _mm256_storeu_pd(force, _mm256_and_pd(f, live));
+    drone->force_x += force[0] - force[1];
+    drone->force_y += force[2] - force[3];
+}
+
+#endif
+
+// DISPATCH
+
+typedef void (*ObstacleKernel)(const ObstacleColumns *cols, int len, float px, float py, double *fx, double *fy);
+typedef void (*BorderKernel)(DroneState *drone);
+
+static int kernel_level = -1;
+static ObstacleKernel obstacle_kernel = obstacles_scalar;
+static BorderKernel border_kernel = apply_border_forces;
+
+// Best variant this CPU can run
+static int kernel_supported(void)
+{
+#ifdef REPULSION_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return KERNEL_AVX2;
+    if (__builtin_cpu_supports("sse2")) return KERNEL_SSE;
+#endif
+    return KERNEL_SCALAR;
+}
+
+int repulsion_kernel_select(int level)
+{
+    int best = kernel_supported();
+    if (level < 0 || level > best) level = best;
+
+    kernel_level = level;
+    obstacle_kernel = obstacles_scalar;
+    border_kernel = apply_border_forces;
+#ifdef REPULSION_X86
+    if (level == KERNEL_SSE) { obstacle_kernel = obstacles_sse; border_kernel = border_sse; }
+    if (level == KERNEL_AVX2) { obstacle_kernel = obstacles_avx2; border_kernel = border_avx2; }
+#endif
+    return level;
+}
+
+const char *repulsion_kernel_name(int level)
+{
+    if (level < 0 || level > KERNEL_AVX2) return "auto";
+    return kernel_names[level];
+}
+
+void apply_repulsive_forces_columns(DroneState *drone, const ObstacleColumns *cols, int count)
+{
+    if (kernel_level < 0) repulsion_kernel_select(KERNEL_AUTO);
+    if (count <= 0) return;
+    obstacle_kernel(cols, OBSTACLE_COLUMN_LEN(count), (float)drone->x, (float)drone->y,
+                    &drone->force_x, &drone->force_y);
+}
+
+void apply_border_forces_kernel(DroneState *drone)
+{
+    if (kernel_level < 0) repulsion_kernel_select(KERNEL_AUTO);
+    border_kernel(drone);
+}
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Simulation.h"
+#include "../common.h"
+#include "../DroneDynamics/DroneController.h"
+#include "../ObstaclesGenerator/ObstaclesGenerator.h"
+#include "../TargetGenerator/TargetGenerator.h"
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+int sim_init(Simulation *sim, const SimConfig *config)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->config = *config;
+    int n = config->n_drones;
+    if (world_alloc(&sim->world, config->max_obstacles, config->max_targets, n - 1) == -1) return -1;
+
+    sim->drones = calloc(n, sizeof(DroneState));
+    sim->inputs = calloc(n, sizeof(InputMsg));
+    sim->obstacles = calloc(config->max_obstacles + 1, sizeof(Obstacle));
+    sim->targets = calloc(config->max_targets + 1, sizeof(Target));
+    sim->pool = swarm_pool_create(config->threads > 0 ? config->threads : 1);
+    if (sim->drones == NULL || sim->inputs == NULL || sim->obstacles == NULL || sim->targets == NULL || sim->pool == NULL)
+    {
+        sim_free(sim);
+        return -1;
+    }
+
+    // The scalar kernels: SSE/AVX2 round differently, and the result must not depend on the CPU
+    repulsion_kernel_select(KERNEL_SCALAR);
+    for (int i = 0; i < n; i++) drone_spawn(&sim->drones[i], i, n);
+    sim->world.drone = sim->drones[0];
+    sim->world.n_agents = n - 1;
+    memcpy(sim->world.agents, sim->drones + 1, (size_t)(n - 1) * sizeof(DroneState));
+
+    rng_seed(&sim->rng_obstacles, config->seed, RNG_STREAM_OBSTACLES);
+    rng_seed(&sim->rng_targets, config->seed, RNG_STREAM_TARGETS);
+    sim->targets_to_spawn = (config->max_targets > TOTAL_TARGETS_TO_WIN) ? config->max_targets : TOTAL_TARGETS_TO_WIN;
+    sim->batch = (SwarmBatch){ sim->drones, sim->inputs, n, NULL, &sim->world, 0, &sim->config.integrator };
+    sim->digest = FNV_OFFSET;
+    return 0;
+}
+
+void sim_free(Simulation *sim)
+{
+    if (sim->pool) swarm_pool_destroy(sim->pool);
+    free(sim->drones);
+    free(sim->inputs);
+    free(sim->obstacles);
+    free(sim->targets);
+    world_free(&sim->world);
+    memset(sim, 0, sizeof(*sim));
+}
+
+long sim_time_ms(const Simulation *sim, long tick)
+{
+    return (long)((int64_t)tick * 1000 / sim->config.tick_hz);
+}
+
+int sim_step(Simulation *sim, const InputMsg inputs[], int n_inputs)
+{
+    WorldState *world = &sim->world;
+    int n = sim->config.n_drones;
+
+    // DRONE: same input rules as DroneController.c
+    memset(sim->inputs, 0, (size_t)n * sizeof(InputMsg));
+    memcpy(sim->inputs, inputs, (size_t)(n_inputs < n ? n_inputs : n) * sizeof(InputMsg));
+    for (int i = 1; i < n; i++)
+    {
+        if (sim->inputs[i].command != ' ') sim->inputs[i].command = 0; // Agents can only brake
+    }
+    char command = sim->inputs[0].command;
+    if (command == 'q') return 1;
+    if (command == 's') sim->game_active = 1;
+    if (command == 'r')
+    {
+        // The drone respawns everyone; the server clears the score (the generators keep their slots)
+        for (int i = 0; i < n; i++) drone_spawn(&sim->drones[i], i, n);
+        sim->game_active = 0;
+        world->score = 0;
+    }
+    if (sim->game_active) swarm_step(sim->pool, &sim->batch); // Against the obstacles of the last tick
+
+    world->drone = sim->drones[0];
+    memcpy(world->agents, sim->drones + 1, (size_t)(n - 1) * sizeof(DroneState));
+
+    // OBSTACLES: lifecycle around the drone, the server files the slots
+    int in_use = update_obstacle_lifecycle(sim->obstacles, sim->config.max_obstacles, &world->drone, &sim->rng_obstacles);
+    world_set_obstacles(world, sim->obstacles, in_use);
+
+    // TARGETS: collect, then spawn while the budget lasts
+    world->score += check_target_collision(sim->targets, sim->config.max_targets, &world->drone);
+    if (sim->targets_spawned < sim->targets_to_spawn)
+    {
+        sim->targets_spawned += refresh_targets(sim->targets, sim->config.max_targets, &world->drone, &sim->rng_targets);
+    }
+    world->n_targets = 0;
+    for (int i = 0; i < sim->config.max_targets; i++)
+    {
+        if (sim->targets[i].active) world->targets[world->n_targets++] = sim->targets[i];
+    }
+
+    world->game_active = sim->game_active;
+    world->tick++;
+    sim->ticks++;
+
+    // Anything that differs between two runs shows up here
+    sim->digest = fnv1a(sim->digest, sim->drones, (size_t)n * sizeof(DroneState));
+    sim->digest = fnv1a(sim->digest, &world->score, sizeof(world->score));
+    sim->digest = fnv1a(sim->digest, world->obstacles, (size_t)world->n_obstacles * sizeof(Obstacle));
+    sim->digest = fnv1a(sim->digest, world->targets, (size_t)world->n_targets * sizeof(Target));
+    return 0;
+}
+
+void sim_trace(const Simulation *sim, FILE *f)
+{
+    const WorldState *world = &sim->world;
+    // %.17g round-trips a double: two traces are equal only if the runs are
+    fprintf(f, "%u,%.17g,%.17g,%.17g,%.17g,%d,%d,%d\n", world->tick, world->drone.x, world->drone.y,
+            world->drone.vx, world->drone.vy, world->score, world->n_obstacles, world->n_targets);
+}
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Simulation.h"
+#include "../common.h"
+#include "../KeyboardManager/KeyboardManager.h"
+
+/*  ./sim_run -i script [-s seed] [-n max_ticks] [-z tick_hz] [-d drones]
+              [-o obstacles] [-g targets] [-j threads] [-t trace.csv]
+              [-m semi|verlet|rk4|exact] [-u substeps]
+    Replays a headless input script (same format as INPUT_SCRIPT) as fast as
+    the CPU allows and prints the outcome with a digest of every tick. Two
+    runs with the same seed and script print the same digest.
+*/
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s -i script [-s seed] [-n max_ticks] [-z tick_hz] [-d drones] "
+                    "[-o obstacles] [-g targets] [-j threads] [-t trace.csv] [-m integrator] [-u substeps]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    SimConfig config = { SIM_DEFAULT_SEED, SIM_DEFAULT_TICK_HZ, DEFAULT_MAX_OBSTACLES, DEFAULT_MAX_TARGETS, DEFAULT_DRONES, 1, { INTEGRATOR_SEMI_IMPLICIT, 1, DRAG_COEF }, 0 };
+    const char *script = NULL;
+    const char *trace_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:s:n:z:d:o:g:j:t:m:u:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'i': script = optarg; break;
+            case 's': config.seed = strtoull(optarg, NULL, 0); break;
+            case 'n': config.max_ticks = atol(optarg); break;
+            case 'z': config.tick_hz = atoi(optarg); break;
+            case 'd': config.n_drones = atoi(optarg); break;
+            case 'o': config.max_obstacles = atoi(optarg); break;
+            case 'g': config.max_targets = atoi(optarg); break;
+            case 'j': config.threads = atoi(optarg); break;
+            case 't': trace_path = optarg; break;
+            case 'm': config.integrator.kind = integrator_parse(optarg); break;
+            case 'u': config.integrator.substeps = atoi(optarg); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (script == NULL || config.tick_hz < 1 || config.n_drones < 1 || config.n_drones > ENTITY_CAPACITY_LIMIT ||
+        config.max_obstacles < 1 || config.max_obstacles > ENTITY_CAPACITY_LIMIT ||
+        config.max_targets < 1 || config.max_targets > ENTITY_CAPACITY_LIMIT || config.integrator.kind < 0 ||
+        config.integrator.substeps < 1 || config.integrator.substeps > MAX_SUBSTEPS)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    static ScriptPlayer player;
+    if (script_player_load(&player, script) == -1)
+    {
+        perror("sim_run: Cannot read input script");
+        return 1;
+    }
+
+    FILE *trace = NULL;
+    if (trace_path != NULL)
+    {
+        trace = fopen(trace_path, "w");
+        if (trace == NULL)
+        {
+            perror("sim_run: Cannot open trace file");
+            return 1;
+        }
+        fprintf(trace, "tick,x,y,vx,vy,score,obstacles,targets\n");
+    }
+
+    Simulation sim;
+    if (sim_init(&sim, &config) == -1)
+    {
+        perror("sim_run: Cannot allocate the world");
+        if (trace) fclose(trace);
+        return 1;
+    }
+
+    uint64_t t0 = monotonic_ns();
+    while (config.max_ticks == 0 || sim.ticks < config.max_ticks)
+    {
+        script_player_advance(&player, sim_time_ms(&sim, sim.ticks));
+        if (sim_step(&sim, player.streams, player.n_streams)) break;
+        if (trace) sim_trace(&sim, trace);
+    }
+    double wall = (double)(monotonic_ns() - t0) / 1e9;
+    double simulated = (double)sim_time_ms(&sim, sim.ticks) / 1000.0;
+
+    printf("seed      %llu\n", (unsigned long long)config.seed);
+    printf("physics   %s, %d substep(s)\n", integrator_name(config.integrator.kind), config.integrator.substeps);
+    printf("ticks     %ld (%.1f s simulated at %d Hz)\n", sim.ticks, simulated, config.tick_hz);
+    printf("wall      %.3f s, %.0f ticks/s, %.0fx real time\n", wall,
+           wall > 0 ? sim.ticks / wall : 0.0, wall > 0 ? simulated / wall : 0.0);
+    printf("score     %d\n", sim.world.score);
+    printf("drone     x=%.17g y=%.17g vx=%.17g vy=%.17g\n", sim.world.drone.x, sim.world.drone.y,
+           sim.world.drone.vx, sim.world.drone.vy);
+    printf("digest    %016llx\n", (unsigned long long)sim.digest);
+
+    sim_free(&sim);
+    if (trace) fclose(trace);
+    return 0;
+}
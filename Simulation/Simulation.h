@@ -0,0 +1,121 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <stdio.h>
+#include "../common.h"
+#include "../DroneDynamics/DroneController.h"
+#include "../ObstaclesGenerator/ObstaclesGenerator.h"
+
+/*  DETERMINISTIC MODE (./sim_run)
+    One logical tick counter drives the work of the drone, obstacle and target
+    processes in one thread, in the order the live system does it, with no
+    sleeps and no board or pipes in between. Randomness comes only from the
+    seeded per-subsystem streams, and repulsion runs on the scalar kernel, so
+    the same seed and input script give bit-identical runs on any host.
+*/
+
+#define SIM_DEFAULT_SEED 1
+#define SIM_DEFAULT_TICK_HZ 33 // Script time advances 1000 / tick_hz ms per tick
+
+typedef struct {
+    uint64_t seed;
+    int tick_hz;
+    int max_obstacles;
+    int max_targets;
+    int n_drones;        // Player plus agents
+    int threads;         // Drone pool; the result does not depend on it
+    Integrator integrator;
+    long max_ticks;      // 0 = until the input quits
+} SimConfig;
+
+typedef struct {
+    SimConfig config;
+    WorldState world;        // What the server would publish after each tick
+    DroneState *drones;      // drones[0] is the player
+    InputMsg *inputs;        // This tick's input per drone
+    Obstacle *obstacles;     // The obstacle generator's own slots
+    Target *targets;         // The target generator's own slots
+    Rng rng_obstacles;
+    Rng rng_targets;
+    int targets_spawned;
+    int targets_to_spawn;
+    int game_active;
+    SwarmPool *pool;
+    SwarmBatch batch;
+    long ticks;
+    uint64_t digest;         // FNV-1a over the state after every tick, chained
+} Simulation;
+
+// FUNCTIONS (Sim_functions.c)
+// Returns -1 if the world cannot be allocated
+int sim_init(Simulation *sim, const SimConfig *config);
+void sim_free(Simulation *sim);
+// One tick with 'n_inputs' input streams (drone i gets inputs[i], the rest nothing).
+// Returns 1 once the player quit (nothing was stepped), 0 otherwise.
+int sim_step(Simulation *sim, const InputMsg inputs[], int n_inputs);
+// Milliseconds of script time at the start of tick 'tick'
+long sim_time_ms(const Simulation *sim, long tick);
+// One CSV line of the player's state after the last tick
+void sim_trace(const Simulation *sim, FILE *f);
+
+/*  MONTE CARLO SWEEP (./sim_sweep)
+    Thousands of independent episodes, each with its own draw of the physics and
+    repulsion constants and its own world seed, spread over every core. An
+    autopilot steers at the nearest target; an episode ends once
+    TOTAL_TARGETS_TO_WIN targets are collected or after max_seconds. Episode i
+    only depends on the sweep seed and i, so any episode can be rerun alone.
+*/
+
+typedef enum {
+    SWEEP_DRAG_COEF,
+    SWEEP_THRUST_MULTIPLIER,
+    SWEEP_REPULSIVE_GAIN,
+    SWEEP_INFLUENCE_RANGE,
+    SWEEP_BORDER_GAIN,
+    SWEEP_PARAMS
+} SweepParam;
+
+#define SWEEP_DEFAULT_EPISODES 1000
+#define SWEEP_DEFAULT_SECONDS 120.0
+#define SWEEP_CONTACT_RADIUS 1.0      // Closer to an obstacle than this counts as a collision
+#define AUTOPILOT_LOOKAHEAD_S 0.5     // Steers where the drone will be, not where it is
+
+typedef struct {
+    double lo[SWEEP_PARAMS];   // Each episode draws uniformly from [lo, hi]
+    double hi[SWEEP_PARAMS];
+    uint64_t seed;
+    int episodes;
+    int threads;               // <= 0: one per online CPU
+    double max_seconds;        // Simulated time per episode
+    int max_obstacles;
+    int max_targets;
+    Integrator integrator;     // Its drag is replaced by the episode's
+} SweepConfig;
+
+typedef struct {
+    double params[SWEEP_PARAMS];
+    uint64_t world_seed;
+} EpisodeSetup;
+
+typedef struct {
+    int targets;               // Collected
+    int collisions;            // Contacts with an obstacle (entering SWEEP_CONTACT_RADIUS)
+    double first_target_s;     // -1 = none collected
+    double mean_target_s;      // Mean time per collected target
+    double seconds;            // Simulated time until the end of the episode
+} EpisodeResult;
+
+// FUNCTIONS (Sweep_functions.c)
+// Lower-case constant name ("drag_coef", ...); -1 if unknown
+int sweep_param_parse(const char *name);
+const char *sweep_param_name(int param);
+// Every range at the compiled-in value
+void sweep_config_defaults(SweepConfig *config);
+// The draw of episode 'episode'
+void sweep_sample(const SweepConfig *config, int episode, EpisodeSetup *setup);
+// Returns -1 if the episode's arrays cannot be allocated
+int run_episode(const SweepConfig *config, const EpisodeSetup *setup, EpisodeResult *result);
+// Samples and runs every episode on the threads; returns -1 on failure
+int sweep_run(const SweepConfig *config, EpisodeSetup setups[], EpisodeResult results[]);
+
+#endif
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Simulation.h"
+#include "../common.h"
+
+/*  ./sim_sweep [-n episodes] [-s seed] [-j threads] [-t seconds] [-o table.tsv]
+                [-p name=lo:hi | name=value]... [-m integrator] [-u substeps]
+                [-b obstacles] [-g targets]
+    Runs a Monte Carlo sweep over the physics and repulsion constants and
+    writes one line per episode (tab-separated, '#' header) to the table,
+    stdout by default. Constants without -p keep their compiled-in value.
+    A summary with the best episodes goes to stderr.
+*/
+
+#define SWEEP_TOP 5
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-n episodes] [-s seed] [-j threads] [-t seconds] [-o table.tsv] "
+                    "[-p name=lo:hi]... [-m integrator] [-u substeps] [-b obstacles] [-g targets]\n"
+                    "Parameters:", name);
+    for (int p = 0; p < SWEEP_PARAMS; p++) fprintf(stderr, " %s", sweep_param_name(p));
+    fprintf(stderr, "\n");
+}
+
+// "name=lo:hi" or "name=value"
+static int parse_range(const char *arg, SweepConfig *config)
+{
+    char name[32];
+    double lo, hi;
+    int n = sscanf(arg, "%31[a-z_]=%lf:%lf", name, &lo, &hi);
+    if (n < 2) return -1;
+    if (n == 2) hi = lo;
+    int p = sweep_param_parse(name);
+    if (p == -1 || lo > hi || lo < 0) return -1;
+    if (p == SWEEP_INFLUENCE_RANGE && lo <= 0) return -1;
+    config->lo[p] = lo;
+    config->hi[p] = hi;
+    return 0;
+}
+
+// More targets, then fewer collisions, then less time per target
+static const EpisodeResult *sort_results;
+
+static int better_first(const void *a, const void *b)
+{
+    const EpisodeResult *x = &sort_results[*(const int *)a], *y = &sort_results[*(const int *)b];
+    if (x->targets != y->targets) return y->targets - x->targets;
+    if (x->collisions != y->collisions) return x->collisions - y->collisions;
+    if (x->mean_target_s != y->mean_target_s) return (x->mean_target_s < y->mean_target_s) ? -1 : 1;
+    return *(const int *)a - *(const int *)b;
+}
+
+static void print_row(FILE *f, int episode, const EpisodeSetup *setup, const EpisodeResult *result)
+{
+    fprintf(f, "%d\t%016llx", episode, (unsigned long long)setup->world_seed);
+    for (int p = 0; p < SWEEP_PARAMS; p++) fprintf(f, "\t%.4f", setup->params[p]);
+    fprintf(f, "\t%d\t%d\t%.2f\t%.2f\t%.2f\n", result->targets, result->collisions,
+            result->first_target_s, result->mean_target_s, result->seconds);
+}
+
+int main(int argc, char *argv[])
+{
+    SweepConfig config;
+    sweep_config_defaults(&config);
+    const char *table_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:j:t:o:p:m:u:b:g:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': config.episodes = atoi(optarg); break;
+            case 's': config.seed = strtoull(optarg, NULL, 0); break;
+            case 'j': config.threads = atoi(optarg); break;
+            case 't': config.max_seconds = atof(optarg); break;
+            case 'o': table_path = optarg; break;
+            case 'p':
+                if (parse_range(optarg, &config) == -1)
+                {
+                    fprintf(stderr, "sim_sweep: bad parameter range '%s'\n", optarg);
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'm': config.integrator.kind = integrator_parse(optarg); break;
+            case 'u': config.integrator.substeps = atoi(optarg); break;
+            case 'b': config.max_obstacles = atoi(optarg); break;
+            case 'g': config.max_targets = atoi(optarg); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (config.episodes < 1 || config.max_seconds <= 0 || config.integrator.kind < 0 ||
+        config.integrator.substeps < 1 || config.integrator.substeps > MAX_SUBSTEPS ||
+        config.max_obstacles < 1 || config.max_obstacles > ENTITY_CAPACITY_LIMIT ||
+        config.max_targets < 1 || config.max_targets > ENTITY_CAPACITY_LIMIT)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    EpisodeSetup *setups = calloc(config.episodes, sizeof(EpisodeSetup));
+    EpisodeResult *results = calloc(config.episodes, sizeof(EpisodeResult));
+    int *order = calloc(config.episodes, sizeof(int));
+    if (setups == NULL || results == NULL || order == NULL) { perror("sim_sweep: alloc"); return 1; }
+
+    FILE *table = stdout;
+    if (table_path != NULL && (table = fopen(table_path, "w")) == NULL)
+    {
+        perror("sim_sweep: Cannot open table");
+        return 1;
+    }
+
+    uint64_t t0 = monotonic_ns();
+    if (sweep_run(&config, setups, results) == -1)
+    {
+        perror("sim_sweep: episodes failed");
+        return 1;
+    }
+    double wall = (double)(monotonic_ns() - t0) / 1e9;
+
+    // TABLE
+    fprintf(table, "# seed %llu, %d episodes of up to %.0f s, %s x%d\n", (unsigned long long)config.seed,
+            config.episodes, config.max_seconds, integrator_name(config.integrator.kind), config.integrator.substeps);
+    fprintf(table, "#episode\tworld_seed");
+    for (int p = 0; p < SWEEP_PARAMS; p++) fprintf(table, "\t%s", sweep_param_name(p));
+    fprintf(table, "\ttargets\tcollisions\tfirst_target_s\ts_per_target\tseconds\n");
+    double sim_seconds = 0, targets = 0, collisions = 0;
+    for (int i = 0; i < config.episodes; i++)
+    {
+        print_row(table, i, &setups[i], &results[i]);
+        sim_seconds += results[i].seconds;
+        targets += results[i].targets;
+        collisions += results[i].collisions;
+        order[i] = i;
+    }
+    if (table != stdout) fclose(table);
+
+    // SUMMARY
+    sort_results = results;
+    qsort(order, config.episodes, sizeof(int), better_first);
+    fprintf(stderr, "%d episodes in %.2f s wall: %.0f episodes/s, %.0fx real time\n", config.episodes, wall,
+            config.episodes / wall, sim_seconds / wall);
+    fprintf(stderr, "mean %.2f targets, %.2f collisions per episode\n", targets / config.episodes,
+            collisions / config.episodes);
+    fprintf(stderr, "best:\n");
+    for (int k = 0; k < SWEEP_TOP && k < config.episodes; k++) print_row(stderr, order[k], &setups[order[k]], &results[order[k]]);
+
+    free(order);
+    free(results);
+    free(setups);
+    return 0;
+}
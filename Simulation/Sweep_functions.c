@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "Simulation.h"
+#include "../common.h"
+#include "../DroneDynamics/DroneController.h"
+#include "../ObstaclesGenerator/ObstaclesGenerator.h"
+#include "../TargetGenerator/TargetGenerator.h"
+
+static const char *param_names[SWEEP_PARAMS] = {
+    "drag_coef", "thrust_multiplier", "repulsive_gain", "influence_range", "border_gain"
+};
+
+int sweep_param_parse(const char *name)
+{
+    for (int p = 0; p < SWEEP_PARAMS; p++)
+    {
+        if (strcmp(name, param_names[p]) == 0) return p;
+    }
+    return -1;
+}
+
+const char *sweep_param_name(int param)
+{
+    return (param >= 0 && param < SWEEP_PARAMS) ? param_names[param] : "?";
+}
+
+void sweep_config_defaults(SweepConfig *config)
+{
+    static const double compiled[SWEEP_PARAMS] = {
+        DRAG_COEF, THRUST_MULTIPLIER, REPULSIVE_GAIN, INFLUENCE_RANGE, BORDER_GAIN
+    };
+    memset(config, 0, sizeof(*config));
+    for (int p = 0; p < SWEEP_PARAMS; p++) config->lo[p] = config->hi[p] = compiled[p];
+    config->seed = SIM_DEFAULT_SEED;
+    config->episodes = SWEEP_DEFAULT_EPISODES;
+    config->max_seconds = SWEEP_DEFAULT_SECONDS;
+    config->max_obstacles = DEFAULT_MAX_OBSTACLES;
+    config->max_targets = DEFAULT_MAX_TARGETS;
+    config->integrator = (Integrator){ INTEGRATOR_SEMI_IMPLICIT, 1, DRAG_COEF };
+}
+
+void sweep_sample(const SweepConfig *config, int episode, EpisodeSetup *setup)
+{
+    // Its own stream per episode: the draw does not depend on how the others went
+    Rng rng;
+    rng_seed(&rng, config->seed, RNG_STREAM_SWEEP + ((uint64_t)episode << 8));
+    for (int p = 0; p < SWEEP_PARAMS; p++)
+    {
+        double u = rng_next(&rng) / 4294967296.0;
+        setup->params[p] = config->lo[p] + (config->hi[p] - config->lo[p]) * u;
+    }
+    // Two statements: the order of the draws must not be up to the compiler
+    uint64_t hi = rng_next(&rng);
+    uint64_t lo = rng_next(&rng);
+    setup->world_seed = (hi << 32) | lo;
+}
+
+// EPISODE
+typedef struct {
+    double thrust_x, thrust_y;
+    const Obstacle *obstacles;
+    int n_obstacles;
+    const RepulsionModel *model;
+} EpisodeForces;
+
+static void episode_forces(const DroneState *s, void *ctx, double *fx, double *fy)
+{
+    const EpisodeForces *forces = ctx;
+    DroneState probe = *s;
+    probe.force_x = forces->thrust_x;
+    probe.force_y = forces->thrust_y;
+    apply_repulsive_forces_model(&probe, forces->obstacles, forces->n_obstacles, forces->model);
+    apply_border_forces_model(&probe, forces->model);
+    *fx = probe.force_x;
+    *fy = probe.force_y;
+}
+
+// Full thrust towards the nearest target, aimed from where the drone is heading;
+// no input while there is nothing to collect
+static void autopilot(const DroneState *drone, const Target targets[], int capacity, double *ux, double *uy)
+{
+    double px = drone->x + drone->vx * AUTOPILOT_LOOKAHEAD_S;
+    double py = drone->y + drone->vy * AUTOPILOT_LOOKAHEAD_S;
+    double best = -1, dx = 0, dy = 0;
+    for (int i = 0; i < capacity; i++)
+    {
+        if (!targets[i].active) continue;
+        double d2 = (targets[i].x - drone->x) * (targets[i].x - drone->x) + (targets[i].y - drone->y) * (targets[i].y - drone->y);
+        if (best < 0 || d2 < best)
+        {
+            best = d2;
+            dx = targets[i].x - px;
+            dy = targets[i].y - py;
+        }
+    }
+    double len = sqrt(dx * dx + dy * dy);
+    *ux = (len > 1e-9) ? dx / len : 0;
+    *uy = (len > 1e-9) ? dy / len : 0;
+}
+
+static int touching_obstacle(const DroneState *drone, const Obstacle obstacles[], int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        if (!obstacles[i].active) continue;
+        double dx = drone->x - obstacles[i].x, dy = drone->y - obstacles[i].y;
+        if (dx * dx + dy * dy < SWEEP_CONTACT_RADIUS * SWEEP_CONTACT_RADIUS) return 1;
+    }
+    return 0;
+}
+
+int run_episode(const SweepConfig *config, const EpisodeSetup *setup, EpisodeResult *result)
+{
+    Obstacle *obstacles = calloc(config->max_obstacles + 1, sizeof(Obstacle));
+    Target *targets = calloc(config->max_targets + 1, sizeof(Target));
+    if (obstacles == NULL || targets == NULL)
+    {
+        free(obstacles);
+        free(targets);
+        return -1;
+    }
+
+    RepulsionModel model = { setup->params[SWEEP_REPULSIVE_GAIN], setup->params[SWEEP_INFLUENCE_RANGE],
+                             setup->params[SWEEP_BORDER_GAIN] };
+    Integrator integrator = config->integrator;
+    integrator.drag = setup->params[SWEEP_DRAG_COEF];
+    double thrust = setup->params[SWEEP_THRUST_MULTIPLIER];
+    Rng rng_obstacles, rng_targets;
+    rng_seed(&rng_obstacles, setup->world_seed, RNG_STREAM_OBSTACLES);
+    rng_seed(&rng_targets, setup->world_seed, RNG_STREAM_TARGETS);
+
+    DroneState drone;
+    drone_spawn(&drone, 0, 1);
+    int to_spawn = (config->max_targets > TOTAL_TARGETS_TO_WIN) ? config->max_targets : TOTAL_TARGETS_TO_WIN;
+    int spawned = 0, in_use = 0, touching = 0;
+    long max_ticks = lround(config->max_seconds / DT);
+    long tick;
+    memset(result, 0, sizeof(*result));
+    result->first_target_s = -1;
+
+    // The live order: drone against the last obstacles, then obstacles, then targets
+    for (tick = 0; tick < max_ticks && result->targets < TOTAL_TARGETS_TO_WIN; tick++)
+    {
+        double ux, uy;
+        autopilot(&drone, targets, config->max_targets, &ux, &uy);
+        EpisodeForces forces = { ux * thrust, uy * thrust, obstacles, in_use, &model };
+        integrate(&drone, DT, &integrator, episode_forces, &forces);
+
+        int touch = touching_obstacle(&drone, obstacles, in_use);
+        if (touch && !touching) result->collisions++;
+        touching = touch;
+
+        in_use = update_obstacle_lifecycle(obstacles, config->max_obstacles, &drone, &rng_obstacles);
+
+        int collected = check_target_collision(targets, config->max_targets, &drone);
+        if (collected > 0 && result->first_target_s < 0) result->first_target_s = (tick + 1) * DT;
+        result->targets += collected;
+        if (spawned < to_spawn) spawned += refresh_targets(targets, config->max_targets, &drone, &rng_targets);
+    }
+    result->seconds = tick * DT;
+    result->mean_target_s = (result->targets > 0) ? result->seconds / result->targets : -1;
+
+    free(obstacles);
+    free(targets);
+    return 0;
+}
+
+// PARALLEL RUNNER
+// Workers claim episodes from a shared counter; results go to the episode's own
+// slot, so the table is the same whatever the thread count
+typedef struct {
+    const SweepConfig *config;
+    EpisodeSetup *setups;
+    EpisodeResult *results;
+    _Atomic int next;
+    _Atomic int failed;
+} SweepJob;
+
+static void *sweep_worker(void *arg)
+{
+    SweepJob *job = arg;
+    int i;
+    while ((i = atomic_fetch_add(&job->next, 1)) < job->config->episodes)
+    {
+        sweep_sample(job->config, i, &job->setups[i]);
+        if (run_episode(job->config, &job->setups[i], &job->results[i]) == -1) atomic_store(&job->failed, 1);
+    }
+    return NULL;
+}
+
+int sweep_run(const SweepConfig *config, EpisodeSetup setups[], EpisodeResult results[])
+{
+    int threads = config->threads;
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > config->episodes) threads = config->episodes;
+
+    SweepJob job = { config, setups, results, 0, 0 };
+    pthread_t *workers = calloc(threads, sizeof(pthread_t));
+    if (workers == NULL) return -1;
+
+    // The caller is worker 0
+    int started = 1;
+    for (int t = 1; t < threads; t++)
+    {
+        if (pthread_create(&workers[t], NULL, sweep_worker, &job) != 0)
+        {
+            perror("sim_sweep: worker thread");
+            break; // Run with what we have
+        }
+        started++;
+    }
+    sweep_worker(&job);
+    for (int t = 1; t < started; t++) pthread_join(workers[t], NULL);
+    free(workers);
+    return atomic_load(&job.failed) ? -1 : 0;
+}
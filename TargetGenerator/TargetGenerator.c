@@ -10,58 +10,86 @@
 #include "TargetGenerator.h"
 
 // Flags
-volatile sig_atomic_t keep_running = 1;
+static volatile sig_atomic_t keep_running = 1;
 
-void handle_signal(int sig) 
+static void handle_signal(int sig) 
 { 
     keep_running = 0; 
 }
 
 int main(int argc, char *argv[]) 
 {
-    signal(SIGINT, handle_signal);
-    signal(SIGTERM, handle_signal);
-    signal(SIGPIPE, SIG_IGN);
-    srand(time(NULL) + getpid()); // Unique random seed
+    // As a thread of the threaded build the server owns the signals; we stop when the board closes
+    if (!subsystem_is_thread())
+    {
+        signal(SIGINT, handle_signal);
+        signal(SIGTERM, handle_signal);
+        signal(SIGPIPE, SIG_IGN);
+    }
+
+    char suffix[50] = "";
+    if (argc > 1) snprintf(suffix, sizeof(suffix), "%s", argv[1]);
+
+    // SHARED BOARD
+    // Drone State is read from the blackboard segment
+    SharedBoard *board = board_attach(suffix);
+    if (board == NULL) { perror("TargetProc: attach board"); return 1; }
 
     // PIPES 
-    // Read Drone State from Server 
-    const char *fifoBBTar = "/tmp/fifoBBTar";   
     // Write Targets + Score to the server
     const char *fifoTarBB = "/tmp/fifoTarBB"; 
 
-    int fd_BBTar = open(fifoBBTar, O_RDONLY);
-    if (fd_BBTar == -1) { perror("TargetProc: open Req"); return 1; }
-
-    int fd_TarBB = open(fifoTarBB, O_WRONLY);
+    int fd_TarBB = link_open(fifoTarBB, O_WRONLY);
     if (fd_TarBB == -1) { perror("TargetProc: open Data"); return 1; }
+    FrameWriter tar_writer;
+    frame_writer_init(&tar_writer, fd_TarBB);
 
     // LOCAL STATE
     DroneState drone = {0};
-    Target targets[MAX_TARGETS];
-    
-    // Initialize targets to inactive
-    for(int i=0; i<MAX_TARGETS; i++) targets[i].active = 0;
-
-    // Counter for the total targets generated
+    uint32_t last_seq = 0;
+    uint32_t frame_tick = 0;
+    // Slots and the outgoing packet are sized once from the board capacity
+    int capacity = board->max_targets;
+    Target *targets = calloc(capacity + 1, sizeof(Target)); // Initialize targets to inactive
+    size_t packet_cap = sizeof(TargetPacket) + (size_t)capacity * sizeof(Target);
+    unsigned char *packet_buf = malloc(packet_cap);
+    if (targets == NULL || packet_buf == NULL) { perror("TargetProc: alloc"); return 1; }
+    // Own random stream: seeded from SEED in param.conf (via the board), or unique per run
+    Rng rng;
+    rng_seed(&rng, rng_seed_or_clock(board->seed), RNG_STREAM_TARGETS);
+    board_set_ready(board, COMPONENT_TARGETS);
+    heartbeat_start(board, COMPONENT_TARGETS, board->tick_ns); // Paced by the server's publishes
+
+    // Counter for the total targets generated.
+    // Bigger capacities raise the budget, so large scenarios can fill the map.
     int targets_spawned_total = 0;
+    int targets_to_spawn = (capacity > TOTAL_TARGETS_TO_WIN) ? capacity : TOTAL_TARGETS_TO_WIN;
 
     TargetPacket packet;
 
     while(keep_running) 
     {
-        // Wait for Drone State from Server
-        ssize_t bytes = read(fd_BBTar, &drone, sizeof(DroneState));
-        if (bytes <= 0) break; // Server closed connection
+        heartbeat_beat(board, COMPONENT_TARGETS);
+
+        // Wait for the next frame from the Server (frames we were too slow for are skipped)
+        if (!board_wait_update(board, last_seq, BOARD_WAIT_MS)) continue;
+        if (atomic_load(&board->closed)) break; // Server closed connection
+
+        do
+        {
+            last_seq = board_read_begin(board);
+            drone = board->world.drone;
+            frame_tick = board->world.tick;
+        } while (board_read_retry(board, last_seq));
         
         // Check Collisions ( If drone touches target -> active=0, return score)
-        int score = check_target_collision(targets, &drone);
+        int score = check_target_collision(targets, capacity, &drone);
 
         // Spawn logic
-        if (targets_spawned_total < TOTAL_TARGETS_TO_WIN) 
+        if (targets_spawned_total < targets_to_spawn) 
         {
             // Call the refresh function
-            int spawned = refresh_targets(targets, &drone);
+            int spawned = refresh_targets(targets, capacity, &drone, &rng);
 
             // Execute this logic if a new target was actually created
             if (spawned > 0) 
@@ -69,7 +97,7 @@ int main(int argc, char *argv[])
                 targets_spawned_total += spawned;
 
                 // Log the new target position by finding an active one
-                for(int i=0; i<MAX_TARGETS; i++) 
+                for(int i=0; i<capacity; i++) 
                 {
                     if (targets[i].active) 
                     {
@@ -83,16 +111,27 @@ int main(int argc, char *argv[])
         }
 
         // Prepare Data Packet
-        // Copy our local targets to the packet
-        memcpy(packet.targets, targets, sizeof(targets));
+        // Header followed by our active targets (variable-length frame)
+        Target *outgoing = (Target *)(packet_buf + sizeof(TargetPacket));
+        packet.count = 0;
+        for (int i = 0; i < capacity; i++) 
+        {
+            if (targets[i].active) outgoing[packet.count++] = targets[i];
+        }
         packet.score_increment = score;
+        packet.tick = frame_tick;
+        memcpy(packet_buf, &packet, sizeof(TargetPacket));
 
         // Send back to Server
-        write(fd_TarBB, &packet, sizeof(TargetPacket));
+        size_t packet_len = sizeof(TargetPacket) + packet.count * sizeof(Target);
+        if (frame_send(&tar_writer, MSG_TARGETS, packet_buf, packet_len) == -1) break; // Server gone (EPIPE)
     }
 
     // Cleanup
-    close(fd_BBTar);
-    close(fd_TarBB);
+    free(targets);
+    free(packet_buf);
+    link_close(fd_TarBB);
+    heartbeat_stop(board, COMPONENT_TARGETS);
+    board_detach(board);
     return 0;
 }
\ No newline at end of file
@@ -9,9 +9,10 @@
 
 // Functions
 // GENERATOR 
-int refresh_targets(Target targets[], const DroneState *drone);
+// Spawns draw from 'rng'
+int refresh_targets(Target targets[], int capacity, const DroneState *drone, Rng *rng);
 
 // COLLISION MANAGER 
-int check_target_collision(Target targets[], const DroneState *drone);
+int check_target_collision(Target targets[], int capacity, const DroneState *drone);
 
 #endif
\ No newline at end of file
@@ -4,26 +4,26 @@
 #include "TargetGenerator.h"
 
 // GENERATOR 
-int refresh_targets(Target targets[], const DroneState *drone) 
+int refresh_targets(Target targets[], int capacity, const DroneState *drone, Rng *rng) 
 {   
     int active_count = 0;
-    for (int i = 0; i < MAX_TARGETS; i++) 
+    for (int i = 0; i < capacity; i++) 
     {
         if (targets[i].active) active_count++;
     }
 
-    if (active_count < MAX_TARGETS) 
+    if (active_count < capacity) 
     {
-        for (int i = 0; i < MAX_TARGETS; i++) 
+        for (int i = 0; i < capacity; i++) 
         {
             if (!targets[i].active) 
             {
-                if ((rand() % 100) < TARGET_SPAWN_RATE) 
+                if (rng_below(rng, 100) < TARGET_SPAWN_RATE) 
                 {
                     // Spawn at least 5 units away from the walls
                     int margin = 5;
-                    int tx = (rand() % (MAP_WIDTH - 2*margin)) + margin;
-                    int ty = (rand() % (MAP_HEIGHT - 2*margin)) + margin;
+                    int tx = rng_below(rng, MAP_WIDTH - 2*margin) + margin;
+                    int ty = rng_below(rng, MAP_HEIGHT - 2*margin) + margin;
 
                     // Drone distance
                     if (abs(tx - (int)drone->x) > 5 || abs(ty - (int)drone->y) > 5) 
@@ -42,11 +42,11 @@ int refresh_targets(Target targets[], const DroneState *drone)
 }
 
 // COLLISION MANAGER 
-int check_target_collision(Target targets[], const DroneState *drone) 
+int check_target_collision(Target targets[], int capacity, const DroneState *drone) 
 {
     int score_increment = 0;
 
-    for (int i = 0; i < MAX_TARGETS; i++) 
+    for (int i = 0; i < capacity; i++) 
     {
         if (targets[i].active) 
         {
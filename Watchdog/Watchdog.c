@@ -1,53 +1,156 @@
+#include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <signal.h>
 #include <sys/types.h>
 #include "../common.h"
 
+/* Watchdog.c - Polls the heartbeat table in the shared board
+   Every process bumps its slot once per loop. A beat that comes more than
+   HEARTBEAT_MISS_FACTOR periods after the previous one is a deadline miss, a silence of
+   HEARTBEAT_STALL_PERIODS periods is a stall. Both are counted in the table (the server
+   exports them with its metrics) and logged; only a server silent for
+   TIMEOUT_SECONDS still takes the system down.
+*/
 
-// Global last beat time
-volatile sig_atomic_t keep_running = 1;
+#define WATCHDOG_POLL_US 1000     // Table poll period
+#define WATCHDOG_REPORT_MS 1000   // Deadline misses are logged at most this often per process
+#define STALL_MIN_NS 100000000ULL // Shortest silence reported as a stall
 
-// HANDLER: Triggered when the Alarm goes off 
-void handle_alarm(int sig) 
+// What the watchdog remembers about one slot
+typedef struct {
+    uint64_t beats;         // Count at the previous poll
+    uint64_t last_ns;       // Time of the newest beat seen
+    int stalled;
+    uint64_t pending_misses; // Not logged yet
+    uint64_t pending_worst_ns;
+    uint64_t last_report_ns;
+} SlotWatch;
+
+static volatile sig_atomic_t keep_running = 1;
+
+// HANDLER: Clean exit
+static void handle_term(int sig)
 {
-    log_msg("WATCHDOG", "ALERT: No heartbeat received for %d seconds. Killing system.", TIMEOUT_SECONDS);   
-    // Kill the Parent Process (Server)
-    kill(getppid(), SIGTERM);
-    exit(EXIT_FAILURE);
+    keep_running = 0;
 }
 
-// HANDLER: Triggered when Server is alive
-void handle_heartbeat(int sig) 
+static void report_misses(Component c, SlotWatch *w, uint64_t deadline_ns, uint64_t now)
 {
-    // Reset the alarm clock
-    alarm(TIMEOUT_SECONDS);
+    if (w->pending_misses == 0) return;
+    log_msg("WATCHDOG", "%s missed %llu tick deadline(s) (%.1f ms), worst gap %.1f ms",
+            component_name(c), (unsigned long long)w->pending_misses, deadline_ns / 1e6, w->pending_worst_ns / 1e6);
+    w->pending_misses = 0;
+    w->pending_worst_ns = 0;
+    w->last_report_ns = now;
 }
 
-// HANDLER: Clean exit
-void handle_term(int sig)
+// One look at one slot; returns 1 if the server has been silent for TIMEOUT_SECONDS
+static int check_slot(SharedBoard *board, Component c, SlotWatch *w, uint64_t now)
 {
-    keep_running = 0;
+    Heartbeat *hb = &board->heartbeats[c];
+    if (!atomic_load(&hb->running))
+    {
+        // A server that never reaches its tick loop still runs out of time
+        return c == COMPONENT_SERVER && atomic_load(&hb->beats) == 0 &&
+               now - w->last_ns > TIMEOUT_SECONDS * 1000000000ULL;
+    }
+
+    uint64_t period = hb->period_ns;
+    uint64_t deadline = (uint64_t)(period * HEARTBEAT_MISS_FACTOR);
+    uint64_t stall_after = period * HEARTBEAT_STALL_PERIODS;
+    if (stall_after < STALL_MIN_NS) stall_after = STALL_MIN_NS;
+
+    uint64_t beats = atomic_load_explicit(&hb->beats, memory_order_acquire);
+    uint64_t last_ns = atomic_load_explicit(&hb->last_ns, memory_order_relaxed);
+    if (w->last_ns == 0) w->last_ns = last_ns; // First look: heartbeat_start() stamped the slot
+
+    if (beats != w->beats)
+    {
+        // Several beats between two polls: only their average gap is known
+        uint64_t gap = (last_ns - w->last_ns) / (beats - w->beats);
+        if (w->beats != 0 && period > 0 && gap > deadline)
+        {
+            atomic_fetch_add(&hb->misses, 1);
+            w->pending_misses++;
+            if (gap > w->pending_worst_ns) w->pending_worst_ns = gap;
+        }
+        if (w->beats != 0 && gap > atomic_load(&hb->worst_gap_ns)) atomic_store(&hb->worst_gap_ns, gap);
+        if (w->stalled)
+        {
+            log_msg("WATCHDOG", "%s resumed after a %.1f ms stall", component_name(c), (last_ns - w->last_ns) / 1e6);
+            w->stalled = 0;
+        }
+        w->beats = beats;
+        w->last_ns = last_ns;
+    }
+    else if (now > w->last_ns)
+    {
+        uint64_t silence = now - w->last_ns;
+        if (!w->stalled && silence > stall_after)
+        {
+            w->stalled = 1;
+            atomic_fetch_add(&hb->stalls, 1);
+            log_msg("WATCHDOG", "%s stalled: no heartbeat for %.1f ms", component_name(c), silence / 1e6);
+        }
+        if (c == COMPONENT_SERVER && silence > TIMEOUT_SECONDS * 1000000000ULL) return 1;
+    }
+
+    if (now - w->last_report_ns > WATCHDOG_REPORT_MS * 1000000ULL) report_misses(c, w, deadline, now);
+    return 0;
 }
 
-int main(int argc, char *argv[]) 
+int main(int argc, char *argv[])
 {
     // Register Signals
-    signal(SIGALRM, handle_alarm);     // The "Time's up" signal
-    signal(SIGUSR1, handle_heartbeat); // The "Heartbeat" signal
-    signal(SIGTERM, handle_term);      // The "Quit" signal
+    signal(SIGINT, handle_term);  // Ctrl+C reaches the whole process group
+    signal(SIGTERM, handle_term); // The "Quit" signal
+
+    log_msg("WATCHDOG", "Started. Polling heartbeats every %d us", WATCHDOG_POLL_US);
 
-    log_msg("WATCHDOG", "Started. Waiting for signals...");
+    // The watchdog only runs standalone, so the board has no suffix
+    SharedBoard *board = board_attach("");
+    if (board == NULL) { perror("Watchdog: attach board"); return 1; }
+    board_set_ready(board, COMPONENT_WATCHDOG);
 
-    // Start the first countdown
-    alarm(TIMEOUT_SECONDS);
+    static SlotWatch watch[COMPONENT_COUNT];
+    uint64_t start = monotonic_ns();
+    for (int c = 0; c < COMPONENT_COUNT; c++) watch[c].last_report_ns = start;
 
-    // Wait forever 
-    while (keep_running) 
+    // The server only starts beating once its children are up
+    watch[COMPONENT_SERVER].last_ns = start;
+
+    while (keep_running && !atomic_load(&board->closed))
     {
-        pause(); // Suspends process until a signal arrives
+        uint64_t now = monotonic_ns();
+        for (int c = 0; c < COMPONENT_COUNT; c++)
+        {
+            if (check_slot(board, c, &watch[c], now))
+            {
+                log_msg("WATCHDOG", "ALERT: No heartbeat received for %d seconds. Killing system.", TIMEOUT_SECONDS);
+                // Kill the Parent Process (Server)
+                kill(getppid(), SIGTERM);
+                board_detach(board);
+                exit(EXIT_FAILURE);
+            }
+        }
+        usleep(WATCHDOG_POLL_US);
     }
 
+    // SUMMARY
+    uint64_t now = monotonic_ns();
+    for (int c = 0; c < COMPONENT_COUNT; c++)
+    {
+        Heartbeat *hb = &board->heartbeats[c];
+        uint64_t beats = atomic_load(&hb->beats);
+        if (beats == 0) continue;
+        report_misses(c, &watch[c], (uint64_t)(hb->period_ns * HEARTBEAT_MISS_FACTOR), now);
+        log_msg("WATCHDOG", "%s: %llu beats, %llu deadline misses, %llu stalls, worst gap %.1f ms",
+                component_name(c), (unsigned long long)beats, (unsigned long long)atomic_load(&hb->misses),
+                (unsigned long long)atomic_load(&hb->stalls), atomic_load(&hb->worst_gap_ns) / 1e6);
+    }
+    board_detach(board);
+
     log_msg("WATCHDOG", "Terminating.");
     return 0;
-}
\ No newline at end of file
+}
@@ -3,27 +3,1441 @@
 #include <stdarg.h>
 #include <string.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "common.h"
 
-// Log function that appends to a file
-void log_msg(const char *process_name, const char *format, ...)
- {
-    FILE *f = fopen("simulation.log", "a");
-    if (f == NULL) return; // Can't log if file sys is broken
+// LOGGING
+// One lock-free multi-producer ring per process (a bounded queue with a sequence
+// number per slot). log_msg() formats into a slot and returns; the flusher thread
+// stamps, coalesces and appends the lines to LOG_FILE every LOG_FLUSH_MS.
+typedef struct {
+    _Atomic size_t seq;   // == position while free, position + 1 once filled
+    uint64_t ns;          // monotonic_ns() of the call; turned into wall time by the flusher
+    char process[LOG_NAME_MAX];
+    char text[LOG_TEXT_MAX];
+} LogSlot;
+
+// Flusher side, only touched under log_drain_lock
+typedef struct {
+    int fd;
+    uint64_t mono_base, real_base; // Pairs monotonic stamps with wall-clock time
+    time_t cached_sec;             // The date part is formatted once per second
+    char cached_date[32];
+    char last_process[LOG_NAME_MAX];
+    char last_text[LOG_TEXT_MAX];
+    uint64_t repeats;              // Copies of the last line held back
+    uint64_t repeat_since_ns;
+    uint64_t repeat_last_ns;
+    uint64_t dropped_reported;
+    size_t out_len;
+    char out[1 << 16];
+} LogWriter;
+
+static LogSlot log_ring[LOG_RING_SLOTS];
+static _Atomic size_t log_head;      // Next slot a producer claims
+static size_t log_tail;              // Next slot the flusher writes out
+static _Atomic uint64_t log_dropped; // Messages lost to a full ring
+static _Atomic uint32_t log_wake;    // Futex word the flusher sleeps on
+static _Atomic int log_state;        // LOG_THREAD_* below
+static _Atomic int log_stopping;
+static int log_needs_reset;          // Set in a forked child: the ring is the parent's
+static pthread_t log_thread;
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t log_drain_lock = PTHREAD_MUTEX_INITIALIZER;
+static LogWriter log_writer = { .fd = -1 };
+
+enum { LOG_THREAD_NONE, LOG_THREAD_STARTING, LOG_THREAD_RUNNING, LOG_THREAD_INLINE };
+
+static void log_reset_ring(void)
+{
+    for (size_t i = 0; i < LOG_RING_SLOTS; i++) atomic_store_explicit(&log_ring[i].seq, i, memory_order_relaxed);
+    atomic_store(&log_head, 0);
+    log_tail = 0;
+    atomic_store(&log_dropped, 0);
+    log_writer.repeats = 0;
+    log_writer.last_text[0] = '\0';
+    log_writer.dropped_reported = 0;
+    log_writer.out_len = 0;
+}
 
-    // Get current time
-    time_t now;
-    time(&now);
-    char *date = ctime(&now);
-    date[strlen(date) - 1] = '\0'; 
+// (Re)opens LOG_FILE if another process rotated it, and rotates it when it is full
+static void log_check_file(size_t incoming)
+{
+    struct stat path_st, fd_st;
+    int have_path = (stat(LOG_FILE, &path_st) == 0);
+    if (log_writer.fd != -1 && (!have_path || fstat(log_writer.fd, &fd_st) == -1 || fd_st.st_ino != path_st.st_ino))
+    {
+        close(log_writer.fd);
+        log_writer.fd = -1;
+    }
+    if (log_writer.fd == -1)
+    {
+        log_writer.fd = open(LOG_FILE, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+        if (log_writer.fd == -1 || fstat(log_writer.fd, &fd_st) == -1) return;
+    }
+    if ((size_t)fd_st.st_size + incoming <= LOG_ROTATE_BYTES) return;
 
-    fprintf(f, "[%s] [%s] ", date, process_name);
+    // Every process appends to the same file: the lock makes sure only one of them rotates it
+    flock(log_writer.fd, LOCK_EX);
+    if (stat(LOG_FILE, &path_st) == 0 && path_st.st_ino == fd_st.st_ino)
+    {
+        char from[64], to[64];
+        for (int k = LOG_ROTATE_KEEP - 1; k >= 1; k--)
+        {
+            snprintf(from, sizeof(from), "%s.%d", LOG_FILE, k);
+            snprintf(to, sizeof(to), "%s.%d", LOG_FILE, k + 1);
+            rename(from, to);
+        }
+        snprintf(to, sizeof(to), "%s.1", LOG_FILE);
+        rename(LOG_FILE, to);
+    }
+    flock(log_writer.fd, LOCK_UN);
+    close(log_writer.fd);
+    log_writer.fd = open(LOG_FILE, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+}
 
-    // Handle variable arguments like printf
+static void log_write_out(void)
+{
+    if (log_writer.out_len == 0) return;
+    log_check_file(log_writer.out_len);
+    size_t done = 0;
+    while (log_writer.fd != -1 && done < log_writer.out_len)
+    {
+        ssize_t n = write(log_writer.fd, log_writer.out + done, log_writer.out_len - done);
+        if (n <= 0) break; // Can't log if file sys is broken
+        done += (size_t)n;
+    }
+    log_writer.out_len = 0;
+}
+
+// Appends one formatted line to the output buffer
+static void log_append(uint64_t ns, const char *process, const char *format, ...)
+{
+    if (sizeof(log_writer.out) - log_writer.out_len < LOG_TEXT_MAX + 128) log_write_out();
+
+    uint64_t wall = log_writer.real_base + (ns - log_writer.mono_base);
+    time_t sec = (time_t)(wall / 1000000000ULL);
+    if (sec != log_writer.cached_sec)
+    {
+        struct tm tm;
+        localtime_r(&sec, &tm);
+        strftime(log_writer.cached_date, sizeof(log_writer.cached_date), "%Y-%m-%d %H:%M:%S", &tm);
+        log_writer.cached_sec = sec;
+    }
+    char *dst = log_writer.out + log_writer.out_len;
+    size_t room = sizeof(log_writer.out) - log_writer.out_len;
+    int n = snprintf(dst, room, "[%s.%03u] [%s] ", log_writer.cached_date,
+                     (unsigned)((wall / 1000000ULL) % 1000), process);
     va_list args;
     va_start(args, format);
-    vfprintf(f, format, args);
+    n += vsnprintf(dst + n, room - n, format, args);
     va_end(args);
+    if ((size_t)n >= room - 1) n = (int)room - 2; // Truncated: still end the line
+    dst[n++] = '\n';
+    log_writer.out_len += (size_t)n;
+}
+
+static void log_report_repeats(void)
+{
+    if (log_writer.repeats == 0) return;
+    log_append(log_writer.repeat_last_ns, log_writer.last_process, "Last message repeated %llu times",
+               (unsigned long long)log_writer.repeats);
+    log_writer.repeats = 0;
+}
+
+// Moves every filled slot to the file; the caller holds log_drain_lock
+static void log_drain(void)
+{
+    if (log_needs_reset) return; // Forked child that never logged: those lines are the parent's
+    for (;;)
+    {
+        LogSlot *slot = &log_ring[log_tail & (LOG_RING_SLOTS - 1)];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != log_tail + 1) break;
+
+        // Consecutive identical lines of this process are held back and summarised
+        if (strcmp(slot->text, log_writer.last_text) == 0 && strcmp(slot->process, log_writer.last_process) == 0)
+        {
+            if (log_writer.repeats++ == 0) log_writer.repeat_since_ns = slot->ns;
+            log_writer.repeat_last_ns = slot->ns;
+        }
+        else
+        {
+            log_report_repeats();
+            log_append(slot->ns, slot->process, "%s", slot->text);
+            memcpy(log_writer.last_process, slot->process, LOG_NAME_MAX);
+            memcpy(log_writer.last_text, slot->text, LOG_TEXT_MAX);
+        }
+        atomic_store_explicit(&slot->seq, log_tail + LOG_RING_SLOTS, memory_order_release);
+        log_tail++;
+    }
+
+    // A long run of one message still shows up, once per LOG_REPEAT_REPORT_MS
+    uint64_t now = monotonic_ns();
+    if (log_writer.repeats > 0 && now - log_writer.repeat_since_ns >= LOG_REPEAT_REPORT_MS * 1000000ULL)
+    {
+        log_report_repeats();
+    }
+    uint64_t dropped = atomic_load(&log_dropped);
+    if (dropped != log_writer.dropped_reported)
+    {
+        log_append(now, "LOG", "Ring full: %llu message(s) dropped",
+                   (unsigned long long)(dropped - log_writer.dropped_reported));
+        log_writer.dropped_reported = dropped;
+    }
+    log_write_out();
+}
+
+void log_flush(void)
+{
+    pthread_mutex_lock(&log_drain_lock);
+    log_drain();
+    pthread_mutex_unlock(&log_drain_lock);
+}
+
+static void *log_flusher(void *arg)
+{
+    while (!atomic_load(&log_stopping))
+    {
+        struct timespec ts = { 0, LOG_FLUSH_MS * 1000000L };
+        syscall(SYS_futex, (uint32_t *)&log_wake, FUTEX_WAIT, 0, &ts, NULL, 0);
+        log_flush();
+    }
+    return NULL;
+}
+
+// At exit: stop the flusher and write out what is left; later messages are written inline
+static void log_shutdown(void)
+{
+    if (atomic_exchange(&log_state, LOG_THREAD_INLINE) == LOG_THREAD_RUNNING)
+    {
+        atomic_store(&log_stopping, 1);
+        syscall(SYS_futex, (uint32_t *)&log_wake, FUTEX_WAKE, 1, NULL, NULL, 0);
+        pthread_join(log_thread, NULL);
+    }
+    pthread_mutex_lock(&log_drain_lock);
+    log_drain();
+    if (!log_needs_reset)
+    {
+        log_report_repeats(); // Nothing else will end the run
+        log_write_out();
+    }
+    pthread_mutex_unlock(&log_drain_lock);
+}
+
+// A forked child has no flusher and the parent's ring; it starts over on its first message
+static void log_after_fork(void)
+{
+    pthread_mutex_init(&log_drain_lock, NULL);
+    atomic_store(&log_state, LOG_THREAD_NONE);
+    atomic_store(&log_stopping, 0);
+    log_needs_reset = 1;
+}
+
+static void log_init(void)
+{
+    log_reset_ring();
+    struct timespec real;
+    clock_gettime(CLOCK_REALTIME, &real);
+    log_writer.mono_base = monotonic_ns();
+    log_writer.real_base = (uint64_t)real.tv_sec * 1000000000ULL + (uint64_t)real.tv_nsec;
+    log_writer.cached_sec = -1;
+    atexit(log_shutdown);
+    pthread_atfork(NULL, NULL, log_after_fork);
+}
+
+static void log_start(void)
+{
+    int expected = LOG_THREAD_NONE;
+    if (!atomic_compare_exchange_strong(&log_state, &expected, LOG_THREAD_STARTING)) return;
+    if (log_needs_reset)
+    {
+        log_reset_ring();
+        log_needs_reset = 0;
+    }
+
+    // The flusher never takes signals: the handlers keep running on the threads that expect them
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int rc = pthread_create(&log_thread, NULL, log_flusher, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    atomic_store(&log_state, rc == 0 ? LOG_THREAD_RUNNING : LOG_THREAD_INLINE);
+}
+
+// Costs a vsnprintf into the ring: no lock, no syscall on the caller's path
+void log_msg(const char *process_name, const char *format, ...)
+{
+    pthread_once(&log_once, log_init);
+    int state = atomic_load_explicit(&log_state, memory_order_acquire);
+    if (state == LOG_THREAD_NONE) log_start();
+
+    size_t pos = atomic_load_explicit(&log_head, memory_order_relaxed);
+    LogSlot *slot;
+    for (;;)
+    {
+        slot = &log_ring[pos & (LOG_RING_SLOTS - 1)];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&log_head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) break;
+        }
+        else if (diff < 0)
+        {
+            // Full: drop rather than stall the caller; the flusher reports the count
+            atomic_fetch_add_explicit(&log_dropped, 1, memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&log_head, memory_order_relaxed);
+        }
+    }
+
+    slot->ns = monotonic_ns();
+    strncpy(slot->process, process_name, LOG_NAME_MAX - 1);
+    slot->process[LOG_NAME_MAX - 1] = '\0';
+    va_list args;
+    va_start(args, format);
+    vsnprintf(slot->text, LOG_TEXT_MAX, format, args);
+    va_end(args);
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+    // Wake the flusher early only when a quarter of the ring went by since the last wake
+    if (state == LOG_THREAD_INLINE) log_flush();
+    else if ((pos & (LOG_RING_SLOTS / 4 - 1)) == LOG_RING_SLOTS / 4 - 1)
+    {
+        syscall(SYS_futex, (uint32_t *)&log_wake, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+}
+
+uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// RANDOM STREAMS (PCG32, XSH-RR)
+void rng_seed(Rng *rng, uint64_t seed, uint64_t stream)
+{
+    rng->state = 0;
+    rng->inc = (stream << 1) | 1u;
+    rng_next(rng);
+    rng->state += seed;
+    rng_next(rng);
+}
+
+uint32_t rng_next(Rng *rng)
+{
+    uint64_t old = rng->state;
+    rng->state = old * 6364136223846793005ULL + rng->inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+int rng_below(Rng *rng, int bound)
+{
+    // Rejecting the top sliver keeps every value equally likely
+    uint32_t limit = (uint32_t)(-(uint32_t)bound) % (uint32_t)bound;
+    uint32_t r;
+    do r = rng_next(rng); while (r < limit);
+    return (int)(r % (uint32_t)bound);
+}
+
+uint64_t rng_seed_or_clock(uint64_t seed)
+{
+    if (seed != 0) return seed;
+    static _Atomic uint64_t calls;
+    return monotonic_ns() ^ ((uint64_t)getpid() << 32) ^ (atomic_fetch_add(&calls, 1) * 0x9E3779B97F4A7C15ULL);
+}
+
+// NETWORK FRAMES
+// Byte by byte, so the layout does not depend on struct padding or the host's byte order
+
+static void put_le(uint8_t *p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t get_le(const uint8_t *p, int bytes)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static void put_f32(uint8_t *p, float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    put_le(p, bits, 4);
+}
+
+static float get_f32(const uint8_t *p)
+{
+    uint32_t bits = (uint32_t)get_le(p, 4);
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+void net_frame_encode(const NetStateFrame *frame, uint8_t out[NET_FRAME_BYTES])
+{
+    put_le(out, NET_MAGIC, 2);
+    out[2] = frame->type;
+    out[3] = frame->drone;
+    put_le(out + 4, frame->seq, 4);
+    put_le(out + 8, frame->sent_ns, 8);
+    put_f32(out + 16, frame->x);
+    put_f32(out + 20, frame->y);
+    put_f32(out + 24, frame->vx);
+    put_f32(out + 28, frame->vy);
+}
+
+int net_frame_decode(const uint8_t in[NET_FRAME_BYTES], NetStateFrame *frame)
+{
+    if (get_le(in, 2) != NET_MAGIC || in[2] < NET_STATE || in[2] > NET_ACK) return -1;
+    frame->type = in[2];
+    frame->drone = in[3];
+    frame->seq = (uint32_t)get_le(in + 4, 4);
+    frame->sent_ns = get_le(in + 8, 8);
+    frame->x = get_f32(in + 16);
+    frame->y = get_f32(in + 20);
+    frame->vx = get_f32(in + 24);
+    frame->vy = get_f32(in + 28);
+    return 0;
+}
+
+int net_seq_newer(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) > 0;
+}
+
+void net_udp_header_encode(uint8_t out[NET_UDP_HEADER_BYTES], int count, uint32_t token)
+{
+    put_le(out, NET_UDP_MAGIC, 2);
+    out[2] = (uint8_t)count;
+    out[3] = 0;
+    put_le(out + 4, token, 4);
+}
+
+int net_udp_header_decode(const uint8_t *in, size_t len, uint32_t *token)
+{
+    if (len < NET_UDP_HEADER_BYTES || get_le(in, 2) != NET_UDP_MAGIC) return -1;
+    int count = in[2];
+    if (count > NET_UDP_MAX_FRAMES || len < NET_UDP_HEADER_BYTES + (size_t)count * NET_FRAME_BYTES) return -1;
+    *token = (uint32_t)get_le(in + 4, 4);
+    return count;
+}
+
+// SNAPSHOT CODEC
+#define SNAP_X_MAX (MAP_WIDTH * NET_SNAP_POS_SCALE - 1)
+#define SNAP_Y_MAX (MAP_HEIGHT * NET_SNAP_POS_SCALE - 1)
+#define SNAP_V_OFFSET (NET_SNAP_VEL_MAX * NET_SNAP_VEL_SCALE) // Velocities go on the wire as v + offset
+
+static int bits_for(uint32_t max)
+{
+    int bits = 0;
+    while (bits < 32 && (max >> bits) != 0) bits++;
+    return bits;
+}
+
+static int quantize(float value, int scale, int lo, int hi)
+{
+    float scaled = value * scale;
+    if (!(scaled > lo)) return lo; // NaN too
+    if (scaled >= hi) return hi;
+    return (int)(scaled + (scaled >= 0 ? 0.5f : -0.5f));
+}
+
+static int snap_has(const NetSnapshot *snap, int id)
+{
+    return (snap->present[id >> 3] >> (id & 7)) & 1;
+}
+
+void net_snap_clear(NetSnapshot *snap, uint32_t tick)
+{
+    snap->tick = tick;
+    memset(snap->present, 0, sizeof(snap->present));
+}
+
+void net_snap_set(NetSnapshot *snap, int id, float x, float y, float vx, float vy)
+{
+    NetSnapEntity *e = &snap->entities[id];
+    e->x = (uint16_t)quantize(x, NET_SNAP_POS_SCALE, 0, SNAP_X_MAX);
+    e->y = (uint16_t)quantize(y, NET_SNAP_POS_SCALE, 0, SNAP_Y_MAX);
+    e->vx = (int16_t)quantize(vx, NET_SNAP_VEL_SCALE, -SNAP_V_OFFSET, SNAP_V_OFFSET - 1);
+    e->vy = (int16_t)quantize(vy, NET_SNAP_VEL_SCALE, -SNAP_V_OFFSET, SNAP_V_OFFSET - 1);
+    snap->present[id >> 3] |= (uint8_t)(1u << (id & 7));
+}
+
+int net_snap_get(const NetSnapshot *snap, int id, float *x, float *y, float *vx, float *vy)
+{
+    if (!snap_has(snap, id)) return 0;
+    const NetSnapEntity *e = &snap->entities[id];
+    *x = (float)e->x / NET_SNAP_POS_SCALE;
+    *y = (float)e->y / NET_SNAP_POS_SCALE;
+    *vx = (float)e->vx / NET_SNAP_VEL_SCALE;
+    *vy = (float)e->vy / NET_SNAP_VEL_SCALE;
+    return 1;
+}
+
+// Bit stream, LSB first, through a 64-bit accumulator
+typedef struct {
+    uint8_t *out;
+    int len;
+    uint64_t acc;
+    int n;
+} BitWriter;
+
+typedef struct {
+    const uint8_t *in;
+    int len, pos;
+    uint64_t acc;
+    int n;
+} BitReader;
+
+static void put_bits(BitWriter *w, uint32_t value, int bits)
+{
+    w->acc |= (uint64_t)(value & ((1u << bits) - 1)) << w->n;
+    w->n += bits;
+    while (w->n >= 8)
+    {
+        w->out[w->len++] = (uint8_t)w->acc;
+        w->acc >>= 8;
+        w->n -= 8;
+    }
+}
+
+static int get_bits(BitReader *r, int bits, uint32_t *value)
+{
+    while (r->n < bits)
+    {
+        if (r->pos == r->len) return -1;
+        r->acc |= (uint64_t)r->in[r->pos++] << r->n;
+        r->n += 8;
+    }
+    *value = (uint32_t)(r->acc & ((1ull << bits) - 1));
+    r->acc >>= bits;
+    r->n -= bits;
+    return 0;
+}
+
+// Both components as small deltas from the reference when they fit, else absolute
+static void put_pair(BitWriter *w, int a, int b, int ref_a, int ref_b, int offset, int bits_a, int bits_b)
+{
+    int half = 1 << (NET_SNAP_DELTA_BITS - 1);
+    int da = a - ref_a, db = b - ref_b;
+    int small = da >= -half && da < half && db >= -half && db < half;
+    put_bits(w, (uint32_t)small, 1);
+    if (small)
+    {
+        put_bits(w, (uint32_t)(da + half), NET_SNAP_DELTA_BITS);
+        put_bits(w, (uint32_t)(db + half), NET_SNAP_DELTA_BITS);
+        return;
+    }
+    put_bits(w, (uint32_t)(a + offset), bits_a);
+    put_bits(w, (uint32_t)(b + offset), bits_b);
+}
+
+static int get_pair(BitReader *r, int *a, int *b, int offset, int bits_a, int bits_b)
+{
+    int half = 1 << (NET_SNAP_DELTA_BITS - 1);
+    uint32_t small, va, vb;
+    if (get_bits(r, 1, &small) == -1) return -1;
+    if (small)
+    {
+        if (get_bits(r, NET_SNAP_DELTA_BITS, &va) == -1 || get_bits(r, NET_SNAP_DELTA_BITS, &vb) == -1) return -1;
+        *a += (int)va - half; // *a and *b come in as the reference
+        *b += (int)vb - half;
+        return 0;
+    }
+    if (get_bits(r, bits_a, &va) == -1 || get_bits(r, bits_b, &vb) == -1) return -1;
+    *a = (int)va - offset;
+    *b = (int)vb - offset;
+    return 0;
+}
+
+int net_snap_encode(const NetSnapshot *cur, const NetSnapshot *base, int skip, uint8_t *out, int *entries)
+{
+    static const NetSnapEntity zero;
+    int bits_x = bits_for(SNAP_X_MAX), bits_y = bits_for(SNAP_Y_MAX), bits_v = bits_for(2 * SNAP_V_OFFSET - 1);
+    BitWriter w = { out, NET_SNAP_HEADER_BYTES, 0, 0 };
+    *entries = 0;
+
+    for (int id = 0; id < NET_SNAP_ENTITIES; id++)
+    {
+        if (id == skip) continue;
+        int now = snap_has(cur, id), before = base != NULL && snap_has(base, id);
+        if (!now && !before) continue;
+        if (!now)
+        {
+            put_bits(&w, (uint32_t)id, 8);
+            put_bits(&w, 1, 1); // Removed
+            (*entries)++;
+            continue;
+        }
+        const NetSnapEntity *e = &cur->entities[id];
+        const NetSnapEntity *ref = before ? &base->entities[id] : &zero;
+        int pos = e->x != ref->x || e->y != ref->y;
+        int vel = e->vx != ref->vx || e->vy != ref->vy;
+        if (before && !pos && !vel) continue;
+        put_bits(&w, (uint32_t)id, 8);
+        put_bits(&w, 0, 1);
+        put_bits(&w, (uint32_t)pos, 1);
+        put_bits(&w, (uint32_t)vel, 1);
+        if (pos) put_pair(&w, e->x, e->y, ref->x, ref->y, 0, bits_x, bits_y);
+        if (vel) put_pair(&w, e->vx, e->vy, ref->vx, ref->vy, SNAP_V_OFFSET, bits_v, bits_v);
+        (*entries)++;
+    }
+    if (w.n > 0) out[w.len++] = (uint8_t)w.acc; // An entry takes more than the 7 padding bits can hold
+
+    put_le(out, NET_SNAP_MAGIC, 2);
+    put_le(out + 2, (uint64_t)w.len, 2);
+    put_le(out + 4, cur->tick, 4);
+    put_le(out + 8, base != NULL ? base->tick : 0, 4);
+    return w.len;
+}
+
+int net_snap_header(const uint8_t *in, uint32_t *tick, uint32_t *baseline)
+{
+    if (get_le(in, 2) != NET_SNAP_MAGIC) return -1;
+    int len = (int)get_le(in + 2, 2);
+    if (len < NET_SNAP_HEADER_BYTES || len > NET_SNAP_MAX_BYTES) return -1;
+    *tick = (uint32_t)get_le(in + 4, 4);
+    *baseline = (uint32_t)get_le(in + 8, 4);
+    return len;
+}
+
+int net_snap_decode(const uint8_t *in, int len, const NetSnapshot *base, NetSnapshot *out)
+{
+    int bits_x = bits_for(SNAP_X_MAX), bits_y = bits_for(SNAP_Y_MAX), bits_v = bits_for(2 * SNAP_V_OFFSET - 1);
+    uint32_t tick, baseline;
+    if (len < NET_SNAP_HEADER_BYTES || net_snap_header(in, &tick, &baseline) != len) return -1;
+    if ((base == NULL) != (baseline == 0) || (base != NULL && base->tick != baseline)) return -1;
+    if (base != NULL) *out = *base;
+    else memset(out, 0, sizeof(*out));
+    out->tick = tick;
+
+    BitReader r = { in, len, NET_SNAP_HEADER_BYTES, 0, 0 };
+    while ((r.len - r.pos) * 8 + r.n > 7) // Whatever is left past the last entry is padding
+    {
+        uint32_t id, removed, pos, vel;
+        if (get_bits(&r, 8, &id) == -1 || get_bits(&r, 1, &removed) == -1) return -1;
+        if (removed)
+        {
+            out->present[id >> 3] &= (uint8_t)~(1u << (id & 7));
+            continue;
+        }
+        if (get_bits(&r, 1, &pos) == -1 || get_bits(&r, 1, &vel) == -1) return -1;
+        NetSnapEntity *e = &out->entities[id];
+        if (!snap_has(out, id)) memset(e, 0, sizeof(*e)); // New to the receiver: measured from zero
+        int a = e->x, b = e->y;
+        if (pos && get_pair(&r, &a, &b, 0, bits_x, bits_y) == -1) return -1;
+        if (a < 0 || a > SNAP_X_MAX || b < 0 || b > SNAP_Y_MAX) return -1;
+        e->x = (uint16_t)a;
+        e->y = (uint16_t)b;
+        a = e->vx;
+        b = e->vy;
+        if (vel && get_pair(&r, &a, &b, SNAP_V_OFFSET, bits_v, bits_v) == -1) return -1;
+        if (a < -SNAP_V_OFFSET || a >= SNAP_V_OFFSET || b < -SNAP_V_OFFSET || b >= SNAP_V_OFFSET) return -1;
+        e->vx = (int16_t)a;
+        e->vy = (int16_t)b;
+        out->present[id >> 3] |= (uint8_t)(1u << (id & 7));
+    }
+    return 0;
+}
+
+// WORLD STORAGE
+
+int world_alloc(WorldState *world, int max_obstacles, int max_targets, int max_agents)
+{
+    memset(world, 0, sizeof(WorldState));
+    size_t obstacle_bytes = (size_t)max_obstacles * sizeof(Obstacle);
+    size_t target_bytes = (size_t)max_targets * sizeof(Target);
+    size_t agent_bytes = (size_t)max_agents * sizeof(DroneState);
+    size_t link_bytes = (size_t)max_obstacles * sizeof(GridLink);
+    size_t column_bytes = (size_t)OBSTACLE_COLUMN_LEN(max_obstacles) * sizeof(float);
+    void *mem = calloc(1, agent_bytes + obstacle_bytes + target_bytes + link_bytes + 3 * column_bytes + 1);
+    if (mem == NULL) return -1;
+
+    // Agents first: DroneState needs the strictest alignment
+    char *p = (char *)mem;
+    world->agents = (DroneState *)p;                 p += agent_bytes;
+    world->obstacles = (Obstacle *)p;                p += obstacle_bytes;
+    world->targets = (Target *)p;                    p += target_bytes;
+    world->grid.links = (GridLink *)p;               p += link_bytes;
+    world->cols.x = (float *)p;                      p += column_bytes;
+    world->cols.y = (float *)p;                      p += column_bytes;
+    world->cols.mask = (uint32_t *)p; // calloc: every slot starts inactive
+    world->max_obstacles = max_obstacles;
+    world->max_targets = max_targets;
+    world->max_agents = max_agents;
+    grid_clear(&world->grid, max_obstacles);
+    return 0;
+}
+
+void world_free(WorldState *world)
+{
+    free(world->agents); // Owns the obstacle and target arrays, the grid links and the columns too
+    world->agents = NULL;
+    world->obstacles = NULL;
+    world->targets = NULL;
+    world->grid.links = NULL;
+    memset(&world->cols, 0, sizeof(ObstacleColumns));
+    world->max_obstacles = world->max_targets = world->max_agents = 0;
+}
+
+void world_set_obstacles(WorldState *world, const Obstacle *incoming, int n)
+{
+    if (n < 0) n = 0;
+    if (n > world->max_obstacles) n = world->max_obstacles;
+    int span = (n > world->n_obstacles) ? n : world->n_obstacles;
+
+    for (int i = 0; i < span; i++)
+    {
+        Obstacle next = {0};
+        if (i < n) memcpy(&next, &incoming[i], sizeof(Obstacle)); // Payloads may be unaligned
+        Obstacle *slot = &world->obstacles[i];
+        int was_active = (i < world->n_obstacles) && slot->active;
+
+        if (was_active && next.active && slot->x == next.x && slot->y == next.y)
+        {
+            slot->timer = next.timer; // Same place: the grid is already right
+            continue;
+        }
+        if (was_active) grid_remove(&world->grid, i);         // Expired or moved
+        if (next.active) grid_insert(&world->grid, i, next.x, next.y); // Spawned or moved
+        *slot = next;
+        world->cols.x[i] = (float)next.x;
+        world->cols.y[i] = (float)next.y;
+        world->cols.mask[i] = next.active ? 0xFFFFFFFFu : 0;
+    }
+    world->n_obstacles = n;
+}
+
+// OBSTACLE GRID
+
+int grid_cell(double x, double y)
+{
+    int col = (int)(x / GRID_CELL_SIZE);
+    int row = (int)(y / GRID_CELL_SIZE);
+    if (col < 0) col = 0;
+    if (col >= GRID_COLS) col = GRID_COLS - 1;
+    if (row < 0) row = 0;
+    if (row >= GRID_ROWS) row = GRID_ROWS - 1;
+    return row * GRID_COLS + col;
+}
+
+void grid_clear(ObstacleGrid *grid, int capacity)
+{
+    for (int c = 0; c < GRID_CELLS; c++) grid->head[c] = -1;
+    for (int i = 0; i < capacity; i++)
+    {
+        grid->links[i].next = grid->links[i].prev = -1;
+        grid->links[i].cell = -1;
+    }
+}
+
+void grid_insert(ObstacleGrid *grid, int slot, double x, double y)
+{
+    int cell = grid_cell(x, y);
+    GridLink *link = &grid->links[slot];
+    link->cell = cell;
+    link->prev = -1;
+    link->next = grid->head[cell];
+    if (link->next >= 0) grid->links[link->next].prev = slot;
+    grid->head[cell] = slot;
+}
+
+void grid_remove(ObstacleGrid *grid, int slot)
+{
+    GridLink *link = &grid->links[slot];
+    if (link->cell < 0) return; // Not filed
+
+    if (link->prev >= 0) grid->links[link->prev].next = link->next;
+    else grid->head[link->cell] = link->next;
+    if (link->next >= 0) grid->links[link->next].prev = link->prev;
+
+    link->next = link->prev = -1;
+    link->cell = -1;
+}
+
+// FRAMED PIPE MESSAGES
+
+static FrameRing *link_ring(int fd);
+static int ring_push(FrameRing *ring, const struct iovec *iov, int count);
+static ssize_t ring_fill(FrameRing *ring, unsigned char *dst, size_t room);
+
+void frame_writer_init(FrameWriter *writer, int fd)
+{
+    writer->fd = fd;
+    writer->seq = 0;
+    writer->ring = link_ring(fd);
+}
+
+int frame_send(FrameWriter *writer, uint16_t type, const void *payload, uint32_t length)
+{
+    FrameHeader header = {
+        .magic = FRAME_MAGIC,
+        .type = type,
+        .seq = ++writer->seq,
+        .timestamp_ns = monotonic_ns(),
+        .length = length,
+        .reserved = 0
+    };
+    struct iovec iov[2] = {
+        { &header, sizeof(header) },
+        { (void *)payload, length }
+    };
+    size_t total = sizeof(header) + length;
+    if (writer->ring) return ring_push(writer->ring, iov, payload ? 2 : 1);
+
+    // Up to PIPE_BUF the kernel writes the frame atomically; larger frames
+    // (or a non-blocking fd that filled up) are finished piece by piece
+    ssize_t n = writev(writer->fd, iov, payload ? 2 : 1);
+    if (n == -1) return -1;
+
+    size_t done = (size_t)n;
+    while (done < total)
+    {
+        const unsigned char *src;
+        size_t left;
+        if (done < sizeof(header))
+        {
+            src = (const unsigned char *)&header + done;
+            left = sizeof(header) - done;
+        }
+        else
+        {
+            src = (const unsigned char *)payload + (done - sizeof(header));
+            left = total - done;
+        }
+
+        n = write(writer->fd, src, left);
+        if (n == -1)
+        {
+            if (errno != EAGAIN && errno != EINTR) return -1;
+            struct pollfd pfd = { writer->fd, POLLOUT, 0 };
+            poll(&pfd, 1, 100);
+            continue;
+        }
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+// Room for two of the largest frames, so one can be parsed while the next arrives
+size_t frame_buffer_size(size_t max_payload)
+{
+    size_t needed = 2 * (sizeof(FrameHeader) + max_payload);
+    return needed > FRAME_BUFFER_CAP ? needed : FRAME_BUFFER_CAP;
+}
+
+int frame_reader_init(FrameReader *reader, int fd, size_t capacity)
+{
+    memset(reader, 0, sizeof(FrameReader));
+    reader->fd = fd;
+    reader->ring = link_ring(fd);
+    reader->cap = capacity;
+    reader->buf = malloc(capacity);
+    return reader->buf ? 0 : -1;
+}
+
+void frame_reader_free(FrameReader *reader)
+{
+    free(reader->buf);
+    reader->buf = NULL;
+}
+
+ssize_t frame_fill(FrameReader *reader)
+{
+    // Move the partial frame (if any) to the front so the read gets all the free space
+    if (reader->start > 0)
+    {
+        memmove(reader->buf, reader->buf + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    if (reader->end == reader->cap)
+    {
+        // A frame larger than the whole buffer can never complete: drop it
+        log_msg("FRAME", "Reader buffer (%zu bytes) overflowed, discarding", reader->cap);
+        reader->end = 0;
+        reader->resyncs++;
+    }
+    ssize_t n = reader->ring ? ring_fill(reader->ring, reader->buf + reader->end, reader->cap - reader->end)
+                             : read(reader->fd, reader->buf + reader->end, reader->cap - reader->end);
+    if (n > 0) reader->end += (size_t)n;
+    return n;
+}
+
+int frame_next(FrameReader *reader, FrameHeader *header, const void **payload)
+{
+    while (reader->end - reader->start >= sizeof(FrameHeader))
+    {
+        memcpy(header, reader->buf + reader->start, sizeof(FrameHeader));
+        if (header->magic != FRAME_MAGIC)
+        {
+            // Lost sync (should never happen on a pipe): skip a byte and look again
+            reader->start++;
+            reader->resyncs++;
+            continue;
+        }
+        if (reader->end - reader->start < sizeof(FrameHeader) + header->length) return 0;
+
+        *payload = reader->buf + reader->start + sizeof(FrameHeader);
+        reader->start += sizeof(FrameHeader) + header->length;
+        reader->last_seq = header->seq;
+        return 1;
+    }
+    return 0;
+}
+
+// IN-PROCESS LINKS
+// Producer and consumer each own one counter (head / tail, never wrapped, on their
+// own cache lines) and only read the other's, so no lock is needed. The consumer
+// is only woken through the eventfd when the ring was empty before a push.
+
+typedef struct {
+    char path[100];
+    FrameRing *ring;
+    int reader_fd, writer_fd;   // -1 until that end is opened
+} RingLink;
+
+static RingLink ring_links[MAX_RING_LINKS];
+static int n_ring_links = 0;
+static pthread_mutex_t ring_links_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local int subsystem_thread = 0;
+
+void subsystem_mark_thread(void)
+{
+    subsystem_thread = 1;
+}
+
+int subsystem_is_thread(void)
+{
+    return subsystem_thread;
+}
+
+int link_register(const char *path, size_t capacity)
+{
+    size_t cap = 4096;
+    while (cap < capacity) cap <<= 1;
+
+    FrameRing *ring = aligned_alloc(CACHE_LINE_SIZE, sizeof(FrameRing));
+    if (ring == NULL) return -1;
+    memset(ring, 0, sizeof(FrameRing));
+    ring->cap = cap;
+    ring->buf = malloc(cap);
+    ring->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ring->buf == NULL || ring->notify_fd == -1)
+    {
+        if (ring->notify_fd != -1) close(ring->notify_fd);
+        free(ring->buf);
+        free(ring);
+        return -1;
+    }
+
+    pthread_mutex_lock(&ring_links_lock);
+    if (n_ring_links == MAX_RING_LINKS)
+    {
+        pthread_mutex_unlock(&ring_links_lock);
+        close(ring->notify_fd);
+        free(ring->buf);
+        free(ring);
+        errno = ENOSPC;
+        return -1;
+    }
+    RingLink *link = &ring_links[n_ring_links++];
+    snprintf(link->path, sizeof(link->path), "%s", path);
+    link->ring = ring;
+    link->reader_fd = link->writer_fd = -1;
+    pthread_mutex_unlock(&ring_links_lock);
+    return 0;
+}
+
+int link_open(const char *path, int flags)
+{
+    pthread_mutex_lock(&ring_links_lock);
+    for (int i = 0; i < n_ring_links; i++)
+    {
+        RingLink *link = &ring_links[i];
+        if (strcmp(link->path, path) != 0) continue;
+
+        // Each end is its own descriptor of the eventfd, so link_close() knows which side left
+        int fd = dup(link->ring->notify_fd);
+        if (fd != -1)
+        {
+            // Reopening an end starts over, like a FIFO that both sides reopen
+            if ((flags & O_ACCMODE) == O_WRONLY)
+            {
+                link->writer_fd = fd;
+                atomic_store(&link->ring->writer_closed, 0);
+            }
+            else
+            {
+                link->reader_fd = fd;
+                link->ring->reader_writes = ((flags & O_ACCMODE) == O_RDWR);
+                atomic_store(&link->ring->reader_closed, 0);
+                atomic_store(&link->ring->writer_closed, 0);
+            }
+        }
+        pthread_mutex_unlock(&ring_links_lock);
+        return fd;
+    }
+    pthread_mutex_unlock(&ring_links_lock);
+    return open(path, flags);
+}
+
+int link_close(int fd)
+{
+    pthread_mutex_lock(&ring_links_lock);
+    for (int i = 0; i < n_ring_links; i++)
+    {
+        RingLink *link = &ring_links[i];
+        if (fd == link->writer_fd)
+        {
+            atomic_store(&link->ring->writer_closed, 1);
+            link->writer_fd = -1;
+            uint64_t one = 1;
+            if (write(link->ring->notify_fd, &one, sizeof(one)) == -1) { /* Counter full: already readable */ }
+        }
+        else if (fd == link->reader_fd)
+        {
+            atomic_store(&link->ring->reader_closed, 1); // A blocked producer gets EPIPE
+            link->reader_fd = -1;
+        }
+    }
+    pthread_mutex_unlock(&ring_links_lock);
+    return close(fd);
+}
+
+static FrameRing *link_ring(int fd)
+{
+    FrameRing *ring = NULL;
+    if (fd < 0) return NULL;
+    pthread_mutex_lock(&ring_links_lock);
+    for (int i = 0; i < n_ring_links; i++)
+    {
+        if (fd == ring_links[i].reader_fd || fd == ring_links[i].writer_fd) ring = ring_links[i].ring;
+    }
+    pthread_mutex_unlock(&ring_links_lock);
+    return ring;
+}
+
+// Whole frames only: waits for room like a blocking pipe write
+static int ring_push(FrameRing *ring, const struct iovec *iov, int count)
+{
+    size_t total = 0;
+    for (int i = 0; i < count; i++) total += iov[i].iov_len;
+    if (total > ring->cap) { errno = EMSGSIZE; return -1; }
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    while (head + total - atomic_load_explicit(&ring->tail, memory_order_acquire) > ring->cap)
+    {
+        if (atomic_load(&ring->reader_closed)) { errno = EPIPE; return -1; }
+        sched_yield();
+    }
+    if (atomic_load(&ring->reader_closed)) { errno = EPIPE; return -1; }
+
+    uint64_t pos = head;
+    for (int i = 0; i < count; i++)
+    {
+        const unsigned char *src = iov[i].iov_base;
+        size_t len = iov[i].iov_len;
+        size_t at = pos & (ring->cap - 1);
+        size_t first = (len < ring->cap - at) ? len : ring->cap - at;
+        memcpy(ring->buf + at, src, first);
+        memcpy(ring->buf, src + first, len - first);
+        pos += len;
+    }
+    atomic_store_explicit(&ring->head, pos, memory_order_seq_cst);
+
+    // Pairs with the consumer's tail store + head load: one of the two sees the other,
+    // so either the consumer finds the frame or we wake it
+    if (atomic_load_explicit(&ring->tail, memory_order_seq_cst) == head)
+    {
+        uint64_t one = 1;
+        if (write(ring->notify_fd, &one, sizeof(one)) == -1) { /* Counter full: already readable */ }
+    }
+    return 0;
+}
+
+static ssize_t ring_copy_out(FrameRing *ring, unsigned char *dst, size_t room)
+{
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint64_t avail = atomic_load_explicit(&ring->head, memory_order_acquire) - tail;
+    size_t n = (avail < room) ? (size_t)avail : room;
+    if (n == 0) return 0;
+
+    size_t at = tail & (ring->cap - 1);
+    size_t first = (n < ring->cap - at) ? n : ring->cap - at;
+    memcpy(dst, ring->buf + at, first);
+    memcpy(dst + first, ring->buf, n - first);
+    atomic_store_explicit(&ring->tail, tail + n, memory_order_seq_cst);
+    return (ssize_t)n;
+}
+
+// Same contract as read() on a non-blocking pipe: >0 bytes, 0 at EOF, -1/EAGAIN when empty
+static ssize_t ring_fill(FrameRing *ring, unsigned char *dst, size_t room)
+{
+    ssize_t n = ring_copy_out(ring, dst, room);
+    if (n > 0) return n;
+
+    // Empty: re-arm the eventfd, then look once more so a push in between is not missed
+    uint64_t count;
+    if (read(ring->notify_fd, &count, sizeof(count)) == -1) { /* Already clear */ }
+    n = ring_copy_out(ring, dst, room);
+    if (n > 0) return n;
+
+    if (atomic_load(&ring->writer_closed) && !ring->reader_writes) return 0;
+    errno = EAGAIN;
+    return -1;
+}
+
+// SHARED MEMORY BLACKBOARD
+
+// Busy-wait hint while the writer is inside its critical section
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static void board_name(char *dest, size_t len, const char *suffix)
+{
+    snprintf(dest, len, "%s%s", SHM_BOARD_NAME, suffix ? suffix : "");
+}
+
+// Bytes needed for the header plus every entity array
+static size_t board_size(int max_obstacles, int max_targets, int max_agents)
+{
+    return sizeof(SharedBoard) + (size_t)max_obstacles * (sizeof(Obstacle) + sizeof(GridLink))
+                               + (size_t)max_targets * sizeof(Target)
+                               + (size_t)OBSTACLE_COLUMN_LEN(max_obstacles) * 3 * sizeof(float)
+                               + (size_t)max_agents * sizeof(DroneState);
+}
+
+static SharedBoard *board_map(const char *suffix, int flags, size_t size)
+{
+    char name[100];
+    board_name(name, sizeof(name), suffix);
+
+    int fd = shm_open(name, flags, 0666);
+    if (fd == -1) return NULL;
+
+    if ((flags & O_CREAT) && ftruncate(fd, size) == -1)
+    {
+        close(fd);
+        return NULL;
+    }
+    if (size == 0)
+    {
+        // Attaching: the segment knows its own size
+        struct stat st;
+        if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(SharedBoard))
+        {
+            close(fd);
+            errno = EINVAL;
+            return NULL;
+        }
+        size = (size_t)st.st_size;
+    }
+
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the segment alive
+    if (mem == MAP_FAILED) return NULL;
+    return (SharedBoard *)mem;
+}
+
+// Create (or recreate) the segment and zero it
+SharedBoard *board_create(const char *suffix, int max_obstacles, int max_targets, int max_agents)
+{
+    size_t size = board_size(max_obstacles, max_targets, max_agents);
+    SharedBoard *board = board_map(suffix, O_CREAT | O_RDWR, size);
+    if (board == NULL) return NULL;
+    memset(board, 0, size);
+    board->max_obstacles = max_obstacles;
+    board->max_targets = max_targets;
+    board->max_agents = max_agents;
+    board->size = size;
+    return board;
+}
+
+SharedBoard *board_attach(const char *suffix)
+{
+    return board_map(suffix, O_RDWR, 0);
+}
+
+void board_detach(SharedBoard *board)
+{
+    if (board) munmap(board, board->size);
+}
+
+const Obstacle *board_obstacles(SharedBoard *board, int *count)
+{
+    if (count)
+    {
+        int n = board->world.n_obstacles;
+        *count = (n < 0) ? 0 : (n > board->max_obstacles ? board->max_obstacles : n);
+    }
+    return (const Obstacle *)(board + 1);
+}
+
+const Target *board_targets(SharedBoard *board, int *count)
+{
+    if (count)
+    {
+        int n = board->world.n_targets;
+        *count = (n < 0) ? 0 : (n > board->max_targets ? board->max_targets : n);
+    }
+    return (const Target *)((const Obstacle *)(board + 1) + board->max_obstacles);
+}
+
+// Obstacles and targets are 16 bytes each, so the agents stay aligned for their doubles
+const DroneState *board_agents(SharedBoard *board, int *count)
+{
+    if (count)
+    {
+        int n = board->world.n_agents;
+        *count = (n < 0) ? 0 : (n > board->max_agents ? board->max_agents : n);
+    }
+    return (const DroneState *)(board_targets(board, NULL) + board->max_targets);
+}
+
+const GridLink *board_grid_links(SharedBoard *board)
+{
+    return (const GridLink *)(board_agents(board, NULL) + board->max_agents);
+}
+
+ObstacleColumns board_columns(SharedBoard *board)
+{
+    int len = OBSTACLE_COLUMN_LEN(board->max_obstacles);
+    ObstacleColumns cols;
+    cols.x = (float *)(board_grid_links(board) + board->max_obstacles);
+    cols.y = cols.x + len;
+    cols.mask = (uint32_t *)(cols.y + len);
+    return cols;
+}
+
+// Seqlock write: readers that overlap with the copy will see a changed counter and retry
+void board_publish(SharedBoard *board, const WorldState *world)
+{
+    uint32_t seq = atomic_load_explicit(&board->seq, memory_order_relaxed);
+    atomic_store_explicit(&board->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    WorldState *dst = &board->world;
+    memcpy(dst, world, sizeof(WorldState));
+    dst->obstacles = NULL;
+    dst->targets = NULL;
+    dst->agents = NULL;
+    dst->grid.links = NULL;
+    memset(&dst->cols, 0, sizeof(ObstacleColumns));
+    dst->max_obstacles = board->max_obstacles;
+    dst->max_targets = board->max_targets;
+    dst->max_agents = board->max_agents;
+    if (dst->n_obstacles > board->max_obstacles) dst->n_obstacles = board->max_obstacles;
+    if (dst->n_targets > board->max_targets) dst->n_targets = board->max_targets;
+    if (dst->n_agents > board->max_agents) dst->n_agents = board->max_agents;
+    memcpy((Obstacle *)board_obstacles(board, NULL), world->obstacles, (size_t)dst->n_obstacles * sizeof(Obstacle));
+    memcpy((Target *)board_targets(board, NULL), world->targets, (size_t)dst->n_targets * sizeof(Target));
+    // Only slots below n_obstacles can be linked into the grid
+    memcpy((GridLink *)board_grid_links(board), world->grid.links, (size_t)dst->n_obstacles * sizeof(GridLink));
+    // Columns go out in whole vectors; the padding past n_obstacles is always inactive
+    ObstacleColumns cols = board_columns(board);
+    size_t column_bytes = (size_t)OBSTACLE_COLUMN_LEN(dst->n_obstacles) * sizeof(float);
+    memcpy(cols.x, world->cols.x, column_bytes);
+    memcpy(cols.y, world->cols.y, column_bytes);
+    memcpy(cols.mask, world->cols.mask, column_bytes);
+    memcpy((DroneState *)board_agents(board, NULL), world->agents, (size_t)dst->n_agents * sizeof(DroneState));
+
+    atomic_store_explicit(&board->seq, seq + 2, memory_order_seq_cst);
+
+    // Only pay for the syscall when somebody is actually asleep on the counter
+    if (atomic_load_explicit(&board->waiters, memory_order_seq_cst) > 0)
+    {
+        syscall(SYS_futex, (uint32_t *)&board->seq, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+    }
+}
+
+// Tell readers the server is gone and wake anyone blocked on the next frame
+void board_close(SharedBoard *board)
+{
+    atomic_store(&board->closed, 1);
+    atomic_fetch_add(&board->seq, 2);
+    syscall(SYS_futex, (uint32_t *)&board->seq, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+void board_destroy(SharedBoard *board, const char *suffix)
+{
+    char name[100];
+    board_name(name, sizeof(name), suffix);
+    board_detach(board);
+    shm_unlink(name);
+}
+
+// Returns an even sequence number; the caller reads board->world and then checks board_read_retry()
+uint32_t board_read_begin(SharedBoard *board)
+{
+    uint32_t seq;
+    while ((seq = atomic_load_explicit(&board->seq, memory_order_acquire)) & 1)
+    {
+        cpu_relax();
+    }
+    return seq;
+}
+
+// Non-zero if the server published while we were reading (the data may be torn)
+int board_read_retry(SharedBoard *board, uint32_t seq)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&board->seq, memory_order_relaxed) != seq;
+}
+
+uint32_t board_snapshot(SharedBoard *board, WorldState *out)
+{
+    // The caller's arrays (if any) survive the copy of the scalars
+    Obstacle *obstacles = out->obstacles;
+    Target *targets = out->targets;
+    DroneState *agents = out->agents;
+    GridLink *links = out->grid.links;
+    ObstacleColumns cols = out->cols;
+    int max_obstacles = out->max_obstacles;
+    int max_targets = out->max_targets;
+    int max_agents = out->max_agents;
+    uint32_t seq;
+    do
+    {
+        seq = board_read_begin(board);
+        memcpy(out, &board->world, sizeof(WorldState));
+
+        int n_obs, n_tar;
+        const Obstacle *src_obs = board_obstacles(board, &n_obs);
+        const Target *src_tar = board_targets(board, &n_tar);
+        if (n_obs > max_obstacles) n_obs = max_obstacles;
+        if (n_tar > max_targets) n_tar = max_targets;
+        if (n_obs > 0) memcpy(obstacles, src_obs, (size_t)n_obs * sizeof(Obstacle));
+        if (n_obs > 0)
+        {
+            memcpy(links, board_grid_links(board), (size_t)n_obs * sizeof(GridLink));
+            ObstacleColumns src_cols = board_columns(board);
+            size_t column_bytes = (size_t)OBSTACLE_COLUMN_LEN(n_obs) * sizeof(float);
+            memcpy(cols.x, src_cols.x, column_bytes);
+            memcpy(cols.y, src_cols.y, column_bytes);
+            memcpy(cols.mask, src_cols.mask, column_bytes);
+        }
+        if (n_tar > 0) memcpy(targets, src_tar, (size_t)n_tar * sizeof(Target));
+        int n_agents;
+        const DroneState *src_agents = board_agents(board, &n_agents);
+        if (n_agents > max_agents) n_agents = max_agents;
+        if (n_agents > 0) memcpy(agents, src_agents, (size_t)n_agents * sizeof(DroneState));
+        out->n_obstacles = n_obs;
+        out->n_targets = n_tar;
+        out->n_agents = n_agents;
+    } while (board_read_retry(board, seq));
+
+    out->obstacles = obstacles;
+    out->targets = targets;
+    out->agents = agents;
+    out->grid.links = links;
+    out->cols = cols;
+    out->max_obstacles = max_obstacles;
+    out->max_targets = max_targets;
+    out->max_agents = max_agents;
+    return seq;
+}
+
+int board_wait_update(SharedBoard *board, uint32_t last_seq, int timeout_ms)
+{
+    if (atomic_load(&board->seq) != last_seq) return 1;
+
+    struct timespec ts = { timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000L };
+    atomic_fetch_add(&board->waiters, 1);
+    // The kernel re-checks the counter, so a publish between the load and the wait is not lost
+    if (atomic_load(&board->seq) == last_seq)
+    {
+        syscall(SYS_futex, (uint32_t *)&board->seq, FUTEX_WAIT, last_seq, &ts, NULL, 0);
+    }
+    atomic_fetch_sub(&board->waiters, 1);
+
+    return atomic_load(&board->seq) != last_seq;
+}
+
+// STARTUP READINESS
+static const char *component_names[COMPONENT_COUNT] = {
+    "drone", "keyboard", "obstacles", "targets", "watchdog", "network", "server"
+};
+
+const char *component_name(Component component)
+{
+    return (component >= 0 && component < COMPONENT_COUNT) ? component_names[component] : "?";
+}
+
+void board_set_ready(SharedBoard *board, Component component)
+{
+    board->ready_ns[component] = monotonic_ns();
+    atomic_fetch_or(&board->ready, COMPONENT_BIT(component)); // Publishes the timestamp too
+    syscall(SYS_futex, (uint32_t *)&board->ready, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+int board_is_ready(SharedBoard *board, Component component)
+{
+    return (atomic_load(&board->ready) & COMPONENT_BIT(component)) != 0;
+}
+
+int board_wait_ready(SharedBoard *board, uint32_t mask, int timeout_ms)
+{
+    uint64_t deadline = monotonic_ns() + (uint64_t)timeout_ms * 1000000ULL;
+    for (;;)
+    {
+        uint32_t ready = atomic_load(&board->ready);
+        if ((ready & mask) == mask) return 1;
+
+        uint64_t now = monotonic_ns();
+        if (now >= deadline) return 0;
+        uint64_t left = deadline - now;
+        struct timespec ts = { (time_t)(left / 1000000000ULL), (long)(left % 1000000000ULL) };
+        // The kernel re-checks the word, so a child reporting in between is not lost
+        syscall(SYS_futex, (uint32_t *)&board->ready, FUTEX_WAIT, ready, &ts, NULL, 0);
+    }
+}
+
+// PROCESS HEARTBEATS
+void heartbeat_start(SharedBoard *board, Component component, uint64_t period_ns)
+{
+    Heartbeat *hb = &board->heartbeats[component];
+    hb->period_ns = period_ns;
+    atomic_store(&hb->last_ns, monotonic_ns());
+    atomic_store(&hb->running, 1);
+}
+
+// Timestamp first: a watchdog that sees the new count also sees its time
+void heartbeat_beat(SharedBoard *board, Component component)
+{
+    Heartbeat *hb = &board->heartbeats[component];
+    atomic_store_explicit(&hb->last_ns, monotonic_ns(), memory_order_relaxed);
+    atomic_fetch_add_explicit(&hb->beats, 1, memory_order_release);
+}
 
-    fprintf(f, "\n");
-    fclose(f);
-}
\ No newline at end of file
+void heartbeat_stop(SharedBoard *board, Component component)
+{
+    atomic_store(&board->heartbeats[component].running, 0);
+}
@@ -1,35 +1,47 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <stdint.h>
+#include <stdatomic.h>
+
 // MAP SETTINGS 
 #define MAP_WIDTH 80
 #define MAP_HEIGHT 24
 
 // LIMITS 
-#define MAX_OBSTACLES 10
-#define MAX_TARGETS 10
-#define TIMEOUT_SECONDS 4 // If no heartbeat for 4 seconds, kill system
+// Entity capacities are runtime parameters (MAX_OBSTACLES / MAX_TARGETS / DRONES in
+// param.conf); the server sizes the board with them and every other process reads them from it.
+#define DEFAULT_MAX_OBSTACLES 10
+#define DEFAULT_MAX_TARGETS 10
+#define DEFAULT_DRONES 1  // Drone 0 is the player, the others are agents
+#define ENTITY_CAPACITY_LIMIT 100000 // Largest capacity accepted from param.conf
+#define TIMEOUT_SECONDS 4 // If the server has not beaten for 4 seconds, kill system
 
 // GAME CONFIGURATION
 #define TOTAL_TARGETS_TO_WIN 10
 
 // NETWORK SETTINGS
-#define BUFFER_CAP 1024       
+#define BUFFER_CAP 4096 // Power of two (LinkContext ring); holds the largest snapshot
 #define SYNC_RATE_US 30000 
 #define RETRY_SEC 1
+#define NET_FRAME_BYTES 32   // One binary state frame (see NetStateFrame)
+#define NET_MAX_PEERS 255    // Session host: drone ids 1..255 on the wire, 0 is the host's own
+#define NET_TX_CAP (NET_FRAME_BYTES * (NET_MAX_PEERS + 1)) // Send queue: a frame for every drone
 
 // NETWORK PIPE DEFINITIONS
 // These specific paths ensure Blackboard and NetworkProcess find each other
 #define FIFO_NET_RX "/tmp/fifoObsBB"  // Network -> Blackboard (Remote Obstacles/Drone)
 #define FIFO_NET_TX "/tmp/fifoBBObs"  // Blackboard -> Network (Local Drone)
-#define RESIZE_FLAG 99
 
 //DATA STRUCTURES
 // KEYBOARD INPUT (Input Process -> Drone Process) 
+// Every drone has its own input stream; the streams share fifoKD and are told
+// apart by 'drone' (0 = the keyboard's drone). Only drone 0 may start, reset or quit.
 typedef struct {
     float force_x;    
     float force_y;    
     char command;   // 's', 'r', 'q', ' '
+    uint32_t drone; // Drone index the input is for
 } InputMsg;
 
 // SUB-COMPONENTS 
@@ -51,21 +63,205 @@ typedef struct {
     int value;      // For scoring
 } Target;
 
+// OBSTACLE GRID
+// Uniform spatial hash over the map. A cell is at least as wide as the repulsion
+// range (INFLUENCE_RANGE), so everything that can push the drone sits in the 3x3
+// cells around it. Slots are chained per cell through GridLink, so a spawn or an
+// expiry is an O(1) insert/remove.
+#define GRID_CELL_SIZE 3
+#define GRID_COLS ((MAP_WIDTH + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE)
+#define GRID_ROWS ((MAP_HEIGHT + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE)
+#define GRID_CELLS (GRID_COLS * GRID_ROWS)
+
+typedef struct {
+    int next, prev;   // Other slots in the same cell, -1 = none
+    int cell;         // Cell the slot is filed under, -1 = not in the grid
+} GridLink;
+
+typedef struct {
+    int head[GRID_CELLS];  // First slot of each cell, -1 = empty
+    GridLink *links;       // One per obstacle slot
+} ObstacleGrid;
+
+// OBSTACLE COLUMNS
+// Structure-of-arrays mirror of the obstacle slots for the vector repulsion kernels:
+// packed float coordinates and an all-ones/all-zeros active mask per slot. The
+// columns are padded to a multiple of OBSTACLE_LANES with inactive entries, so a
+// kernel can always process whole vectors.
+#define OBSTACLE_LANES 8
+#define OBSTACLE_COLUMN_LEN(n) (((n) + OBSTACLE_LANES - 1) / OBSTACLE_LANES * OBSTACLE_LANES)
+
+typedef struct {
+    float *x;
+    float *y;
+    uint32_t *mask;   // 0xFFFFFFFF = active, 0 = hole
+} ObstacleColumns;
+
 // Structure to send (Targets + Score gained this frame) to Server 
+// Packets are pipelined: 'tick' is the board frame the targets were computed for,
+// and the server consumes whatever is newest without waiting for a reply.
+// On the wire the header is followed by 'count' Target entries (the active ones).
 typedef struct {
-    Target targets[MAX_TARGETS];
     int score_increment;
+    uint32_t tick;
+    uint32_t count;
 } TargetPacket;
 
 // THE WORLD STATE (Master Process -> Display Process) 
+// The entity arrays are allocated once at startup (world_alloc) with the
+// configured capacities; only the first n_obstacles / n_targets are in use.
+// Obstacles keep the generator's slot numbering (inactive slots are holes) and
+// are indexed by 'grid' and mirrored in 'cols', which world_set_obstacles() keeps up to date.
+// 'drone' is the player (drone 0); the other drones of a multi-drone world are 'agents'.
 typedef struct {
     DroneState drone;
-    Obstacle obstacles[MAX_OBSTACLES];
-    Target targets[MAX_TARGETS];
     int score;
     int game_active; // 0=Paused, 1=Flying
+    uint32_t tick;   // Frame number, bumped by the server on every publish
+    int n_obstacles;
+    int n_targets;
+    int max_obstacles;
+    int max_targets;
+    int n_agents;
+    int max_agents;
+    Obstacle *obstacles;
+    Target *targets;
+    DroneState *agents;
+    ObstacleGrid grid;
+    ObstacleColumns cols;
 } WorldState;
 
+// FRAMED PIPE MESSAGES
+// Every FIFO carries frames: a fixed header followed by 'length' payload bytes.
+// Control signals have their own types instead of magic values inside the data,
+// and readers pull a whole burst with one read() and parse every frame in it.
+#define FRAME_MAGIC 0xD0E1
+#define FRAME_BUFFER_CAP (64 * 1024) // Minimum reader buffer (see frame_buffer_size)
+
+typedef enum {
+    MSG_INPUT = 1,     // InputMsg       Keyboard -> Drone, Drone -> Server (the player's applied input)
+    MSG_DRONE_STATE,   // DroneState     Drone -> Server, Server -> Network
+    MSG_QUIT,          // (no payload)   Drone -> Server
+    MSG_RESET,         // (no payload)   Drone -> Server
+    MSG_OBSTACLES,     // Obstacle[n]    Obstacles/Network -> Server (slots up to the last active one)
+    MSG_TARGETS,       // TargetPacket + Target[count]   Targets -> Server
+    MSG_RESIZE,        // ResizeMsg      Network -> Server (client window size)
+    MSG_AGENTS         // DroneState[n]  Drone -> Server (drones 1..n, after MSG_DRONE_STATE)
+} MsgType;
+
+typedef struct {
+    uint16_t magic;        // FRAME_MAGIC, lets a reader resynchronise
+    uint16_t type;         // MsgType
+    uint32_t seq;          // Per-link sequence number
+    uint64_t timestamp_ns; // CLOCK_MONOTONIC when sent
+    uint32_t length;       // Payload bytes after the header
+    uint32_t reserved;
+} FrameHeader;
+
+typedef struct {
+    int width, height;
+} ResizeMsg;
+
+// IN-PROCESS LINKS (threaded build)
+// Between two subsystems running as threads of one process a link is a lock-free
+// single-producer/single-consumer byte ring instead of a FIFO, carrying the same
+// frames. Both ends still get an fd: an eventfd that turns readable when the ring
+// goes from empty to non-empty, so the server's epoll reactor watches it like a pipe.
+#define MAX_RING_LINKS 8
+#define CACHE_LINE_SIZE 64
+
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t head; // Bytes ever written (producer only)
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t tail; // Bytes ever read (consumer only)
+    _Alignas(CACHE_LINE_SIZE) _Atomic int writer_closed;
+    _Atomic int reader_closed;
+    int reader_writes;      // Reader opened it O_RDWR: never reports EOF, like the FIFO
+    int notify_fd;          // eventfd shared by both ends
+    size_t cap;             // Power of two
+    unsigned char *buf;
+} FrameRing;
+
+typedef struct {
+    int fd;
+    uint32_t seq;
+    FrameRing *ring;      // In-process link, NULL for a pipe
+} FrameWriter;
+
+typedef struct {
+    int fd;
+    FrameRing *ring;      // In-process link, NULL for a pipe
+    unsigned char *buf;
+    size_t cap;
+    size_t start, end;    // Unparsed bytes are buf[start..end)
+    uint32_t last_seq;
+    unsigned long resyncs; // Times garbage had to be skipped
+} FrameReader;
+
+// SHARED MEMORY BLACKBOARD
+// The server publishes the WorldState here every tick; the drone, keyboard and
+// generators read it in place instead of receiving a copy through a pipe.
+#define SHM_BOARD_NAME "/drone_board"  // Suffixed like the FIFOs ("_server", "_client")
+#define BOARD_WAIT_MS 1000             // Max time a reader sleeps waiting for a new frame
+
+// STARTUP READINESS
+// The children come up in parallel: each one sets its bit in board->ready once its
+// links are open and it is attached, and the server waits (bounded) for every child it launched.
+#define STARTUP_TIMEOUT_MS 2000
+#define COMPONENT_BIT(c) (1u << (c))
+
+typedef enum {
+    COMPONENT_DRONE,
+    COMPONENT_KEYBOARD,
+    COMPONENT_OBSTACLES,
+    COMPONENT_TARGETS,
+    COMPONENT_WATCHDOG,
+    COMPONENT_NETWORK,
+    COMPONENT_SERVER,   // Heartbeats only; the server does not report ready to itself
+    COMPONENT_COUNT
+} Component;
+
+// PROCESS HEARTBEATS
+// Every process bumps its slot once per loop iteration and the watchdog polls the
+// table: a beat later than HEARTBEAT_MISS_FACTOR periods is a deadline miss, a
+// silence of HEARTBEAT_STALL_PERIODS periods a stall. One cache line per slot,
+// so the writers never share a line.
+#define HEARTBEAT_MISS_FACTOR 1.5
+#define HEARTBEAT_STALL_PERIODS 10
+
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t beats; // Loop iterations so far
+    _Atomic uint64_t last_ns;      // monotonic_ns() of the last beat
+    uint64_t period_ns;            // Expected time between beats
+    _Atomic int running;           // Set by heartbeat_start(), cleared by heartbeat_stop()
+    // Written by the watchdog
+    _Atomic uint64_t misses;
+    _Atomic uint64_t stalls;
+    _Atomic uint64_t worst_gap_ns; // Longest time between two beats
+} Heartbeat;
+
+// The segment is variable-sized: Obstacle[max_obstacles], Target[max_targets],
+// DroneState[max_agents], GridLink[max_obstacles] and the obstacle columns follow
+// the header. The pointer fields of 'world' are meaningless in shared memory, readers go
+// through board_obstacles() / board_targets() / board_grid_links() / board_columns() / board_agents().
+typedef struct {
+    // Seqlock counter: odd while the server is writing, even when the world is stable.
+    // It lives on its own cache line so reader polling never collides with the data.
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint32_t seq;
+    _Atomic int closed;     // Set by the server on shutdown
+    _Atomic int waiters;    // Readers sleeping in board_wait_update()
+    int max_obstacles;      // Capacities, fixed when the server creates the segment
+    int max_targets;
+    int max_agents;
+    size_t size;            // Bytes mapped
+    uint64_t tick_ns;       // Server tick period, the pace of every child that follows the board
+    uint64_t seed;          // SEED from param.conf for the children's random streams (0 = unseeded)
+    _Atomic uint32_t ready; // COMPONENT_BIT() of every child that finished starting up
+    uint64_t ready_ns[COMPONENT_COUNT]; // monotonic_ns() when each one did
+    Heartbeat heartbeats[COMPONENT_COUNT];
+
+    _Alignas(CACHE_LINE_SIZE) WorldState world;
+} SharedBoard;
+
 // NETWORK COMMUNICATION STRUCTURES
 
 // Operation Mode
@@ -82,13 +278,239 @@ typedef struct {
     int pipe_out_fd;  // Writes Remote Obstacle (fifoObsBB)
     int role; 
     
-    // Internal Buffer State
+    // Receive ring: bytes buf_start..buf_end are unread. Both only grow and wrap
+    // with the counter; index the buffer with '& (BUFFER_CAP - 1)'
     char net_buffer[BUFFER_CAP];
-    int buf_start;
-    int buf_end;
+    uint32_t buf_start;
+    uint32_t buf_end;
+
+    // Send queue: bytes the non-blocking socket has not taken yet
+    char tx_buffer[NET_TX_CAP];
+    int tx_len;
 } LinkContext;
 
-// Log function that appends to a file
+// BINARY STATE PROTOCOL
+// Negotiated in the text handshake: a client that speaks it answers "ook bin1"
+// and a server that agrees appends "bin1" to its "size" line. Older peers ignore
+// the extra word and both stay on the text exchange. In binary mode each side
+// streams its newest drone state as fixed NET_FRAME_BYTES frames as soon as it
+// has one, without acks; the receiver keeps the highest sequence number only.
+#define NET_PROTO_BINARY "bin1"
+#define NET_MAGIC 0xD0E2
+
+typedef enum {
+    NET_STATE = 1,  // A drone's state
+    NET_QUIT,       // The drone is leaving (0: the sender itself)
+    NET_ACK         // snap1: 'seq' is the newest snapshot tick the sender applied
+} NetFrameType;
+
+// On the wire, little-endian: magic u16, type u8, drone u8, seq u32, sent_ns u64,
+// then x, y, vx, vy as f32 in virtual coordinates (y up, like the text protocol).
+// 'drone' is 0 for the sender's own drone; a session host relays the other
+// peers' drones with their ids, seq and sent_ns untouched
+typedef struct {
+    uint8_t type;
+    uint8_t drone;
+    uint32_t seq;      // Per drone, +1 per frame
+    uint64_t sent_ns;  // Sender's CLOCK_MONOTONIC (comparable on one host)
+    float x, y, vx, vy;
+} NetStateFrame;
+
+// UDP TRANSPORT
+// Offered as "udp1" after bin1 ("ook bin1 udp1"). A host that agrees answers
+// "size w, h bin1 udp1 <token>", and the state stream moves to UDP on the same
+// port number; TCP keeps the handshake, quit frames and telling when a peer is
+// gone. A lost datagram never holds newer ones back. Every datagram repeats the
+// sender's last NET_UDP_REDUNDANCY states of its own drone, so one loss does not
+// cost a state; receivers keep the highest sequence number per drone as on TCP.
+// Datagram, little-endian: magic u16, count u8, reserved u8, token u32, then
+// 'count' NetStateFrames. The token picks the peer and guards against stray datagrams
+#define NET_PROTO_UDP "udp1"
+#define NET_UDP_MAGIC 0xD0E3
+#define NET_UDP_HEADER_BYTES 8
+#define NET_UDP_MAX_FRAMES 36 // 1160-byte datagrams stay under any path MTU
+#define NET_UDP_REDUNDANCY 3
+
+// DELTA SNAPSHOTS
+// Offered as "snap1" after bin1. The host then sends each peer the whole world
+// (every drone by wire id, but the peer's own) as one snapshot per fan-out
+// instead of a frame per drone. A snapshot names the newest one the peer acked
+// as its baseline and carries only the drones that differ from it; without a
+// usable baseline it carries all of them. The peer acks with a NET_ACK frame next
+// to its own state, and its own drone stays a bin1 frame.
+// Message, little-endian: magic u16, length u16 (whole message), tick u32,
+// baseline u32 (0 = none), then a bit stream, LSB first, of entries up to the
+// last byte's padding. An entry is the id (8) and removed (1); if not removed, a
+// position flag and a velocity flag (1 + 1), and for each flagged field a small
+// flag (1) and both components as NET_SNAP_DELTA_BITS signed deltas from the
+// baseline, or absolute.
+// Fields are fixed-point: positions in 1/NET_SNAP_POS_SCALE of a cell over
+// MAP_WIDTH x MAP_HEIGHT, velocities in 1/NET_SNAP_VEL_SCALE cell/s up to
+// +-NET_SNAP_VEL_MAX. A drone new to the peer is measured from zero.
+#define NET_PROTO_SNAPSHOT "snap1"
+#define NET_SNAP_MAGIC 0xD0E4
+#define NET_SNAP_HEADER_BYTES 12
+#define NET_SNAP_ENTITIES (NET_MAX_PEERS + 1)
+#define NET_SNAP_HISTORY 256   // Baselines kept; an older ack gets a full snapshot
+#define NET_SNAP_POS_SCALE 64
+#define NET_SNAP_VEL_SCALE 16
+#define NET_SNAP_VEL_MAX 64
+#define NET_SNAP_DELTA_BITS 7
+#define NET_SNAP_MAX_BYTES (NET_SNAP_HEADER_BYTES + NET_SNAP_ENTITIES * 8) // 64 bits bound an entry
+
+typedef struct {
+    uint16_t x, y;     // Fixed-point, virtual coordinates
+    int16_t vx, vy;
+} NetSnapEntity;
+
+typedef struct {
+    uint32_t tick;
+    uint8_t present[NET_SNAP_ENTITIES / 8];
+    NetSnapEntity entities[NET_SNAP_ENTITIES];
+} NetSnapshot;
+
+// LOGGING
+// log_msg() formats into a per-process lock-free ring and returns; a background
+// thread stamps the lines, folds runs of identical ones into "repeated N times"
+// and appends them to LOG_FILE, which is rotated by size.
+#define LOG_FILE "simulation.log"
+#define LOG_RING_SLOTS 2048          // Power of two; a full ring drops (and counts) messages
+#define LOG_NAME_MAX 16
+#define LOG_TEXT_MAX 232             // Longer messages are truncated
+#define LOG_FLUSH_MS 50              // Flusher period
+#define LOG_REPEAT_REPORT_MS 1000    // A run of identical lines is summarised at least this often
+#define LOG_ROTATE_BYTES (16u << 20) // simulation.log -> simulation.log.1 -> ... past this size
+#define LOG_ROTATE_KEEP 3
+
 void log_msg(const char *process_name, const char *format, ...);
+// Writes out everything logged so far; also runs at exit
+void log_flush(void);
+
+// Monotonic clock in nanoseconds
+uint64_t monotonic_ns(void);
+
+// RANDOM STREAMS
+// Every subsystem draws from its own PCG32 stream instead of the shared rand(), so
+// one seed reproduces a run and extra draws in one subsystem never shift another's.
+typedef struct {
+    uint64_t state;
+    uint64_t inc;   // Odd; picks the stream
+} Rng;
+
+typedef enum {
+    RNG_STREAM_OBSTACLES = 1,
+    RNG_STREAM_TARGETS,
+    RNG_STREAM_SWEEP      // Parameter draws of a sweep, one stream per episode above it
+} RngStream;
+
+void rng_seed(Rng *rng, uint64_t seed, uint64_t stream);
+uint32_t rng_next(Rng *rng);
+// Uniform in [0, bound)
+int rng_below(Rng *rng, int bound);
+// 'seed', or a different one on every call for runs that need not be reproducible
+uint64_t rng_seed_or_clock(uint64_t seed);
+
+// NETWORK FRAMES
+void net_frame_encode(const NetStateFrame *frame, uint8_t out[NET_FRAME_BYTES]);
+// Returns -1 if the bytes are not a frame (bad magic or type)
+int net_frame_decode(const uint8_t in[NET_FRAME_BYTES], NetStateFrame *frame);
+// Sequence number 'a' is newer than 'b' (wraps around)
+int net_seq_newer(uint32_t a, uint32_t b);
+void net_udp_header_encode(uint8_t out[NET_UDP_HEADER_BYTES], int count, uint32_t token);
+// Frames in a datagram of 'len' bytes (a snapshot may follow them), or -1 if it is not one of ours
+int net_udp_header_decode(const uint8_t *in, size_t len, uint32_t *token);
+
+// SNAPSHOT CODEC
+void net_snap_clear(NetSnapshot *snap, uint32_t tick);
+// Quantizes and stores drone 'id'; net_snap_get returns 0 if it is absent
+void net_snap_set(NetSnapshot *snap, int id, float x, float y, float vx, float vy);
+int net_snap_get(const NetSnapshot *snap, int id, float *x, float *y, float *vx, float *vy);
+// 'cur' against 'base' (NULL: everything), leaving drone 'skip' out (-1: none).
+// Writes at most NET_SNAP_MAX_BYTES; returns the length, *entries the drones in it
+int net_snap_encode(const NetSnapshot *cur, const NetSnapshot *base, int skip, uint8_t *out, int *entries);
+// Length of the message starting at 'in' (NET_SNAP_HEADER_BYTES of it needed),
+// or -1 if it is not a snapshot
+int net_snap_header(const uint8_t *in, uint32_t *tick, uint32_t *baseline);
+// Rebuilds the sender's snapshot from the message and its baseline ('base' must be
+// the one net_snap_header named, NULL for none); -1 if the message is malformed
+int net_snap_decode(const uint8_t *in, int len, const NetSnapshot *base, NetSnapshot *out);
+
+// WORLD STORAGE
+// One allocation for every entity array; returns 0 or -1
+int world_alloc(WorldState *world, int max_obstacles, int max_targets, int max_agents);
+void world_free(WorldState *world);
+// Replace the obstacle slots with 'incoming' (n entries, n = 0 clears them).
+// Only slots that spawned, expired or moved touch the grid.
+void world_set_obstacles(WorldState *world, const Obstacle *incoming, int n);
+
+// OBSTACLE GRID FUNCTIONS
+// Cell holding map point (x, y); points off the map go to the nearest edge cell
+int grid_cell(double x, double y);
+void grid_clear(ObstacleGrid *grid, int capacity);
+void grid_insert(ObstacleGrid *grid, int slot, double x, double y);
+void grid_remove(ObstacleGrid *grid, int slot);
+
+// FRAMING FUNCTIONS
+void frame_writer_init(FrameWriter *writer, int fd);
+// Header and payload go out in one writev(); returns 0 or -1 (errno set)
+int frame_send(FrameWriter *writer, uint16_t type, const void *payload, uint32_t length);
+
+// Reader buffer able to hold a burst of frames carrying up to 'max_payload' bytes each
+size_t frame_buffer_size(size_t max_payload);
+int frame_reader_init(FrameReader *reader, int fd, size_t capacity);
+void frame_reader_free(FrameReader *reader);
+// One read() into the free space: >0 bytes, 0 on EOF, -1 on error (EAGAIN = empty)
+ssize_t frame_fill(FrameReader *reader);
+// Next complete frame from the buffer: 1 and the payload pointer (valid until the
+// next frame_fill), or 0 if only a partial frame is buffered
+int frame_next(FrameReader *reader, FrameHeader *header, const void **payload);
+
+// LINK FUNCTIONS (FIFO or in-process ring)
+// Threaded build: 'path' becomes a ring of at least 'capacity' bytes; call it before
+// either end opens the link. Returns 0 or -1.
+int link_register(const char *path, size_t capacity);
+// open()/close() for a framed link: the ring end if 'path' was registered, the FIFO otherwise
+int link_open(const char *path, int flags);
+int link_close(int fd);
+// Subsystems started as threads of the threaded build (the server owns the signals there)
+void subsystem_mark_thread(void);
+int subsystem_is_thread(void);
+
+// SHARED BOARD FUNCTIONS
+// Server side: create/publish/close the segment
+SharedBoard *board_create(const char *suffix, int max_obstacles, int max_targets, int max_agents);
+void board_publish(SharedBoard *board, const WorldState *world);
+void board_close(SharedBoard *board);
+void board_destroy(SharedBoard *board, const char *suffix);
+
+// Reader side: attach, then read either in place (begin/retry) or as a copy (snapshot)
+SharedBoard *board_attach(const char *suffix);
+void board_detach(SharedBoard *board);
+uint32_t board_read_begin(SharedBoard *board);
+int board_read_retry(SharedBoard *board, uint32_t seq);
+// Copies the scalars and as many entities as 'out' has room for (none if it was never allocated)
+uint32_t board_snapshot(SharedBoard *board, WorldState *out);
+// Published entity arrays; the count is clamped to the capacity, so a torn read stays in bounds
+const Obstacle *board_obstacles(SharedBoard *board, int *count);
+const Target *board_targets(SharedBoard *board, int *count);
+const DroneState *board_agents(SharedBoard *board, int *count);
+const GridLink *board_grid_links(SharedBoard *board);
+// Column view; entries up to OBSTACLE_COLUMN_LEN(count) are valid (padding is inactive)
+ObstacleColumns board_columns(SharedBoard *board);
+// Sleeps until a frame newer than 'last_seq' is published (1) or the timeout expires (0)
+int board_wait_update(SharedBoard *board, uint32_t last_seq, int timeout_ms);
+
+// Startup handshake: a child reports ready once it can run; the server sleeps until
+// every bit of 'mask' is set (1) or the timeout expires (0)
+void board_set_ready(SharedBoard *board, Component component);
+int board_is_ready(SharedBoard *board, Component component);
+int board_wait_ready(SharedBoard *board, uint32_t mask, int timeout_ms);
+const char *component_name(Component component);
+
+// Heartbeats: start once with the loop's period, beat every iteration, stop on a
+// clean exit so the watchdog does not report it as a stall
+void heartbeat_start(SharedBoard *board, Component component, uint64_t period_ns);
+void heartbeat_beat(SharedBoard *board, Component component);
+void heartbeat_stop(SharedBoard *board, Component component);
 
 #endif
\ No newline at end of file
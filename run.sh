@@ -40,7 +40,10 @@ echo "  3. Networked - CLIENT (Join)"
 read -p "Enter choice [1-3]: " choice
 
 # GENERATE param.conf
-# We overwrite the file every time based on user input.
+# We overwrite the connection keys every time based on user input.
+
+# Keep tuning keys (TICK_HZ, ...) that were added to param.conf by hand
+EXTRA_CONF=$(grep -vE '^(#|MODE=|SERVER_IP=|PORT=)' param.conf 2>/dev/null)
 
 echo "# Auto-generated config by run.sh" > param.conf
 
@@ -87,6 +90,10 @@ else
     echo "[*] Starting in STANDALONE mode."
 fi
 
+if [ -n "$EXTRA_CONF" ]; then
+    echo "$EXTRA_CONF" >> param.conf
+fi
+
 # LAUNCH THE GAME
 # Using konsole as per your environment
 echo "[*] Launching Simulation..."
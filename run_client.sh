@@ -13,6 +13,9 @@ echo "========================================"
 # (Skipping make to avoid race conditions if server is running)
 
 # CONFIGURE CLIENT
+# Keep tuning keys (TICK_HZ, ...) that were added to param.conf by hand
+EXTRA_CONF=$(grep -vE '^(#|MODE=|SERVER_IP=|PORT=)' param.conf 2>/dev/null)
+
 echo "# Auto-generated config by run_client.sh" > param.conf
 echo "MODE=client" >> param.conf
 
@@ -29,6 +32,10 @@ fi
 echo "SERVER_IP=$user_ip" >> param.conf
 echo "PORT=$user_port" >> param.conf
 
+if [ -n "$EXTRA_CONF" ]; then
+    echo "$EXTRA_CONF" >> param.conf
+fi
+
 echo "[*] Launching Client..."
 # Launch in new terminal
 konsole -e ./server &